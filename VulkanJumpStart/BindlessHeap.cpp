@@ -0,0 +1,260 @@
+#include "BindlessHeap.h"
+
+#include <algorithm>
+#include <assert.h>
+
+uint32_t BindlessHeap::SlotAllocator::Allocate()
+{
+	uint32_t index;
+
+	if (!freeList.empty())
+	{
+		index = freeList.back();
+		freeList.pop_back();
+	}
+	else if (next < capacity)
+	{
+		index = next++;
+	}
+	else
+	{
+		throw std::runtime_error("Failed to allocate bindless slot, heap is full");
+	}
+
+	used++;
+	return index;
+}
+
+void BindlessHeap::SlotAllocator::Release(uint32_t index, uint64_t frame)
+{
+	assert(index < next);
+
+	pending.push_back({ index, frame });
+	used--;
+}
+
+void BindlessHeap::SlotAllocator::Recycle(uint64_t oldestKept)
+{
+	for (size_t i = 0; i < pending.size();)
+	{
+		if (pending[i].freedFrame < oldestKept)
+		{
+			freeList.push_back(pending[i].index);
+
+			pending[i] = pending.back();
+			pending.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+BindlessHeap::BindlessHeap()
+{
+}
+
+BindlessHeap::~BindlessHeap()
+{
+	Destroy();
+}
+
+bool BindlessHeap::IsSupported()
+{
+	const VkPhysicalDeviceDescriptorIndexingFeaturesEXT &features = Vulkan.descriptorIndexingFeatures;
+
+	return features.sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT
+		&& features.runtimeDescriptorArray
+		&& features.descriptorBindingPartiallyBound
+		&& features.descriptorBindingUpdateUnusedWhilePending
+		&& features.descriptorBindingSampledImageUpdateAfterBind
+		&& features.descriptorBindingStorageBufferUpdateAfterBind
+		&& features.shaderSampledImageArrayNonUniformIndexing
+		&& features.shaderStorageBufferArrayNonUniformIndexing;
+}
+
+void BindlessHeap::Create(uint32_t maxTextures, uint32_t maxBuffers, uint32_t frameCount)
+{
+	assert(IsSupported());
+	assert(frameCount > 0);
+
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+	indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+	indexingProperties.pNext = nullptr;
+
+	VkPhysicalDeviceProperties2KHR properties = {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+	properties.pNext = &indexingProperties;
+	vkGetPhysicalDeviceProperties2KHR(Vulkan.physicalDevice, &properties);
+
+	// a combined image sampler counts against both the sampler and the sampled image limits
+	maxTextures = std::min(maxTextures, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages);
+	maxTextures = std::min(maxTextures, indexingProperties.maxDescriptorSetUpdateAfterBindSamplers);
+	maxTextures = std::min(maxTextures, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+	maxTextures = std::min(maxTextures, indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers);
+	maxBuffers = std::min(maxBuffers, indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers);
+	maxBuffers = std::min(maxBuffers, indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+
+	// both arrays share the per-stage and pool-wide budgets, buffers get theirs first
+	uint32_t resourceLimit = std::min(indexingProperties.maxPerStageUpdateAfterBindResources, indexingProperties.maxUpdateAfterBindDescriptorsInAllPools);
+	maxBuffers = std::min(maxBuffers, resourceLimit);
+	maxTextures = std::min(maxTextures, resourceLimit - maxBuffers);
+
+	this->frameCount = frameCount;
+	this->frameNumber = 0;
+	textures = SlotAllocator();
+	textures.capacity = maxTextures;
+	buffers = SlotAllocator();
+	buffers.capacity = maxBuffers;
+
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = TextureBinding;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = maxTextures;
+	bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+	bindings[0].pImmutableSamplers = nullptr;
+	bindings[1].binding = BufferBinding;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = maxBuffers;
+	bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+	bindings[1].pImmutableSamplers = nullptr;
+
+	// unused slots may hold stale or no descriptors, and slots can be written while the set is bound
+	VkDescriptorBindingFlagsEXT bindingFlags[2];
+	bindingFlags[0] = bindingFlags[1] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
+		| VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+		| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	bindingFlagsInfo.pNext = nullptr;
+	bindingFlagsInfo.bindingCount = 2;
+	bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	layoutInfo.bindingCount = 2;
+	layoutInfo.pBindings = bindings;
+
+	if (vkCreateDescriptorSetLayout(Vulkan.device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create bindless descriptor set layout");
+
+	VkDescriptorPoolSize poolSizes[2];
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = maxTextures;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = maxBuffers;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+
+	if (vkCreateDescriptorPool(Vulkan.device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create bindless descriptor pool");
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.pNext = nullptr;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	if (vkAllocateDescriptorSets(Vulkan.device, &allocInfo, &set) != VK_SUCCESS)
+		throw std::runtime_error("Failed to allocate bindless descriptor set");
+}
+
+void BindlessHeap::Destroy()
+{
+	if (pool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(Vulkan.device, pool, nullptr);
+
+	if (layout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(Vulkan.device, layout, nullptr);
+
+	pool = VK_NULL_HANDLE;
+	layout = VK_NULL_HANDLE;
+	set = VK_NULL_HANDLE;
+}
+
+uint32_t BindlessHeap::AddTexture(VkSampler sampler, VkImageView view, VkImageLayout layout)
+{
+	VkDescriptorImageInfo info = {};
+	info.sampler = sampler;
+	info.imageView = view;
+	info.imageLayout = layout;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint32_t index = textures.Allocate();
+	Write(TextureBinding, index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &info, nullptr);
+	return index;
+}
+
+uint32_t BindlessHeap::AddBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo info = {};
+	info.buffer = buffer;
+	info.offset = offset;
+	info.range = range;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint32_t index = buffers.Allocate();
+	Write(BufferBinding, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &info);
+	return index;
+}
+
+void BindlessHeap::RemoveTexture(uint32_t index)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	textures.Release(index, frameNumber);
+}
+
+void BindlessHeap::RemoveBuffer(uint32_t index)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	buffers.Release(index, frameNumber);
+}
+
+void BindlessHeap::BeginFrame()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	frameNumber++;
+
+	if (frameNumber <= frameCount)
+		return;
+
+	uint64_t oldestKept = frameNumber - frameCount;
+	textures.Recycle(oldestKept);
+	buffers.Recycle(oldestKept);
+}
+
+void BindlessHeap::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t setIndex) const
+{
+	vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, setIndex, 1, &set, 0, nullptr);
+}
+
+void BindlessHeap::Write(uint32_t binding, uint32_t index, VkDescriptorType type, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo)
+{
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.pNext = nullptr;
+	write.dstSet = set;
+	write.dstBinding = binding;
+	write.dstArrayElement = index;
+	write.descriptorCount = 1;
+	write.descriptorType = type;
+	write.pImageInfo = imageInfo;
+	write.pBufferInfo = bufferInfo;
+	write.pTexelBufferView = nullptr;
+
+	vkUpdateDescriptorSets(Vulkan.device, 1, &write, 0, nullptr);
+}
\ No newline at end of file
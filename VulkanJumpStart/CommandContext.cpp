@@ -0,0 +1,194 @@
+#include "CommandContext.h"
+
+#include <assert.h>
+
+CommandContext::CommandContext()
+{
+}
+
+CommandContext::~CommandContext()
+{
+	Destroy();
+}
+
+void CommandContext::Create(uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t threadCount)
+{
+	assert(frameCount > 0 && threadCount > 0);
+
+	this->frameCount = frameCount;
+	this->threadCount = threadCount;
+	this->frameIndex = 0;
+
+	pools.resize(frameCount * threadCount);
+
+	VkCommandPoolCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	createInfo.queueFamilyIndex = queueFamilyIndex;
+
+	for (ThreadPool &pool : pools)
+	{
+		if (vkCreateCommandPool(Vulkan.device, &createInfo, nullptr, &pool.pool) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create command pool");
+	}
+}
+
+void CommandContext::Destroy()
+{
+	for (ThreadPool &pool : pools)
+	{
+		// destroying the pool frees every buffer allocated from it
+		if (pool.pool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(Vulkan.device, pool.pool, nullptr);
+	}
+
+	pools.clear();
+}
+
+void CommandContext::BeginFrame(uint32_t frameIndex)
+{
+	assert(frameIndex < frameCount);
+
+	this->frameIndex = frameIndex;
+
+	frameStats.frameIssued = recorderStats.issued.exchange(0, std::memory_order_relaxed);
+	frameStats.frameFiltered = recorderStats.filtered.exchange(0, std::memory_order_relaxed);
+	frameStats.totalIssued += frameStats.frameIssued;
+	frameStats.totalFiltered += frameStats.frameFiltered;
+	frameStats.frames++;
+
+	for (uint32_t thread = 0; thread < threadCount; thread++)
+	{
+		ThreadPool &pool = GetPool(thread);
+
+		if (vkResetCommandPool(Vulkan.device, pool.pool, 0) != VK_SUCCESS)
+			throw std::runtime_error("Failed to reset command pool");
+
+		pool.primaryCursor = 0;
+		pool.secondaryCursor = 0;
+	}
+}
+
+VkCommandBuffer CommandContext::BeginPrimary(uint32_t threadIndex)
+{
+	VkCommandBuffer commandBuffer = Acquire(GetPool(threadIndex), VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.pNext = nullptr;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = nullptr;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("Failed to begin primary command buffer");
+
+	return commandBuffer;
+}
+
+VkCommandBuffer CommandContext::BeginSecondary(uint32_t threadIndex, const VkCommandBufferInheritanceInfo &inheritance)
+{
+	VkCommandBuffer commandBuffer = Acquire(GetPool(threadIndex), VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.pNext = nullptr;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritance;
+
+	if (inheritance.renderPass != VK_NULL_HANDLE)
+		beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("Failed to begin secondary command buffer");
+
+	return commandBuffer;
+}
+
+void CommandContext::RecordParallel(JobSystem &jobSystem, VkCommandBuffer primary, const VkCommandBufferInheritanceInfo &inheritance, const std::vector<RecordFunc> &tasks,
+	const VkExtent2D* viewportExtent)
+{
+	assert(jobSystem.GetWorkerCount() == threadCount);
+
+	if (tasks.empty())
+		return;
+
+	// contiguous task ranges per batch keep the stitched order identical to the task order
+	uint32_t taskCount = (uint32_t)tasks.size();
+	uint32_t batchSize = (taskCount + threadCount - 1) / threadCount;
+	uint32_t batchCount = (taskCount + batchSize - 1) / batchSize;
+
+	std::vector<VkCommandBuffer> secondaries(batchCount, VK_NULL_HANDLE);
+
+	JobCounter counter;
+	jobSystem.ParallelFor(taskCount, batchSize, [&](uint32_t first, uint32_t last)
+	{
+		VkCommandBuffer commandBuffer = BeginSecondary(JobSystem::GetWorkerIndex(), inheritance);
+
+		CommandRecorder recorder(commandBuffer, &recorderStats);
+
+		if (viewportExtent)
+		{
+			VkViewport viewport = { 0.0f, 0.0f, (float)viewportExtent->width, (float)viewportExtent->height, 0.0f, 1.0f };
+			VkRect2D scissor = { { 0, 0 }, *viewportExtent };
+
+			recorder.SetViewport(0, 1, &viewport);
+			recorder.SetScissor(0, 1, &scissor);
+		}
+
+		for (uint32_t task = first; task < last; task++)
+			tasks[task](recorder);
+
+		recorder.Flush();
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to end secondary command buffer");
+
+		secondaries[first / batchSize] = commandBuffer;
+	}, &counter);
+
+	jobSystem.WaitForCounter(&counter);
+
+	vkCmdExecuteCommands(primary, batchCount, secondaries.data());
+}
+
+void CommandContext::PrintStats(std::ostream &stream) const
+{
+	uint64_t frames = frameStats.frames > 0 ? frameStats.frames : 1;
+
+	stream << "command recorder: last frame " << frameStats.frameIssued << " calls"
+		<< ", " << frameStats.frameFiltered << " filtered"
+		<< ", average per frame " << frameStats.totalIssued / frames << " calls"
+		<< ", " << frameStats.totalFiltered / frames << " filtered" << std::endl;
+}
+
+CommandContext::ThreadPool& CommandContext::GetPool(uint32_t threadIndex)
+{
+	assert(threadIndex < threadCount);
+	return pools[frameIndex * threadCount + threadIndex];
+}
+
+VkCommandBuffer CommandContext::Acquire(ThreadPool &pool, VkCommandBufferLevel level)
+{
+	std::vector<VkCommandBuffer> &buffers = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? pool.primaries : pool.secondaries;
+	uint32_t &cursor = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? pool.primaryCursor : pool.secondaryCursor;
+
+	// buffers survive the pool reset, so they are only allocated the first time a slot runs dry
+	if (cursor == buffers.size())
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.pNext = nullptr;
+		allocInfo.commandPool = pool.pool;
+		allocInfo.level = level;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(Vulkan.device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate command buffer");
+
+		buffers.push_back(commandBuffer);
+	}
+
+	return buffers[cursor++];
+}
\ No newline at end of file
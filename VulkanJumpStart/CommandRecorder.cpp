@@ -0,0 +1,325 @@
+#include "CommandRecorder.h"
+
+#include <algorithm>
+#include <assert.h>
+
+static uint64_t PushConstantWordMask(uint32_t offset, uint32_t size)
+{
+	uint32_t firstWord = offset / 4;
+	uint32_t wordCount = (size + 3) / 4;
+
+	uint64_t mask = wordCount == 64 ? ~0ull : ((1ull << wordCount) - 1);
+	return mask << firstWord;
+}
+
+CommandRecorder::CommandRecorder(VkCommandBuffer commandBuffer, CommandRecorderStats* stats)
+	: commandBuffer(commandBuffer), stats(stats)
+{
+	Invalidate();
+}
+
+CommandRecorder::~CommandRecorder()
+{
+	Flush();
+}
+
+void CommandRecorder::BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline, VkPipelineLayout layout, bool dynamicViewportScissor)
+{
+	BindPointState &state = bindPoints[bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0];
+
+	if (state.pipeline == pipeline)
+	{
+		filtered++;
+		return;
+	}
+
+	vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
+	issued++;
+
+	state.pipeline = pipeline;
+	SwitchPushLayout(layout);
+
+	if (bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS && !dynamicViewportScissor)
+	{
+		viewportCount = 0;
+		scissorCount = 0;
+	}
+}
+
+void CommandRecorder::BindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount, const VkDescriptorSet* sets, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets)
+{
+	BindPointState &state = bindPoints[bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0];
+
+	SwitchPushLayout(layout);
+
+	// out of what is shadowed, pass through and forget what the call may have disturbed
+	if (firstSet + setCount > MaxDescriptorSets || dynamicOffsetCount > MaxDynamicOffsets)
+	{
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+		issued++;
+
+		memset(state.sets, 0, sizeof(state.sets));
+		state.layout = VK_NULL_HANDLE;
+		return;
+	}
+
+	// another layout may disturb sets outside the call, only known state under the same layout is kept
+	if (state.layout != layout)
+	{
+		memset(state.sets, 0, sizeof(state.sets));
+		state.layout = layout;
+	}
+
+	// dynamic offsets cannot be split between sets without the layout, so only single sets compare them
+	uint32_t setDynamicOffsetCount = setCount == 1 ? dynamicOffsetCount : (dynamicOffsetCount > 0 ? UINT32_MAX : 0);
+
+	uint32_t firstChanged = setCount;
+	uint32_t lastChanged = 0;
+
+	for (uint32_t i = 0; i < setCount; i++)
+	{
+		const BoundSet &bound = state.sets[firstSet + i];
+
+		bool same = bound.set == sets[i]
+			&& bound.dynamicOffsetCount == setDynamicOffsetCount
+			&& (setDynamicOffsetCount != UINT32_MAX)
+			&& (setDynamicOffsetCount == 0 || !memcmp(bound.dynamicOffsets, dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t)));
+
+		if (!same)
+		{
+			firstChanged = std::min(firstChanged, i);
+			lastChanged = i;
+		}
+	}
+
+	if (firstChanged == setCount)
+	{
+		filtered++;
+		return;
+	}
+
+	// without dynamic offsets unchanged sets at either end can be trimmed off the call
+	if (dynamicOffsetCount == 0)
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet + firstChanged, lastChanged - firstChanged + 1, sets + firstChanged, 0, nullptr);
+	else
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+
+	issued++;
+
+	for (uint32_t i = 0; i < setCount; i++)
+	{
+		BoundSet &bound = state.sets[firstSet + i];
+
+		bound.set = sets[i];
+		bound.dynamicOffsetCount = setDynamicOffsetCount;
+
+		if (setDynamicOffsetCount != UINT32_MAX && setDynamicOffsetCount > 0)
+			memcpy(bound.dynamicOffsets, dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t));
+	}
+}
+
+void CommandRecorder::BindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets)
+{
+	if (firstBinding + bindingCount > MaxVertexBindings)
+	{
+		vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, buffers, offsets);
+		issued++;
+
+		for (uint32_t binding = firstBinding; binding < MaxVertexBindings; binding++)
+			vertexBuffers[binding] = VK_NULL_HANDLE;
+
+		return;
+	}
+
+	uint32_t firstChanged = bindingCount;
+	uint32_t lastChanged = 0;
+
+	for (uint32_t i = 0; i < bindingCount; i++)
+	{
+		if (vertexBuffers[firstBinding + i] != buffers[i] || vertexOffsets[firstBinding + i] != offsets[i])
+		{
+			firstChanged = std::min(firstChanged, i);
+			lastChanged = i;
+		}
+	}
+
+	if (firstChanged == bindingCount)
+	{
+		filtered++;
+		return;
+	}
+
+	vkCmdBindVertexBuffers(commandBuffer, firstBinding + firstChanged, lastChanged - firstChanged + 1, buffers + firstChanged, offsets + firstChanged);
+	issued++;
+
+	for (uint32_t i = firstChanged; i <= lastChanged; i++)
+	{
+		vertexBuffers[firstBinding + i] = buffers[i];
+		vertexOffsets[firstBinding + i] = offsets[i];
+	}
+}
+
+void CommandRecorder::BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+	if (indexBuffer == buffer && indexOffset == offset && this->indexType == indexType)
+	{
+		filtered++;
+		return;
+	}
+
+	vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+	issued++;
+
+	indexBuffer = buffer;
+	indexOffset = offset;
+	this->indexType = indexType;
+}
+
+void CommandRecorder::SetViewport(uint32_t firstViewport, uint32_t viewportCount, const VkViewport* viewports)
+{
+	if (firstViewport + viewportCount <= this->viewportCount
+		&& !memcmp(&this->viewports[firstViewport], viewports, viewportCount * sizeof(VkViewport)))
+	{
+		filtered++;
+		return;
+	}
+
+	vkCmdSetViewport(commandBuffer, firstViewport, viewportCount, viewports);
+	issued++;
+
+	// only a run of known viewports from index 0 is shadowed
+	if (firstViewport <= this->viewportCount && firstViewport + viewportCount <= MaxViewports)
+	{
+		memcpy(&this->viewports[firstViewport], viewports, viewportCount * sizeof(VkViewport));
+		this->viewportCount = std::max(this->viewportCount, firstViewport + viewportCount);
+	}
+	else
+	{
+		this->viewportCount = std::min(this->viewportCount, firstViewport);
+	}
+}
+
+void CommandRecorder::SetScissor(uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* scissors)
+{
+	if (firstScissor + scissorCount <= this->scissorCount
+		&& !memcmp(&this->scissors[firstScissor], scissors, scissorCount * sizeof(VkRect2D)))
+	{
+		filtered++;
+		return;
+	}
+
+	vkCmdSetScissor(commandBuffer, firstScissor, scissorCount, scissors);
+	issued++;
+
+	if (firstScissor <= this->scissorCount && firstScissor + scissorCount <= MaxViewports)
+	{
+		memcpy(&this->scissors[firstScissor], scissors, scissorCount * sizeof(VkRect2D));
+		this->scissorCount = std::max(this->scissorCount, firstScissor + scissorCount);
+	}
+	else
+	{
+		this->scissorCount = std::min(this->scissorCount, firstScissor);
+	}
+}
+
+void CommandRecorder::PushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values)
+{
+	assert(offset % 4 == 0 && size % 4 == 0);
+
+	if (offset + size > MaxPushConstantSize)
+	{
+		vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, values);
+		issued++;
+
+		pushStageCount = 0;
+		return;
+	}
+
+	SwitchPushLayout(layout);
+
+	uint64_t mask = PushConstantWordMask(offset, size);
+
+	PushConstantStages* stages = nullptr;
+	for (uint32_t i = 0; i < pushStageCount; i++)
+	{
+		if (pushStages[i].stageFlags == stageFlags)
+			stages = &pushStages[i];
+	}
+
+	if (stages && (stages->knownWords & mask) == mask && !memcmp(pushData + offset, values, size))
+	{
+		filtered++;
+		return;
+	}
+
+	vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, values);
+	issued++;
+
+	memcpy(pushData + offset, values, size);
+
+	// the bytes just written belong to these stages now, other stage sets lose them
+	for (uint32_t i = 0; i < pushStageCount; i++)
+		pushStages[i].knownWords &= ~mask;
+
+	if (!stages && pushStageCount < MaxPushConstantRanges)
+	{
+		stages = &pushStages[pushStageCount++];
+		stages->stageFlags = stageFlags;
+		stages->knownWords = 0;
+	}
+
+	if (stages)
+		stages->knownWords |= mask;
+}
+
+void CommandRecorder::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+	vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+void CommandRecorder::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+	vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+}
+
+void CommandRecorder::Invalidate()
+{
+	memset(bindPoints, 0, sizeof(bindPoints));
+
+	for (uint32_t i = 0; i < MaxVertexBindings; i++)
+	{
+		vertexBuffers[i] = VK_NULL_HANDLE;
+		vertexOffsets[i] = 0;
+	}
+
+	indexBuffer = VK_NULL_HANDLE;
+	indexOffset = 0;
+	indexType = VK_INDEX_TYPE_UINT16;
+
+	viewportCount = 0;
+	scissorCount = 0;
+
+	pushLayout = VK_NULL_HANDLE;
+	pushStageCount = 0;
+}
+
+void CommandRecorder::SwitchPushLayout(VkPipelineLayout layout)
+{
+	if (pushLayout != layout)
+	{
+		pushLayout = layout;
+		pushStageCount = 0;
+	}
+}
+
+void CommandRecorder::Flush()
+{
+	if (stats)
+	{
+		stats->issued.fetch_add(issued, std::memory_order_relaxed);
+		stats->filtered.fetch_add(filtered, std::memory_order_relaxed);
+	}
+
+	issued = 0;
+	filtered = 0;
+}
\ No newline at end of file
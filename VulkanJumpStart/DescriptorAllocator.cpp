@@ -0,0 +1,231 @@
+#include "DescriptorAllocator.h"
+
+#include <assert.h>
+
+DescriptorAllocator::DescriptorAllocator()
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	Destroy();
+}
+
+void DescriptorAllocator::Create(uint32_t frameCount, uint32_t threadCount, VkDescriptorPoolCreateFlags poolFlags)
+{
+	assert(frameCount > 0 && threadCount > 0);
+
+	this->frameCount = frameCount;
+	this->threadCount = threadCount;
+	this->frameIndex = 0;
+	this->poolFlags = poolFlags;
+
+	chains.resize(frameCount * threadCount);
+}
+
+void DescriptorAllocator::Destroy()
+{
+	for (std::vector<PoolChain> &classChains : chains)
+	{
+		for (PoolChain &chain : classChains)
+		{
+			for (Pool &pool : chain.pools)
+				vkDestroyDescriptorPool(Vulkan.device, pool.pool, nullptr);
+		}
+	}
+
+	chains.clear();
+	layoutClasses.clear();
+}
+
+uint32_t DescriptorAllocator::RegisterLayoutClass(const std::vector<VkDescriptorPoolSize> &descriptorsPerSet)
+{
+	layoutClasses.push_back(descriptorsPerSet);
+
+	for (std::vector<PoolChain> &classChains : chains)
+		classChains.resize(layoutClasses.size());
+
+	return (uint32_t)layoutClasses.size() - 1;
+}
+
+void DescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+	assert(frameIndex < frameCount);
+
+	this->frameIndex = frameIndex;
+
+	for (uint32_t thread = 0; thread < threadCount; thread++)
+	{
+		for (PoolChain &chain : chains[frameIndex * threadCount + thread])
+		{
+			for (Pool &pool : chain.pools)
+			{
+				if (pool.allocatedSets == 0)
+					continue;
+
+				if (vkResetDescriptorPool(Vulkan.device, pool.pool, 0) != VK_SUCCESS)
+					throw std::runtime_error("Failed to reset descriptor pool");
+
+				pool.allocatedSets = 0;
+			}
+
+			chain.current = 0;
+			chain.frameAllocations = 0;
+		}
+	}
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(uint32_t threadIndex, uint32_t layoutClass, VkDescriptorSetLayout layout, VkDescriptorPool* sourcePool)
+{
+	PoolChain &chain = GetChain(frameIndex, threadIndex, layoutClass);
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.pNext = nullptr;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	while (true)
+	{
+		if (chain.current == chain.pools.size())
+		{
+			// each new pool doubles the previous one, a chain that keeps growing settles quickly
+			uint32_t maxSets = chain.pools.empty() ? InitialSetsPerPool : chain.pools.back().maxSets * 2;
+			if (maxSets > MaxSetsPerPool)
+				maxSets = MaxSetsPerPool;
+
+			chain.pools.push_back(CreatePool(layoutClass, maxSets));
+		}
+
+		Pool &pool = chain.pools[chain.current];
+		allocInfo.descriptorPool = pool.pool;
+
+		VkDescriptorSet set;
+		VkResult result = pool.allocatedSets < pool.maxSets
+			? vkAllocateDescriptorSets(Vulkan.device, &allocInfo, &set)
+			: VK_ERROR_OUT_OF_POOL_MEMORY_KHR;
+
+		if (result == VK_SUCCESS)
+		{
+			pool.allocatedSets++;
+			chain.frameAllocations++;
+			chain.totalAllocations++;
+
+			if (sourcePool)
+				*sourcePool = pool.pool;
+
+			return set;
+		}
+
+		if (result != VK_ERROR_OUT_OF_POOL_MEMORY_KHR && result != VK_ERROR_FRAGMENTED_POOL)
+			throw std::runtime_error("Failed to allocate descriptor set");
+
+		// a fresh pool that cannot fit a single set means the layout does not match its class
+		if (pool.allocatedSets == 0)
+			throw std::runtime_error("Descriptor set layout exceeds its layout class");
+
+		chain.current++;
+	}
+}
+
+void DescriptorAllocator::Free(uint32_t threadIndex, uint32_t layoutClass, VkDescriptorPool pool, VkDescriptorSet set)
+{
+	assert(poolFlags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+
+	PoolChain &chain = GetChain(frameIndex, threadIndex, layoutClass);
+
+	for (uint32_t i = 0; i < chain.pools.size(); i++)
+	{
+		if (chain.pools[i].pool != pool)
+			continue;
+
+		if (vkFreeDescriptorSets(Vulkan.device, pool, 1, &set) != VK_SUCCESS)
+			throw std::runtime_error("Failed to free descriptor set");
+
+		chain.pools[i].allocatedSets--;
+
+		// let the next allocation retry the pool that just regained space
+		if (i < chain.current)
+			chain.current = i;
+
+		return;
+	}
+
+	assert(!"Descriptor pool does not belong to this chain");
+}
+
+DescriptorAllocator::ClassStats DescriptorAllocator::GetStats(uint32_t layoutClass) const
+{
+	ClassStats stats;
+
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		for (uint32_t thread = 0; thread < threadCount; thread++)
+		{
+			const PoolChain &chain = GetChain(frame, thread, layoutClass);
+
+			if (frame == frameIndex)
+				stats.frameAllocations += chain.frameAllocations;
+
+			stats.totalAllocations += chain.totalAllocations;
+			stats.poolCount += (uint32_t)chain.pools.size();
+
+			for (const Pool &pool : chain.pools)
+			{
+				stats.setsAllocated += pool.allocatedSets;
+				stats.setCapacity += pool.maxSets;
+			}
+		}
+	}
+
+	return stats;
+}
+
+void DescriptorAllocator::PrintStats(std::ostream &stream) const
+{
+	for (uint32_t layoutClass = 0; layoutClass < layoutClasses.size(); layoutClass++)
+	{
+		ClassStats stats = GetStats(layoutClass);
+
+		stream << "descriptor class " << layoutClass
+			<< ": frame allocations " << stats.frameAllocations
+			<< ", total " << stats.totalAllocations
+			<< ", pools " << stats.poolCount
+			<< ", occupancy " << stats.setsAllocated << "/" << stats.setCapacity << std::endl;
+	}
+}
+
+DescriptorAllocator::PoolChain& DescriptorAllocator::GetChain(uint32_t frame, uint32_t thread, uint32_t layoutClass)
+{
+	assert(frame < frameCount && thread < threadCount && layoutClass < layoutClasses.size());
+	return chains[frame * threadCount + thread][layoutClass];
+}
+
+const DescriptorAllocator::PoolChain& DescriptorAllocator::GetChain(uint32_t frame, uint32_t thread, uint32_t layoutClass) const
+{
+	assert(frame < frameCount && thread < threadCount && layoutClass < layoutClasses.size());
+	return chains[frame * threadCount + thread][layoutClass];
+}
+
+DescriptorAllocator::Pool DescriptorAllocator::CreatePool(uint32_t layoutClass, uint32_t maxSets)
+{
+	std::vector<VkDescriptorPoolSize> sizes = layoutClasses[layoutClass];
+	for (VkDescriptorPoolSize &size : sizes)
+		size.descriptorCount *= maxSets;
+
+	VkDescriptorPoolCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = poolFlags;
+	createInfo.maxSets = maxSets;
+	createInfo.poolSizeCount = (uint32_t)sizes.size();
+	createInfo.pPoolSizes = sizes.data();
+
+	Pool pool;
+	pool.maxSets = maxSets;
+
+	if (vkCreateDescriptorPool(Vulkan.device, &createInfo, nullptr, &pool.pool) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create descriptor pool");
+
+	return pool;
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "DescriptorBinder.h"
+
+#include <assert.h>
+
+// each binding call reuses its thread's scratch writes instead of allocating
+static thread_local std::vector<VkWriteDescriptorSet> writeScratch;
+
+static bool IsImageDescriptor(VkDescriptorType type)
+{
+	switch (type)
+	{
+	case VK_DESCRIPTOR_TYPE_SAMPLER:
+	case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+	case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+	case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+	case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool IsTexelBufferDescriptor(VkDescriptorType type)
+{
+	return type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER || type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+}
+
+DescriptorBinder::DescriptorBinder()
+{
+}
+
+DescriptorBinder::~DescriptorBinder()
+{
+	Destroy();
+}
+
+void DescriptorBinder::Create(DescriptorAllocator* allocator)
+{
+	assert(allocator != nullptr);
+
+	this->allocator = allocator;
+
+	hasTemplates = vkfwIsDeviceExtensionEnabled(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+	hasPush = vkfwIsDeviceExtensionEnabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+	maxPushDescriptors = 0;
+
+	if (hasPush)
+	{
+		VkPhysicalDevicePushDescriptorPropertiesKHR pushProperties = {};
+		pushProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+		pushProperties.pNext = nullptr;
+
+		VkPhysicalDeviceProperties2KHR properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+		properties.pNext = &pushProperties;
+		vkGetPhysicalDeviceProperties2KHR(Vulkan.physicalDevice, &properties);
+
+		maxPushDescriptors = pushProperties.maxPushDescriptors;
+	}
+}
+
+void DescriptorBinder::Destroy()
+{
+	for (Layout &layout : layouts)
+	{
+		if (layout.updateTemplate != VK_NULL_HANDLE)
+			vkDestroyDescriptorUpdateTemplateKHR(Vulkan.device, layout.updateTemplate, nullptr);
+
+		vkDestroyDescriptorSetLayout(Vulkan.device, layout.setLayout, nullptr);
+	}
+
+	layouts.clear();
+}
+
+const char* DescriptorBinder::GetStrategyName(Strategy strategy)
+{
+	switch (strategy)
+	{
+	case StrategyWrites: return "descriptor writes";
+	case StrategyTemplate: return "update template";
+	case StrategyPush: return "push descriptors";
+	case StrategyPushTemplate: return "push template";
+	default: return "unknown";
+	}
+}
+
+bool DescriptorBinder::IsStrategySupported(Strategy strategy) const
+{
+	switch (strategy)
+	{
+	case StrategyWrites: return true;
+	case StrategyTemplate: return hasTemplates;
+	case StrategyPush: return hasPush;
+	case StrategyPushTemplate: return hasPush && hasTemplates;
+	default: return false;
+	}
+}
+
+uint32_t DescriptorBinder::CreateLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings, Strategy preferred)
+{
+	Layout layout;
+	layout.bindings = bindings;
+
+	for (const VkDescriptorSetLayoutBinding &binding : bindings)
+	{
+		assert(binding.pImmutableSamplers == nullptr);
+		layout.descriptorCount += binding.descriptorCount;
+	}
+
+	// walk down from the preferred strategy, push layouts are also bound by the device's push limit
+	int strategy = preferred;
+	for (; strategy > StrategyWrites; strategy--)
+	{
+		bool isPush = strategy == StrategyPush || strategy == StrategyPushTemplate;
+
+		if (IsStrategySupported((Strategy)strategy) && (!isPush || layout.descriptorCount <= maxPushDescriptors))
+			break;
+	}
+
+	layout.strategy = (Strategy)strategy;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = nullptr;
+	layoutInfo.flags = layout.strategy >= StrategyPush ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
+	layoutInfo.bindingCount = (uint32_t)bindings.size();
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(Vulkan.device, &layoutInfo, nullptr, &layout.setLayout) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create descriptor set layout");
+
+	if (layout.strategy < StrategyPush)
+	{
+		std::vector<VkDescriptorPoolSize> sizes;
+
+		for (const VkDescriptorSetLayoutBinding &binding : bindings)
+		{
+			bool merged = false;
+
+			for (VkDescriptorPoolSize &size : sizes)
+			{
+				if (size.type == binding.descriptorType)
+				{
+					size.descriptorCount += binding.descriptorCount;
+					merged = true;
+					break;
+				}
+			}
+
+			if (!merged)
+				sizes.push_back({ binding.descriptorType, binding.descriptorCount });
+		}
+
+		layout.layoutClass = allocator->RegisterLayoutClass(sizes);
+	}
+
+	layouts.push_back(std::move(layout));
+	return (uint32_t)layouts.size() - 1;
+}
+
+void DescriptorBinder::CreateUpdateTemplate(uint32_t layoutId, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set)
+{
+	Layout &layout = layouts[layoutId];
+
+	if (layout.strategy != StrategyTemplate && layout.strategy != StrategyPushTemplate)
+		return;
+
+	if (layout.updateTemplate != VK_NULL_HANDLE)
+		return;
+
+	// every binding reads a run of consecutive DescriptorInfo elements
+	std::vector<VkDescriptorUpdateTemplateEntryKHR> entries(layout.bindings.size());
+	size_t offset = 0;
+
+	for (size_t i = 0; i < layout.bindings.size(); i++)
+	{
+		const VkDescriptorSetLayoutBinding &binding = layout.bindings[i];
+
+		entries[i].dstBinding = binding.binding;
+		entries[i].dstArrayElement = 0;
+		entries[i].descriptorCount = binding.descriptorCount;
+		entries[i].descriptorType = binding.descriptorType;
+		entries[i].offset = offset;
+		entries[i].stride = sizeof(DescriptorInfo);
+
+		offset += binding.descriptorCount * sizeof(DescriptorInfo);
+	}
+
+	VkDescriptorUpdateTemplateCreateInfoKHR createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.descriptorUpdateEntryCount = (uint32_t)entries.size();
+	createInfo.pDescriptorUpdateEntries = entries.data();
+	createInfo.descriptorSetLayout = layout.setLayout;
+	createInfo.pipelineBindPoint = bindPoint;
+	createInfo.pipelineLayout = pipelineLayout;
+	createInfo.set = set;
+	createInfo.templateType = layout.strategy == StrategyPushTemplate
+		? VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR
+		: VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+
+	if (vkCreateDescriptorUpdateTemplateKHR(Vulkan.device, &createInfo, nullptr, &layout.updateTemplate) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create descriptor update template");
+}
+
+void DescriptorBinder::Bind(VkCommandBuffer commandBuffer, uint32_t threadIndex, uint32_t layoutId, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set, const DescriptorInfo* data)
+{
+	const Layout &layout = layouts[layoutId];
+
+	switch (layout.strategy)
+	{
+	case StrategyPushTemplate:
+	{
+		assert(layout.updateTemplate != VK_NULL_HANDLE);
+		vkCmdPushDescriptorSetWithTemplateKHR(commandBuffer, layout.updateTemplate, pipelineLayout, set, data);
+		break;
+	}
+	case StrategyPush:
+	{
+		uint32_t writeCount = BuildWrites(layout, VK_NULL_HANDLE, data);
+		vkCmdPushDescriptorSetKHR(commandBuffer, bindPoint, pipelineLayout, set, writeCount, writeScratch.data());
+		break;
+	}
+	case StrategyTemplate:
+	{
+		assert(layout.updateTemplate != VK_NULL_HANDLE);
+
+		VkDescriptorSet descriptorSet = AllocateSet(threadIndex, layout);
+		vkUpdateDescriptorSetWithTemplateKHR(Vulkan.device, descriptorSet, layout.updateTemplate, data);
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, set, 1, &descriptorSet, 0, nullptr);
+		break;
+	}
+	default:
+	{
+		VkDescriptorSet descriptorSet = AllocateSet(threadIndex, layout);
+		uint32_t writeCount = BuildWrites(layout, descriptorSet, data);
+		vkUpdateDescriptorSets(Vulkan.device, writeCount, writeScratch.data(), 0, nullptr);
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, set, 1, &descriptorSet, 0, nullptr);
+		break;
+	}
+	}
+}
+
+VkDescriptorSet DescriptorBinder::AllocateSet(uint32_t threadIndex, const Layout &layout)
+{
+	return allocator->Allocate(threadIndex, layout.layoutClass, layout.setLayout);
+}
+
+uint32_t DescriptorBinder::BuildWrites(const Layout &layout, VkDescriptorSet set, const DescriptorInfo* data)
+{
+	// texel buffer views are narrower than DescriptorInfo, so every descriptor gets its own write
+	if (writeScratch.size() < layout.descriptorCount)
+		writeScratch.resize(layout.descriptorCount);
+
+	uint32_t writeCount = 0;
+
+	for (const VkDescriptorSetLayoutBinding &binding : layout.bindings)
+	{
+		for (uint32_t element = 0; element < binding.descriptorCount; element++)
+		{
+			const DescriptorInfo &info = data[writeCount];
+			VkWriteDescriptorSet &write = writeScratch[writeCount++];
+
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.pNext = nullptr;
+			write.dstSet = set;
+			write.dstBinding = binding.binding;
+			write.dstArrayElement = element;
+			write.descriptorCount = 1;
+			write.descriptorType = binding.descriptorType;
+			write.pImageInfo = IsImageDescriptor(binding.descriptorType) ? &info.image : nullptr;
+			write.pTexelBufferView = IsTexelBufferDescriptor(binding.descriptorType) ? &info.texelBuffer : nullptr;
+			write.pBufferInfo = write.pImageInfo == nullptr && write.pTexelBufferView == nullptr ? &info.buffer : nullptr;
+		}
+	}
+
+	return writeCount;
+}
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "DescriptorCache.h"
+
+#include <assert.h>
+
+#include "Hash.h"
+
+void DescriptorSetContents::Clear()
+{
+	entries.clear();
+	bufferInfos.clear();
+	imageInfos.clear();
+	texelBufferViews.clear();
+}
+
+void DescriptorSetContents::SetBuffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t arrayElement)
+{
+	VkDescriptorBufferInfo info = {};
+	info.buffer = buffer;
+	info.offset = offset;
+	info.range = range;
+
+	entries.push_back({ binding, arrayElement, type, (uint32_t)bufferInfos.size() });
+	bufferInfos.push_back(info);
+}
+
+void DescriptorSetContents::SetImage(uint32_t binding, VkDescriptorType type, VkSampler sampler, VkImageView view, VkImageLayout layout, uint32_t arrayElement)
+{
+	VkDescriptorImageInfo info = {};
+	info.sampler = sampler;
+	info.imageView = view;
+	info.imageLayout = layout;
+
+	entries.push_back({ binding, arrayElement, type, (uint32_t)imageInfos.size() });
+	imageInfos.push_back(info);
+}
+
+void DescriptorSetContents::SetTexelBuffer(uint32_t binding, VkDescriptorType type, VkBufferView view, uint32_t arrayElement)
+{
+	entries.push_back({ binding, arrayElement, type, (uint32_t)texelBufferViews.size() });
+	texelBufferViews.push_back(view);
+}
+
+uint64_t DescriptorSetContents::Hash() const
+{
+	uint64_t hash = HashSeed;
+
+	for (const Entry &entry : entries)
+	{
+		hash = HashValue(entry.binding, hash);
+		hash = HashValue(entry.arrayElement, hash);
+		hash = HashValue(entry.type, hash);
+	}
+
+	for (const VkDescriptorBufferInfo &info : bufferInfos)
+	{
+		hash = HashValue(info.buffer, hash);
+		hash = HashValue(info.offset, hash);
+		hash = HashValue(info.range, hash);
+	}
+
+	for (const VkDescriptorImageInfo &info : imageInfos)
+	{
+		hash = HashValue(info.sampler, hash);
+		hash = HashValue(info.imageView, hash);
+		hash = HashValue(info.imageLayout, hash);
+	}
+
+	for (VkBufferView view : texelBufferViews)
+		hash = HashValue(view, hash);
+
+	return hash;
+}
+
+bool DescriptorSetContents::operator ==(const DescriptorSetContents &rhs) const
+{
+	if (entries.size() != rhs.entries.size()
+		|| bufferInfos.size() != rhs.bufferInfos.size()
+		|| imageInfos.size() != rhs.imageInfos.size()
+		|| texelBufferViews != rhs.texelBufferViews)
+		return false;
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const Entry &a = entries[i];
+		const Entry &b = rhs.entries[i];
+
+		if (a.binding != b.binding || a.arrayElement != b.arrayElement || a.type != b.type || a.infoIndex != b.infoIndex)
+			return false;
+	}
+
+	for (size_t i = 0; i < bufferInfos.size(); i++)
+	{
+		const VkDescriptorBufferInfo &a = bufferInfos[i];
+		const VkDescriptorBufferInfo &b = rhs.bufferInfos[i];
+
+		if (a.buffer != b.buffer || a.offset != b.offset || a.range != b.range)
+			return false;
+	}
+
+	for (size_t i = 0; i < imageInfos.size(); i++)
+	{
+		const VkDescriptorImageInfo &a = imageInfos[i];
+		const VkDescriptorImageInfo &b = rhs.imageInfos[i];
+
+		if (a.sampler != b.sampler || a.imageView != b.imageView || a.imageLayout != b.imageLayout)
+			return false;
+	}
+
+	return true;
+}
+
+bool DescriptorSetContents::References(uint64_t handle) const
+{
+	for (const VkDescriptorBufferInfo &info : bufferInfos)
+	{
+		if ((uint64_t)info.buffer == handle)
+			return true;
+	}
+
+	for (const VkDescriptorImageInfo &info : imageInfos)
+	{
+		if ((uint64_t)info.sampler == handle || (uint64_t)info.imageView == handle)
+			return true;
+	}
+
+	for (VkBufferView view : texelBufferViews)
+	{
+		if ((uint64_t)view == handle)
+			return true;
+	}
+
+	return false;
+}
+
+void DescriptorSetContents::Write(VkDescriptorSet set) const
+{
+	std::vector<VkWriteDescriptorSet> writes(entries.size());
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const Entry &entry = entries[i];
+		VkWriteDescriptorSet &write = writes[i];
+
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.pNext = nullptr;
+		write.dstSet = set;
+		write.dstBinding = entry.binding;
+		write.dstArrayElement = entry.arrayElement;
+		write.descriptorCount = 1;
+		write.descriptorType = entry.type;
+		write.pImageInfo = nullptr;
+		write.pBufferInfo = nullptr;
+		write.pTexelBufferView = nullptr;
+
+		switch (entry.type)
+		{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			write.pImageInfo = &imageInfos[entry.infoIndex];
+			break;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+			write.pTexelBufferView = &texelBufferViews[entry.infoIndex];
+			break;
+		default:
+			write.pBufferInfo = &bufferInfos[entry.infoIndex];
+			break;
+		}
+	}
+
+	vkUpdateDescriptorSets(Vulkan.device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+}
+
+DescriptorCache::DescriptorCache()
+{
+}
+
+DescriptorCache::~DescriptorCache()
+{
+	Destroy();
+}
+
+void DescriptorCache::Create(uint32_t evictAfterFrames)
+{
+	this->evictAfterFrames = evictAfterFrames;
+	this->frameNumber = 0;
+
+	// cached sets outlive frames, so they come from a single chain that frees individually
+	allocator.Create(1, 1, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+}
+
+void DescriptorCache::Destroy()
+{
+	// the pools take their sets with them
+	entries.clear();
+	entryCount = 0;
+	retired.clear();
+	allocator.Destroy();
+}
+
+uint32_t DescriptorCache::RegisterLayoutClass(const std::vector<VkDescriptorPoolSize> &descriptorsPerSet)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return allocator.RegisterLayoutClass(descriptorsPerSet);
+}
+
+VkDescriptorSet DescriptorCache::Get(uint32_t layoutClass, VkDescriptorSetLayout layout, const DescriptorSetContents &contents)
+{
+	uint64_t hash = HashValue(layout, contents.Hash());
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::vector<Entry> &bucket = entries[hash];
+
+	for (Entry &entry : bucket)
+	{
+		if (entry.layout == layout && entry.contents == contents)
+		{
+			entry.lastUsedFrame = frameNumber;
+			stats.hits++;
+			return entry.set;
+		}
+	}
+
+	Entry entry;
+	entry.layout = layout;
+	entry.contents = contents;
+	entry.set = allocator.Allocate(0, layoutClass, layout, &entry.pool);
+	entry.layoutClass = layoutClass;
+	entry.lastUsedFrame = frameNumber;
+
+	contents.Write(entry.set);
+
+	bucket.push_back(std::move(entry));
+	entryCount++;
+	stats.misses++;
+
+	return bucket.back().set;
+}
+
+void DescriptorCache::Invalidate(uint64_t handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto it = entries.begin(); it != entries.end();)
+	{
+		std::vector<Entry> &bucket = it->second;
+
+		for (size_t i = 0; i < bucket.size();)
+		{
+			if (bucket[i].contents.References(handle))
+			{
+				// frames in flight may still read the set, free it once they are done
+				retired.push_back({ bucket[i].set, bucket[i].pool, bucket[i].layoutClass, frameNumber });
+
+				if (i + 1 != bucket.size())
+					bucket[i] = std::move(bucket.back());
+
+				bucket.pop_back();
+				entryCount--;
+			}
+			else
+			{
+				i++;
+			}
+		}
+
+		it = bucket.empty() ? entries.erase(it) : ++it;
+	}
+}
+
+void DescriptorCache::BeginFrame()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	frameNumber++;
+
+	if (frameNumber <= evictAfterFrames)
+		return;
+
+	uint64_t oldestKept = frameNumber - evictAfterFrames;
+
+	for (auto it = entries.begin(); it != entries.end();)
+	{
+		std::vector<Entry> &bucket = it->second;
+
+		for (size_t i = 0; i < bucket.size();)
+		{
+			if (bucket[i].lastUsedFrame < oldestKept)
+			{
+				allocator.Free(0, bucket[i].layoutClass, bucket[i].pool, bucket[i].set);
+
+				if (i + 1 != bucket.size())
+					bucket[i] = std::move(bucket.back());
+
+				bucket.pop_back();
+				entryCount--;
+				stats.evictions++;
+			}
+			else
+			{
+				i++;
+			}
+		}
+
+		it = bucket.empty() ? entries.erase(it) : ++it;
+	}
+
+	for (size_t i = 0; i < retired.size();)
+	{
+		if (retired[i].retiredFrame < oldestKept)
+		{
+			allocator.Free(0, retired[i].layoutClass, retired[i].pool, retired[i].set);
+
+			retired[i] = retired.back();
+			retired.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+DescriptorCache::Stats DescriptorCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Stats result = stats;
+	result.size = entryCount;
+	return result;
+}
+
+void DescriptorCache::PrintStats(std::ostream &stream) const
+{
+	Stats current = GetStats();
+
+	stream << "descriptor cache: " << current.size << " sets"
+		<< ", hits " << current.hits
+		<< ", misses " << current.misses
+		<< ", evictions " << current.evictions << std::endl;
+}
\ No newline at end of file
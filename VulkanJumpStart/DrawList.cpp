@@ -0,0 +1,261 @@
+#include "DrawList.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+#include <assert.h>
+
+uint64_t DrawList::MakeOpaqueKey(uint32_t layer, uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth)
+{
+	assert(layer < 16 && pass < 16 && pipeline <= 0xFFFF && material <= 0xFFFF && depth <= MaxDepth);
+
+	return ((uint64_t)layer << 60)
+		| ((uint64_t)pass << 56)
+		| ((uint64_t)pipeline << 40)
+		| ((uint64_t)material << 24)
+		| (uint64_t)depth;
+}
+
+uint64_t DrawList::MakeTranslucentKey(uint32_t layer, uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth)
+{
+	assert(layer < 16 && pass < 16 && pipeline <= 0xFFFF && material <= 0xFFFF && depth <= MaxDepth);
+
+	return ((uint64_t)layer << 60)
+		| ((uint64_t)pass << 56)
+		| ((uint64_t)(MaxDepth - depth) << 32)
+		| ((uint64_t)pipeline << 16)
+		| (uint64_t)material;
+}
+
+uint32_t DrawList::QuantizeDepth(float viewDepth, float nearPlane, float farPlane)
+{
+	float normalized = (viewDepth - nearPlane) / (farPlane - nearPlane);
+	normalized = std::min(std::max(normalized, 0.0f), 1.0f);
+
+	return (uint32_t)(normalized * (float)MaxDepth);
+}
+
+DrawList::DrawList()
+{
+}
+
+DrawList::~DrawList()
+{
+}
+
+void DrawList::Reserve(uint32_t capacity, uint32_t instanceDataSize)
+{
+	assert(GetCount() == 0);
+
+	this->instanceDataSize = instanceDataSize;
+
+	draws.resize(capacity);
+	hasInstanceData.resize(capacity);
+	instanceData.resize((size_t)capacity * instanceDataSize);
+	items.resize(capacity);
+	scratch.resize(capacity);
+}
+
+void DrawList::Clear()
+{
+	count.store(0, std::memory_order_relaxed);
+}
+
+void DrawList::Add(uint64_t key, const Draw &draw, const void* instanceData)
+{
+	assert(!instanceData || (instanceDataSize > 0 && draw.instanceCount == 1));
+
+	// a full list is left as it is, the count never runs past the capacity
+	uint32_t index = count.load(std::memory_order_relaxed);
+	do
+	{
+		if (index >= draws.size())
+			throw std::runtime_error("Draw list capacity exceeded");
+	}
+	while (!count.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+	draws[index] = draw;
+	hasInstanceData[index] = instanceData != nullptr;
+
+	if (instanceData)
+		memcpy(&this->instanceData[(size_t)index * instanceDataSize], instanceData, instanceDataSize);
+
+	items[index].key = key;
+	items[index].drawIndex = index;
+}
+
+const void* DrawList::GetInstanceData(uint32_t drawIndex) const
+{
+	return hasInstanceData[drawIndex] ? &instanceData[(size_t)drawIndex * instanceDataSize] : nullptr;
+}
+
+void DrawList::Sort(JobSystem &jobSystem)
+{
+	uint32_t itemCount = GetCount();
+
+	if (itemCount < 2)
+		return;
+
+	if (itemCount < ParallelSortThreshold || jobSystem.GetWorkerCount() == 1)
+	{
+		SortSerial(itemCount);
+		return;
+	}
+
+	// a few chunks per worker smooth out uneven stealing
+	uint32_t chunkCount = jobSystem.GetWorkerCount() * 4;
+	uint32_t chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+	chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+
+	histograms.resize(chunkCount * RadixSize);
+
+	SortItem* source = items.data();
+	SortItem* destination = scratch.data();
+
+	for (uint32_t pass = 0; pass < PassCount; pass++)
+	{
+		uint32_t shift = pass * RadixBits;
+
+		JobCounter histogramCounter;
+		jobSystem.ParallelFor(chunkCount, 1, [&](uint32_t first, uint32_t last)
+		{
+			for (uint32_t chunk = first; chunk < last; chunk++)
+			{
+				uint32_t* histogram = &histograms[chunk * RadixSize];
+				std::fill(histogram, histogram + RadixSize, 0);
+
+				uint32_t end = std::min(itemCount, (chunk + 1) * chunkSize);
+				for (uint32_t i = chunk * chunkSize; i < end; i++)
+					histogram[(source[i].key >> shift) & (RadixSize - 1)]++;
+			}
+		}, &histogramCounter);
+		jobSystem.WaitForCounter(&histogramCounter);
+
+		// digit major, chunk minor prefix sum keeps equal digits in chunk order, which keeps the sort stable
+		uint32_t offset = 0;
+		bool skip = false;
+
+		for (uint32_t digit = 0; digit < RadixSize && !skip; digit++)
+		{
+			uint32_t digitCount = 0;
+
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				uint32_t &slot = histograms[chunk * RadixSize + digit];
+				uint32_t value = slot;
+
+				slot = offset;
+				offset += value;
+				digitCount += value;
+			}
+
+			skip = digitCount == itemCount;
+		}
+
+		if (skip)
+			continue;
+
+		JobCounter scatterCounter;
+		jobSystem.ParallelFor(chunkCount, 1, [&](uint32_t first, uint32_t last)
+		{
+			for (uint32_t chunk = first; chunk < last; chunk++)
+			{
+				uint32_t* offsets = &histograms[chunk * RadixSize];
+
+				uint32_t end = std::min(itemCount, (chunk + 1) * chunkSize);
+				for (uint32_t i = chunk * chunkSize; i < end; i++)
+					destination[offsets[(source[i].key >> shift) & (RadixSize - 1)]++] = source[i];
+			}
+		}, &scatterCounter);
+		jobSystem.WaitForCounter(&scatterCounter);
+
+		std::swap(source, destination);
+	}
+
+	if (source != items.data())
+		std::copy(source, source + itemCount, items.data());
+}
+
+void DrawList::SortSerial(uint32_t itemCount)
+{
+	uint32_t histogram[RadixSize];
+
+	SortItem* source = items.data();
+	SortItem* destination = scratch.data();
+
+	for (uint32_t pass = 0; pass < PassCount; pass++)
+	{
+		uint32_t shift = pass * RadixBits;
+
+		std::fill(histogram, histogram + RadixSize, 0);
+		for (uint32_t i = 0; i < itemCount; i++)
+			histogram[(source[i].key >> shift) & (RadixSize - 1)]++;
+
+		if (histogram[(source[0].key >> shift) & (RadixSize - 1)] == itemCount)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t digit = 0; digit < RadixSize; digit++)
+		{
+			uint32_t value = histogram[digit];
+			histogram[digit] = offset;
+			offset += value;
+		}
+
+		for (uint32_t i = 0; i < itemCount; i++)
+			destination[histogram[(source[i].key >> shift) & (RadixSize - 1)]++] = source[i];
+
+		std::swap(source, destination);
+	}
+
+	if (source != items.data())
+		std::copy(source, source + itemCount, items.data());
+}
+
+void DrawList::Record(CommandRecorder &recorder, uint32_t begin, uint32_t end) const
+{
+	assert(end <= GetCount());
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const Draw &draw = draws[items[i].drawIndex];
+
+		// the pipeline is still compiling and the material has no fallback
+		if (draw.pipeline == VK_NULL_HANDLE)
+			continue;
+
+		recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline, draw.pipelineLayout);
+
+		if (draw.materialSet != VK_NULL_HANDLE)
+			recorder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipelineLayout, 0, 1, &draw.materialSet);
+
+		recorder.BindVertexBuffers(0, 1, &draw.vertexBuffer, &draw.vertexBufferOffset);
+
+		if (draw.indexBuffer != VK_NULL_HANDLE)
+		{
+			recorder.BindIndexBuffer(draw.indexBuffer, draw.indexBufferOffset, draw.indexType);
+			recorder.DrawIndexed(draw.indexCount, draw.instanceCount, draw.firstIndex, draw.vertexOffset, draw.firstInstance);
+		}
+		else
+		{
+			recorder.Draw(draw.indexCount, draw.instanceCount, (uint32_t)draw.vertexOffset, draw.firstInstance);
+		}
+	}
+}
+
+void DrawList::AppendRecordTasks(std::vector<CommandContext::RecordFunc> &tasks, uint32_t drawsPerTask) const
+{
+	assert(drawsPerTask > 0);
+
+	uint32_t drawCount = GetCount();
+
+	for (uint32_t begin = 0; begin < drawCount; begin += drawsPerTask)
+	{
+		uint32_t end = std::min(drawCount, begin + drawsPerTask);
+
+		tasks.push_back([this, begin, end](CommandRecorder &recorder)
+		{
+			Record(recorder, begin, end);
+		});
+	}
+}
\ No newline at end of file
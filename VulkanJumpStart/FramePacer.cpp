@@ -0,0 +1,258 @@
+#include "FramePacer.h"
+
+#include <thread>
+#include <algorithm>
+
+static double Seconds(std::chrono::high_resolution_clock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+
+// the scheduler may oversleep by a millisecond or more, so the last stretch is spun
+static void SleepUntil(std::chrono::high_resolution_clock::time_point target)
+{
+	const std::chrono::microseconds spin(1500);
+
+	if (target - std::chrono::high_resolution_clock::now() > spin)
+		std::this_thread::sleep_until(target - spin);
+
+	while (std::chrono::high_resolution_clock::now() < target)
+		std::this_thread::yield();
+}
+
+FramePacer::FramePacer()
+{
+}
+
+FramePacer::~FramePacer()
+{
+}
+
+void FramePacer::Create(FrameRing &frameRing, Mode mode, double targetFrameRate, Profiler &sink)
+{
+	this->frameRing = &frameRing;
+	this->sink = &sink;
+	this->mode = mode;
+
+	frameInterval = targetFrameRate > 0.0 ? 1.0 / targetFrameRate : 0.0;
+
+	frames.assign(frameRing.GetFrameCount(), Frame());
+	current = 0;
+
+	gpuFree = Clock::now();
+	lastStart = gpuFree;
+}
+
+bool FramePacer::IsPresentIdSupported()
+{
+	return vkfwIsDeviceExtensionEnabled(VK_KHR_PRESENT_ID_EXTENSION_NAME) && Vulkan.presentIdFeatures.presentId;
+}
+
+bool FramePacer::IsPresentWaitSupported()
+{
+	return IsPresentIdSupported() && vkfwIsDeviceExtensionEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)
+		&& Vulkan.presentWaitFeatures.presentWait && vkWaitForPresentKHR;
+}
+
+void FramePacer::BeginFrame(const FrameRing::FrameContext &context)
+{
+	Clock::time_point now = Clock::now();
+	current = context.index;
+
+	// the context's previous frame just passed its fence, and if the frame ring had to
+	// wait on it, it passed right now
+	if (frames[current].pending)
+		Complete(frames[current], context.fenceWaitSeconds > 0.0 ? now : std::min(now, frames[current].gpuDone), context.fenceWaitSeconds > 0.0);
+
+	// the others are only known to have completed some time before now
+	for (uint32_t i = 0; i < frames.size(); i++)
+	{
+		if (i != current && frames[i].pending && vkGetFenceStatus(Vulkan.device, frameRing->GetContext(i).fence) == VK_SUCCESS)
+			Complete(frames[i], std::min(now, frames[i].gpuDone), false);
+	}
+
+	WaitForPresents();
+
+	Clock::time_point target = Clock::now();
+
+	if (frameInterval > 0.0)
+		target = std::max(target, lastStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frameInterval)));
+
+	// start late enough that the submission lands as the GPU runs dry, the margin covers
+	// the frames that take longer than average
+	if (mode == ModeJustInTime && gpuSeconds > 0.0)
+	{
+		double margin = gpuSeconds * MarginFraction;
+		if (margin < MinMarginSeconds)
+			margin = MinMarginSeconds;
+
+		target = std::max(target, gpuFree - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(cpuSeconds + margin)));
+	}
+
+	Clock::time_point before = Clock::now();
+
+	if (target > before)
+	{
+		SleepUntil(target);
+
+		double sleep = Seconds(Clock::now() - before);
+		stats.sleepSeconds += sleep;
+		sink->Add("pacing sleep", sleep);
+	}
+
+	frames[current].start = Clock::now();
+	lastStart = frames[current].start;
+}
+
+void FramePacer::EndFrame(double gpuSeconds)
+{
+	Clock::time_point now = Clock::now();
+	Frame &frame = frames[current];
+
+	double cpu = Seconds(now - frame.start);
+	cpuSeconds = cpuSeconds > 0.0 ? cpuSeconds + (cpu - cpuSeconds) * AverageWeight : cpu;
+	sink->Add("frame cpu", cpu);
+
+	if (gpuSeconds > 0.0)
+	{
+		this->gpuSeconds = this->gpuSeconds > 0.0 ? this->gpuSeconds + (gpuSeconds - this->gpuSeconds) * AverageWeight : gpuSeconds;
+		sink->Add("frame gpu", gpuSeconds);
+	}
+
+	// the GPU picks the frame up once it is through everything submitted before it
+	gpuFree = std::max(now, gpuFree) + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(this->gpuSeconds));
+
+	frame.pending = true;
+	frame.gpuDone = gpuFree;
+
+	stats.frames++;
+
+	// the frame was just presented, earlier presents may have reached the display since
+	// BeginFrame and are timed closer to it here
+	if (IsPresentWaitSupported())
+		PollPresents();
+}
+
+uint64_t FramePacer::GetPresentId() const
+{
+	return IsPresentIdSupported() ? nextPresentId : 0;
+}
+
+void FramePacer::OnPresent(VkSwapchainKHR swapchain, uint64_t presentId)
+{
+	if (presentId == 0)
+		return;
+
+	if (swapchain != lastSwapchain)
+		firstPresentId = presentId;
+
+	if (IsPresentWaitSupported())
+	{
+		if (presents.size() == MaxPendingPresents)
+			presents.pop_front();
+
+		presents.push_back({ presentId, swapchain, frames[current].start });
+	}
+
+	lastPresentId = presentId;
+	lastSwapchain = swapchain;
+	nextPresentId = presentId + 1;
+}
+
+void FramePacer::OnSwapchainRetired(VkSwapchainKHR swapchain)
+{
+	presents.erase(std::remove_if(presents.begin(), presents.end(), [swapchain](const PendingPresent &present)
+	{
+		return present.swapchain == swapchain;
+	}), presents.end());
+
+	if (lastSwapchain == swapchain)
+	{
+		lastPresentId = 0;
+		lastSwapchain = VK_NULL_HANDLE;
+		firstPresentId = 0;
+	}
+}
+
+void FramePacer::Complete(Frame &frame, Clock::time_point done, bool exact)
+{
+	frame.pending = false;
+
+	// a frame later than modelled pushes everything after it back, and one that is known
+	// to have finished early pulls it forward
+	Clock::duration error = done - frame.gpuDone;
+
+	if (exact || error < Clock::duration::zero())
+	{
+		gpuFree += error;
+
+		for (Frame &other : frames)
+		{
+			if (other.pending)
+				other.gpuDone += error;
+		}
+	}
+
+	double latency = Seconds(done - frame.start);
+	stats.maxLatencySeconds = std::max(stats.maxLatencySeconds, latency);
+	sink->Add("frame latency", latency);
+}
+
+void FramePacer::WaitForPresents()
+{
+	if (!IsPresentWaitSupported())
+		return;
+
+	// keeps at most the latest present queued up, waiting for the one before it, as long
+	// as that one went to the same swapchain
+	if (mode == ModeJustInTime && lastPresentId > firstPresentId)
+	{
+		Clock::time_point before = Clock::now();
+		VkResult result = vkWaitForPresentKHR(Vulkan.device, lastSwapchain, lastPresentId - 1, PresentWaitTimeout);
+
+		if (result == VK_SUCCESS)
+		{
+			double wait = Seconds(Clock::now() - before);
+			stats.presentWaitSeconds += wait;
+			sink->Add("present wait", wait);
+		}
+	}
+
+	PollPresents();
+}
+
+void FramePacer::PollPresents()
+{
+	while (!presents.empty())
+	{
+		const PendingPresent &present = presents.front();
+		VkResult result = vkWaitForPresentKHR(Vulkan.device, present.swapchain, present.presentId, 0);
+
+		if (result == VK_TIMEOUT)
+			break;
+
+		// an out of date or lost swapchain never reports its presents
+		if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+		{
+			double latency = Seconds(Clock::now() - present.start);
+			stats.maxPresentLatencySeconds = std::max(stats.maxPresentLatencySeconds, latency);
+			sink->Add("present latency", latency);
+		}
+
+		presents.pop_front();
+	}
+}
+
+void FramePacer::PrintStats(std::ostream &stream) const
+{
+	const char* modeNames[] = { "unlimited", "limited", "just in time" };
+
+	stream << "frame pacing: " << modeNames[mode] << ", " << stats.frames << " frames"
+		<< ", slept " << stats.sleepSeconds * 1000.0 << " ms"
+		<< ", worst latency " << stats.maxLatencySeconds * 1000.0 << " ms to GPU completion";
+
+	if (stats.maxPresentLatencySeconds > 0.0)
+		stream << ", " << stats.maxPresentLatencySeconds * 1000.0 << " ms to display";
+
+	stream << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "FrameRing.h"
+
+#include <chrono>
+#include <algorithm>
+
+FrameRing::FrameRing()
+{
+}
+
+FrameRing::~FrameRing()
+{
+	Destroy();
+}
+
+void FrameRing::Create(uint32_t frameCount)
+{
+	if (frameCount < MinFrameCount || frameCount > MaxFrameCount)
+		throw std::runtime_error("Frames in flight must be between 2 and 3");
+
+	// created signalled, the first BeginFrame of each context has nothing to wait for
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.pNext = nullptr;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = nullptr;
+	semaphoreInfo.flags = 0;
+
+	contexts.resize(frameCount);
+
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		FrameContext &context = contexts[i];
+		context.index = i;
+
+		if (vkCreateFence(Vulkan.device, &fenceInfo, nullptr, &context.fence) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create frame fence");
+
+		if (vkCreateSemaphore(Vulkan.device, &semaphoreInfo, nullptr, &context.imageAvailable) != VK_SUCCESS
+			|| vkCreateSemaphore(Vulkan.device, &semaphoreInfo, nullptr, &context.renderFinished) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create frame semaphores");
+	}
+
+	current = 0;
+	frameNumber = 0;
+}
+
+void FrameRing::Destroy()
+{
+	Flush();
+
+	for (FrameContext &context : contexts)
+	{
+		if (context.fence != VK_NULL_HANDLE)
+			vkDestroyFence(Vulkan.device, context.fence, nullptr);
+
+		if (context.imageAvailable != VK_NULL_HANDLE)
+			vkDestroySemaphore(Vulkan.device, context.imageAvailable, nullptr);
+
+		if (context.renderFinished != VK_NULL_HANDLE)
+			vkDestroySemaphore(Vulkan.device, context.renderFinished, nullptr);
+	}
+
+	contexts.clear();
+}
+
+FrameRing::FrameContext& FrameRing::BeginFrame()
+{
+	FrameContext &context = contexts[current];
+
+	auto start = std::chrono::high_resolution_clock::now();
+	double waitSeconds = 0.0;
+
+	// a fence that already passed costs no wait and no timing
+	if (vkGetFenceStatus(Vulkan.device, context.fence) != VK_SUCCESS)
+	{
+		if (vkWaitForFences(Vulkan.device, 1, &context.fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+			throw std::runtime_error("Failed to wait for frame fence");
+
+		waitSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	vkResetFences(Vulkan.device, 1, &context.fence);
+
+	stats.frames++;
+	stats.fenceWaitSeconds += waitSeconds;
+	stats.maxFenceWaitSeconds = std::max(stats.maxFenceWaitSeconds, waitSeconds);
+	context.fenceWaitSeconds = waitSeconds;
+
+	std::vector<std::function<void()>> deletions;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		deletions.swap(context.deletions);
+	}
+
+	// destroy outside the lock, a callback may defer more work
+	for (std::function<void()> &destroy : deletions)
+		destroy();
+
+	context.frameNumber = frameNumber;
+	return context;
+}
+
+void FrameRing::EndFrame()
+{
+	current = (current + 1) % (uint32_t)contexts.size();
+	frameNumber++;
+}
+
+void FrameRing::Defer(std::function<void()> destroy)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	contexts[current].deletions.push_back(std::move(destroy));
+}
+
+void FrameRing::Flush()
+{
+	// oldest frame first, each list in the order it was deferred
+	for (uint32_t i = 1; i <= contexts.size(); i++)
+	{
+		FrameContext &context = contexts[(current + i) % contexts.size()];
+		std::vector<std::function<void()>> deletions;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			deletions.swap(context.deletions);
+		}
+
+		for (std::function<void()> &destroy : deletions)
+			destroy();
+	}
+}
+
+void FrameRing::PrintStats(std::ostream &stream) const
+{
+	double averageMs = stats.frames > 0 ? stats.fenceWaitSeconds * 1000.0 / stats.frames : 0.0;
+
+	stream << "frame ring: " << contexts.size() << " frames in flight, " << stats.frames << " frames"
+		<< ", fence wait " << averageMs << " ms average"
+		<< ", " << stats.maxFenceWaitSeconds * 1000.0 << " ms worst" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "GpuBuffer.h"
+
+GpuBuffer::GpuBuffer()
+{
+}
+
+GpuBuffer::~GpuBuffer()
+{
+	Destroy();
+}
+
+void GpuBuffer::Create(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred)
+{
+	this->size = size;
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.pNext = nullptr;
+	bufferInfo.flags = 0;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	bufferInfo.queueFamilyIndexCount = 0;
+	bufferInfo.pQueueFamilyIndices = nullptr;
+
+	if (vkCreateBuffer(Vulkan.device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create buffer");
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(Vulkan.device, buffer, &requirements);
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.pNext = nullptr;
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = vkfwFindMemoryType(requirements.memoryTypeBits, properties, preferred);
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(Vulkan.physicalDevice, &memoryProperties);
+	coherent = (memoryProperties.memoryTypes[allocInfo.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+	if (vkAllocateMemory(Vulkan.device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		throw std::runtime_error("Failed to allocate buffer memory");
+
+	if (vkBindBufferMemory(Vulkan.device, buffer, memory, 0) != VK_SUCCESS)
+		throw std::runtime_error("Failed to bind buffer memory");
+
+	if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		if (vkMapMemory(Vulkan.device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+			throw std::runtime_error("Failed to map buffer memory");
+	}
+}
+
+void GpuBuffer::InvalidateMapped()
+{
+	if (!mapped || coherent)
+		return;
+
+	VkMappedMemoryRange range = {};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.pNext = nullptr;
+	range.memory = memory;
+	range.offset = 0;
+	range.size = VK_WHOLE_SIZE;
+
+	if (vkInvalidateMappedMemoryRanges(Vulkan.device, 1, &range) != VK_SUCCESS)
+		throw std::runtime_error("Failed to invalidate mapped buffer memory");
+}
+
+void GpuBuffer::Destroy()
+{
+	if (buffer != VK_NULL_HANDLE)
+		vkDestroyBuffer(Vulkan.device, buffer, nullptr);
+
+	// freeing the memory unmaps it
+	if (memory != VK_NULL_HANDLE)
+		vkFreeMemory(Vulkan.device, memory, nullptr);
+
+	buffer = VK_NULL_HANDLE;
+	memory = VK_NULL_HANDLE;
+	mapped = nullptr;
+	size = 0;
+}
\ No newline at end of file
@@ -0,0 +1,310 @@
+#include "GpuCulling.h"
+
+#include <algorithm>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+GpuCulling::GpuCulling()
+{
+}
+
+GpuCulling::~GpuCulling()
+{
+	Destroy();
+}
+
+bool GpuCulling::IsSupported()
+{
+	return Vulkan.enabledFeatures.drawIndirectFirstInstance == VK_TRUE;
+}
+
+void GpuCulling::Create(uint32_t maxInstances, uint32_t frameCount, PipelineCache &pipelineCache, const ShaderBundle &shaders, const char* shaderName)
+{
+	assert(IsSupported());
+	assert(frameCount > 0);
+
+	if (vkfwIsDeviceExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) && vkCmdDrawIndexedIndirectCountKHR)
+		drawPath = DrawPathCountKHR;
+	else if (vkfwIsDeviceExtensionEnabled(VK_AMD_DRAW_INDIRECT_COUNT_EXTENSION_NAME) && vkCmdDrawIndexedIndirectCountAMD)
+		drawPath = DrawPathCountAMD;
+	else if (Vulkan.enabledFeatures.multiDrawIndirect)
+		drawPath = DrawPathMultiDraw;
+	else
+		drawPath = DrawPathSingleDraws;
+
+	this->maxInstances = maxInstances;
+
+	// one call covers every instance on the other paths, the single draws each pass a count of one
+	if (drawPath != DrawPathSingleDraws)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(Vulkan.physicalDevice, &properties);
+
+		this->maxInstances = std::min(maxInstances, properties.limits.maxDrawIndirectCount);
+	}
+
+	frames.resize(frameCount);
+
+	for (FrameResources &frame : frames)
+	{
+		// also bound per instance by the vertex shader drawing the survivors
+		frame.instances.Create(this->maxInstances * sizeof(Instance),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		frame.draws.Create(this->maxInstances * sizeof(VkDrawIndexedIndirectCommand),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// host visible so the visible count can be read back for stats
+		frame.drawCount.Create(sizeof(uint32_t),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		frame.instanceCount = 0;
+	}
+
+	CreateDescriptorSets();
+	CreatePipeline(pipelineCache, shaders, shaderName);
+}
+
+void GpuCulling::Destroy()
+{
+	if (pipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(Vulkan.device, pipeline, nullptr);
+
+	if (pipelineLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(Vulkan.device, pipelineLayout, nullptr);
+
+	if (pool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(Vulkan.device, pool, nullptr);
+
+	if (setLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(Vulkan.device, setLayout, nullptr);
+
+	pipeline = VK_NULL_HANDLE;
+	pipelineLayout = VK_NULL_HANDLE;
+	pool = VK_NULL_HANDLE;
+	setLayout = VK_NULL_HANDLE;
+
+	frames.clear();
+}
+
+void GpuCulling::UpdateInstances(uint32_t frameIndex, const Instance* instances, uint32_t count)
+{
+	assert(count <= maxInstances);
+
+	FrameResources &frame = frames[frameIndex];
+
+	memcpy(frame.instances.GetMapped(), instances, count * sizeof(Instance));
+	frame.instanceCount = count;
+}
+
+void GpuCulling::ExtractFrustumPlanes(const float viewProjection[16], float planes[6][4])
+{
+	// rows of the matrix, stored column-major
+	float rows[4][4];
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+			rows[row][column] = viewProjection[column * 4 + row];
+	}
+
+	// left, right, bottom, top from w +- x and w +- y, near and far for a 0..1 depth range
+	for (int i = 0; i < 4; i++)
+	{
+		planes[0][i] = rows[3][i] + rows[0][i];
+		planes[1][i] = rows[3][i] - rows[0][i];
+		planes[2][i] = rows[3][i] + rows[1][i];
+		planes[3][i] = rows[3][i] - rows[1][i];
+		planes[4][i] = rows[2][i];
+		planes[5][i] = rows[3][i] - rows[2][i];
+	}
+
+	for (int plane = 0; plane < 6; plane++)
+	{
+		float length = sqrtf(planes[plane][0] * planes[plane][0] + planes[plane][1] * planes[plane][1] + planes[plane][2] * planes[plane][2]);
+
+		if (length > 0.0f)
+		{
+			for (int i = 0; i < 4; i++)
+				planes[plane][i] /= length;
+		}
+	}
+}
+
+void GpuCulling::Cull(VkCommandBuffer commandBuffer, uint32_t frameIndex, const float planes[6][4])
+{
+	const FrameResources &frame = frames[frameIndex];
+
+	vkCmdFillBuffer(commandBuffer, frame.drawCount.GetBuffer(), 0, sizeof(uint32_t), 0);
+
+	VkMemoryBarrier clearBarrier = {};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clearBarrier.pNext = nullptr;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+	PushConstants constants;
+	memcpy(constants.planes, planes, sizeof(constants.planes));
+	constants.instanceCount = frame.instanceCount;
+	constants.compact = drawPath == DrawPathCountKHR || drawPath == DrawPathCountAMD;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.set, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+	if (frame.instanceCount > 0)
+		vkCmdDispatch(commandBuffer, (frame.instanceCount + GroupSize - 1) / GroupSize, 1, 1);
+}
+
+void GpuCulling::Draw(VkCommandBuffer commandBuffer, uint32_t frameIndex) const
+{
+	const FrameResources &frame = frames[frameIndex];
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if (frame.instanceCount == 0)
+		return;
+
+	switch (drawPath)
+	{
+	case DrawPathCountKHR:
+		vkCmdDrawIndexedIndirectCountKHR(commandBuffer, frame.draws.GetBuffer(), 0, frame.drawCount.GetBuffer(), 0, frame.instanceCount, stride);
+		break;
+	case DrawPathCountAMD:
+		vkCmdDrawIndexedIndirectCountAMD(commandBuffer, frame.draws.GetBuffer(), 0, frame.drawCount.GetBuffer(), 0, frame.instanceCount, stride);
+		break;
+	case DrawPathMultiDraw:
+		vkCmdDrawIndexedIndirect(commandBuffer, frame.draws.GetBuffer(), 0, frame.instanceCount, stride);
+		break;
+	default:
+		// culled slots still cost a call here, they just draw zero instances
+		for (uint32_t i = 0; i < frame.instanceCount; i++)
+			vkCmdDrawIndexedIndirect(commandBuffer, frame.draws.GetBuffer(), i * stride, 1, stride);
+		break;
+	}
+}
+
+uint32_t GpuCulling::GetVisibleCount(uint32_t frameIndex) const
+{
+	return *(const uint32_t*)frames[frameIndex].drawCount.GetMapped();
+}
+
+void GpuCulling::CreateDescriptorSets()
+{
+	VkDescriptorSetLayoutBinding bindings[3] = {};
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		bindings[i].pImmutableSamplers = nullptr;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = nullptr;
+	layoutInfo.flags = 0;
+	layoutInfo.bindingCount = 3;
+	layoutInfo.pBindings = bindings;
+
+	if (vkCreateDescriptorSetLayout(Vulkan.device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create culling descriptor set layout");
+
+	VkDescriptorPoolSize poolSize;
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = 3 * (uint32_t)frames.size();
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+	poolInfo.flags = 0;
+	poolInfo.maxSets = (uint32_t)frames.size();
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	if (vkCreateDescriptorPool(Vulkan.device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create culling descriptor pool");
+
+	for (FrameResources &frame : frames)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.pNext = nullptr;
+		allocInfo.descriptorPool = pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &setLayout;
+
+		if (vkAllocateDescriptorSets(Vulkan.device, &allocInfo, &frame.set) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate culling descriptor set");
+
+		VkDescriptorBufferInfo bufferInfos[3] = {};
+		bufferInfos[0].buffer = frame.instances.GetBuffer();
+		bufferInfos[1].buffer = frame.draws.GetBuffer();
+		bufferInfos[2].buffer = frame.drawCount.GetBuffer();
+
+		VkWriteDescriptorSet writes[3] = {};
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range = VK_WHOLE_SIZE;
+
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].pNext = nullptr;
+			writes[i].dstSet = frame.set;
+			writes[i].dstBinding = i;
+			writes[i].dstArrayElement = 0;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(Vulkan.device, 3, writes, 0, nullptr);
+	}
+}
+
+void GpuCulling::CreatePipeline(PipelineCache &pipelineCache, const ShaderBundle &shaders, const char* shaderName)
+{
+	VkPushConstantRange pushRange;
+	pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushRange.offset = 0;
+	pushRange.size = sizeof(PushConstants);
+
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = nullptr;
+	layoutInfo.flags = 0;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushRange;
+
+	if (vkCreatePipelineLayout(Vulkan.device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create culling pipeline layout");
+
+	VkShaderModule module = shaders.CreateShaderModule(shaderName);
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.pNext = nullptr;
+	pipelineInfo.flags = 0;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.pNext = nullptr;
+	pipelineInfo.stage.flags = 0;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = module;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.stage.pSpecializationInfo = nullptr;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	pipeline = pipelineCache.CreateComputePipeline(0, pipelineInfo);
+
+	vkDestroyShaderModule(Vulkan.device, module, nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "HeadlessTarget.h"
+
+#include <chrono>
+#include <stdio.h>
+
+#include "ImageFile.h"
+
+HeadlessTarget::HeadlessTarget()
+{
+}
+
+HeadlessTarget::~HeadlessTarget()
+{
+	Destroy();
+}
+
+void HeadlessTarget::Create(FrameRing &frameRing, uint32_t width, uint32_t height, Output output, const char* outputDirectory)
+{
+	this->output = output;
+	this->outputDirectory = outputDirectory;
+
+	// EXR keeps what the frame rendered beyond 0 to 1
+	format = output == OutputExr ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R8G8B8A8_UNORM;
+	pixelSize = output == OutputExr ? 8 : 4;
+	extent.width = width;
+	extent.height = height;
+
+	slots.resize(frameRing.GetFrameCount());
+
+	for (Slot &slot : slots)
+	{
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.pNext = nullptr;
+		imageInfo.flags = 0;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = format;
+		imageInfo.extent = { width, height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.queueFamilyIndexCount = 0;
+		imageInfo.pQueueFamilyIndices = nullptr;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(Vulkan.device, &imageInfo, nullptr, &slot.image) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create offscreen image");
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(Vulkan.device, slot.image, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.pNext = nullptr;
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = vkfwFindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (vkAllocateMemory(Vulkan.device, &allocInfo, nullptr, &slot.memory) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate offscreen image memory");
+
+		if (vkBindImageMemory(Vulkan.device, slot.image, slot.memory, 0) != VK_SUCCESS)
+			throw std::runtime_error("Failed to bind offscreen image memory");
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.pNext = nullptr;
+		viewInfo.flags = 0;
+		viewInfo.image = slot.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(Vulkan.device, &viewInfo, nullptr, &slot.view) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create offscreen image view");
+
+		// every pixel is read on the CPU, which uncached, write-combined memory makes very slow
+		slot.readback.Create((VkDeviceSize)width * height * pixelSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+	}
+
+	current = 0;
+}
+
+void HeadlessTarget::Destroy()
+{
+	for (Slot &slot : slots)
+	{
+		if (slot.view != VK_NULL_HANDLE)
+			vkDestroyImageView(Vulkan.device, slot.view, nullptr);
+
+		if (slot.image != VK_NULL_HANDLE)
+			vkDestroyImage(Vulkan.device, slot.image, nullptr);
+
+		if (slot.memory != VK_NULL_HANDLE)
+			vkFreeMemory(Vulkan.device, slot.memory, nullptr);
+
+		slot.readback.Destroy();
+	}
+
+	slots.clear();
+}
+
+void HeadlessTarget::Flush()
+{
+	// in frame order, so the files appear in the order they were rendered
+	for (uint32_t i = 1; i <= slots.size(); i++)
+	{
+		Slot &slot = slots[(current + i) % slots.size()];
+
+		if (slot.pending)
+			Write(slot);
+	}
+}
+
+bool HeadlessTarget::Acquire(const FrameRing::FrameContext &context)
+{
+	current = context.index;
+
+	if (slots[current].pending)
+		Write(slots[current]);
+
+	return true;
+}
+
+RenderGraph::Resource HeadlessTarget::Import(RenderGraph &graph)
+{
+	RenderGraph::ImageDesc desc;
+	desc.format = format;
+	desc.width = extent.width;
+	desc.height = extent.height;
+
+	return graph.ImportImage("offscreen", slots[current].image, slots[current].view, desc, RenderGraph::UsageNone, RenderGraph::UsageNone);
+}
+
+void HeadlessTarget::AddFinalPasses(RenderGraph &graph, RenderGraph::Resource image)
+{
+	Slot &slot = slots[current];
+
+	VkBuffer buffer = slot.readback.GetBuffer();
+	RenderGraph::Resource readback = graph.ImportBuffer("readback", buffer, slot.readback.GetSize(), RenderGraph::UsageNone, RenderGraph::UsageHostRead);
+
+	VkImage source = slot.image;
+	VkExtent2D size = extent;
+
+	RenderGraph::Pass pass = graph.AddPass("readback", [source, buffer, size](VkCommandBuffer commandBuffer)
+	{
+		VkBufferImageCopy region = {};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { size.width, size.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+	});
+
+	graph.Use(pass, image, RenderGraph::UsageTransferSrc);
+	graph.Use(pass, readback, RenderGraph::UsageTransferDst);
+}
+
+void HeadlessTarget::Present(const FrameRing::FrameContext &context, uint64_t)
+{
+	Slot &slot = slots[context.index];
+	slot.pending = true;
+	slot.frameNumber = context.frameNumber;
+
+	stats.frames++;
+	stats.readbackBytes += slot.readback.GetSize();
+}
+
+void HeadlessTarget::Write(Slot &slot)
+{
+	slot.pending = false;
+
+	if (output == OutputNone)
+		return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// the fence has passed, cached memory that is not coherent still needs the invalidate
+	slot.readback.InvalidateMapped();
+
+	char name[32];
+	snprintf(name, sizeof(name), "frame_%05llu.%s", (unsigned long long)slot.frameNumber, output == OutputExr ? "exr" : "png");
+
+	std::string path = outputDirectory + "/" + name;
+
+	if (output == OutputExr)
+		ImageFile::WriteExr(path.c_str(), extent.width, extent.height, (const uint16_t*)slot.readback.GetMapped());
+	else
+		ImageFile::WritePng(path.c_str(), extent.width, extent.height, (const uint8_t*)slot.readback.GetMapped());
+
+	stats.writtenFrames++;
+	stats.writeSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void HeadlessTarget::PrintStats(std::ostream &stream) const
+{
+	stream << "headless: " << extent.width << "x" << extent.height << ", " << stats.frames << " frames read back"
+		<< ", " << stats.readbackBytes / (1024 * 1024) << " MB"
+		<< ", " << stats.writtenFrames << " written in " << stats.writeSeconds * 1000.0 << " ms" << std::endl;
+}
\ No newline at end of file
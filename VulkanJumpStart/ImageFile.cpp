@@ -0,0 +1,243 @@
+#include "ImageFile.h"
+
+#include <fstream>
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <string.h>
+
+static void PutU32BE(std::vector<uint8_t> &data, uint32_t value)
+{
+	data.push_back((uint8_t)(value >> 24));
+	data.push_back((uint8_t)(value >> 16));
+	data.push_back((uint8_t)(value >> 8));
+	data.push_back((uint8_t)value);
+}
+
+template<typename T>
+static void PutLE(std::vector<uint8_t> &data, T value)
+{
+	for (size_t i = 0; i < sizeof(T); i++)
+		data.push_back((uint8_t)((uint64_t)value >> (i * 8)));
+}
+
+static void PutString(std::vector<uint8_t> &data, const char* string)
+{
+	data.insert(data.end(), string, string + strlen(string) + 1);
+}
+
+static uint32_t Crc32(const uint8_t* data, size_t size)
+{
+	static uint32_t table[256];
+	static bool tableReady = false;
+
+	if (!tableReady)
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+
+			for (uint32_t k = 0; k < 8; k++)
+				c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+			table[i] = c;
+		}
+
+		tableReady = true;
+	}
+
+	uint32_t crc = 0xFFFFFFFFu;
+
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	return crc ^ 0xFFFFFFFFu;
+}
+
+// length, type, data, then the CRC of type and data
+static void PutPngChunk(std::vector<uint8_t> &png, const char* type, const std::vector<uint8_t> &data)
+{
+	PutU32BE(png, (uint32_t)data.size());
+
+	size_t start = png.size();
+	png.insert(png.end(), type, type + 4);
+	png.insert(png.end(), data.begin(), data.end());
+
+	PutU32BE(png, Crc32(png.data() + start, png.size() - start));
+}
+
+void ImageFile::WritePng(const char* path, uint32_t width, uint32_t height, const uint8_t* rgba)
+{
+	static const uint8_t Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	static const size_t MaxStoredBlock = 65535;
+
+	std::vector<uint8_t> png(Signature, Signature + sizeof(Signature));
+
+	// 8 bits per channel RGBA, deflate, adaptive filtering, no interlacing
+	std::vector<uint8_t> header;
+	PutU32BE(header, width);
+	PutU32BE(header, height);
+	header.push_back(8);
+	header.push_back(6);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	PutPngChunk(png, "IHDR", header);
+
+	// each row starts with its filter type, none
+	size_t rowSize = (size_t)width * 4;
+	std::vector<uint8_t> raw;
+	raw.reserve((rowSize + 1) * height);
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba + y * rowSize, rgba + (y + 1) * rowSize);
+	}
+
+	// a zlib stream of stored blocks, no compression window to speak of
+	std::vector<uint8_t> zlib;
+	zlib.reserve(raw.size() + raw.size() / MaxStoredBlock * 5 + 16);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+
+	size_t offset = 0;
+
+	do
+	{
+		size_t blockSize = std::min(raw.size() - offset, MaxStoredBlock);
+		bool last = offset + blockSize == raw.size();
+
+		zlib.push_back(last ? 1 : 0);
+		PutLE<uint16_t>(zlib, (uint16_t)blockSize);
+		PutLE<uint16_t>(zlib, (uint16_t)~blockSize);
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+
+		offset += blockSize;
+	} while (offset < raw.size());
+
+	uint32_t a = 1;
+	uint32_t b = 0;
+
+	for (uint8_t byte : raw)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	PutU32BE(zlib, (b << 16) | a);
+
+	PutPngChunk(png, "IDAT", zlib);
+	PutPngChunk(png, "IEND", std::vector<uint8_t>());
+
+	WriteFile(path, png);
+}
+
+void ImageFile::WriteExr(const char* path, uint32_t width, uint32_t height, const uint16_t* rgbaHalf)
+{
+	std::vector<uint8_t> exr;
+
+	// magic number, then version 2 for single part scanline files
+	PutLE<uint32_t>(exr, 20000630);
+	PutLE<uint32_t>(exr, 2);
+
+	// channels are stored in alphabetical order, all half with no subsampling
+	const char* channelNames[] = { "A", "B", "G", "R" };
+	const uint32_t channelIndices[] = { 3, 2, 1, 0 };
+
+	PutString(exr, "channels");
+	PutString(exr, "chlist");
+	PutLE<uint32_t>(exr, 4 * (2 + 16) + 1);
+
+	for (const char* name : channelNames)
+	{
+		PutString(exr, name);
+		PutLE<uint32_t>(exr, 1);
+		PutLE<uint32_t>(exr, 0);
+		PutLE<int32_t>(exr, 1);
+		PutLE<int32_t>(exr, 1);
+	}
+
+	exr.push_back(0);
+
+	PutString(exr, "compression");
+	PutString(exr, "compression");
+	PutLE<uint32_t>(exr, 1);
+	exr.push_back(0);
+
+	const char* windows[] = { "dataWindow", "displayWindow" };
+
+	for (const char* window : windows)
+	{
+		PutString(exr, window);
+		PutString(exr, "box2i");
+		PutLE<uint32_t>(exr, 16);
+		PutLE<int32_t>(exr, 0);
+		PutLE<int32_t>(exr, 0);
+		PutLE<int32_t>(exr, (int32_t)width - 1);
+		PutLE<int32_t>(exr, (int32_t)height - 1);
+	}
+
+	PutString(exr, "lineOrder");
+	PutString(exr, "lineOrder");
+	PutLE<uint32_t>(exr, 1);
+	exr.push_back(0);
+
+	float one = 1.0f;
+	uint32_t oneBits;
+	memcpy(&oneBits, &one, sizeof(oneBits));
+
+	PutString(exr, "pixelAspectRatio");
+	PutString(exr, "float");
+	PutLE<uint32_t>(exr, 4);
+	PutLE<uint32_t>(exr, oneBits);
+
+	PutString(exr, "screenWindowCenter");
+	PutString(exr, "v2f");
+	PutLE<uint32_t>(exr, 8);
+	PutLE<uint32_t>(exr, 0);
+	PutLE<uint32_t>(exr, 0);
+
+	PutString(exr, "screenWindowWidth");
+	PutString(exr, "float");
+	PutLE<uint32_t>(exr, 4);
+	PutLE<uint32_t>(exr, oneBits);
+
+	exr.push_back(0);
+
+	// one scanline per block, the offset table points at each from the start of the file
+	uint32_t lineSize = width * 4 * sizeof(uint16_t);
+	uint64_t lineOffset = exr.size() + (uint64_t)height * sizeof(uint64_t);
+
+	for (uint32_t y = 0; y < height; y++)
+		PutLE<uint64_t>(exr, lineOffset + (uint64_t)y * (8 + lineSize));
+
+	exr.reserve(exr.size() + (size_t)height * (8 + lineSize));
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		PutLE<int32_t>(exr, (int32_t)y);
+		PutLE<uint32_t>(exr, lineSize);
+
+		// planar within the line, all of A, then B, G and R
+		const uint16_t* row = rgbaHalf + (size_t)y * width * 4;
+
+		for (uint32_t channel : channelIndices)
+		{
+			for (uint32_t x = 0; x < width; x++)
+				PutLE<uint16_t>(exr, row[x * 4 + channel]);
+		}
+	}
+
+	WriteFile(path, exr);
+}
+
+void ImageFile::WriteFile(const char* path, const std::vector<uint8_t> &data)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write((const char*)data.data(), data.size());
+	file.close();
+
+	if (!file)
+		throw std::runtime_error(std::string("Failed to write image ") + path);
+}
\ No newline at end of file
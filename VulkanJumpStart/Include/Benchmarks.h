@@ -0,0 +1,18 @@
+#ifndef BENCHMARKS_HEADER
+#define BENCHMARKS_HEADER
+
+#include <iostream>
+
+#include "CommandContext.h"
+#include "DescriptorAllocator.h"
+
+// Synthetic workloads run from the command line instead of the main loop,
+// e.g. VulkanJumpStart.exe --bench-jobs
+
+void RunJobBenchmark(std::ostream &stream);
+void RunSortBenchmark(std::ostream &stream);
+
+// needs an initialized device, run with --bench-descriptors
+void RunDescriptorBenchmark(std::ostream &stream, CommandContext &commandContext, DescriptorAllocator &allocator);
+
+#endif // !BENCHMARKS_HEADER
\ No newline at end of file
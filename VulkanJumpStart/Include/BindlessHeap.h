@@ -0,0 +1,85 @@
+#ifndef BINDLESS_HEAP_HEADER
+#define BINDLESS_HEAP_HEADER
+
+#include <vector>
+#include <mutex>
+
+#include "VKFW.h"
+
+// One update-after-bind descriptor set holding every texture and storage buffer in
+// two large partially bound arrays. Resources are registered once and shaders pick
+// them by the returned index, so draws no longer need their own descriptor sets.
+// Freed slots are only reused after the frames in flight that may read them retire.
+class BindlessHeap
+{
+public:
+	static const uint32_t TextureBinding = 0;
+	static const uint32_t BufferBinding = 1;
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	BindlessHeap();
+	~BindlessHeap();
+
+	// needs VK_EXT_descriptor_indexing with its features enabled at device creation
+	static bool IsSupported();
+
+	// capacities are clamped to the device's update-after-bind limits
+	void Create(uint32_t maxTextures, uint32_t maxBuffers, uint32_t frameCount);
+	void Destroy();
+
+	// safe to call from several jobs at once, the returned index goes to the shader
+	uint32_t AddTexture(VkSampler sampler, VkImageView view, VkImageLayout layout);
+	uint32_t AddBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+
+	void RemoveTexture(uint32_t index);
+	void RemoveBuffer(uint32_t index);
+
+	// recycles slots freed more than frameCount frames ago
+	void BeginFrame();
+
+	void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t setIndex) const;
+
+	VkDescriptorSetLayout GetLayout() const { return layout; }
+	VkDescriptorSet GetSet() const { return set; }
+
+	uint32_t GetTextureCapacity() const { return textures.capacity; }
+	uint32_t GetBufferCapacity() const { return buffers.capacity; }
+
+private:
+	// hands out array slots, freed ones wait out the frames in flight on a pending list
+	struct SlotAllocator
+	{
+		struct PendingSlot
+		{
+			uint32_t index;
+			uint64_t freedFrame;
+		};
+
+		std::vector<uint32_t> freeList;
+		std::vector<PendingSlot> pending;
+
+		uint32_t next = 0;
+		uint32_t capacity = 0;
+		uint32_t used = 0;
+
+		uint32_t Allocate();
+		void Release(uint32_t index, uint64_t frame);
+		void Recycle(uint64_t oldestKept);
+	};
+
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+
+	SlotAllocator textures;
+	SlotAllocator buffers;
+
+	std::mutex mutex;
+
+	uint64_t frameNumber = 0;
+	uint32_t frameCount = 0;
+
+	void Write(uint32_t binding, uint32_t index, VkDescriptorType type, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo);
+};
+
+#endif // !BINDLESS_HEAP_HEADER
\ No newline at end of file
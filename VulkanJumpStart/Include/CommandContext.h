@@ -0,0 +1,83 @@
+#ifndef COMMAND_CONTEXT_HEADER
+#define COMMAND_CONTEXT_HEADER
+
+#include <vector>
+#include <functional>
+#include <iostream>
+
+#include "VKFW.h"
+#include "JobSystem.h"
+#include "CommandRecorder.h"
+
+// Hands out command buffers from one VkCommandPool per (frame, thread) pair.
+// Pools are externally synchronized, so each thread only ever touches its own
+// slot, and a whole frame is recycled with one vkResetCommandPool per slot.
+class CommandContext
+{
+public:
+	typedef std::function<void(CommandRecorder&)> RecordFunc;
+
+	struct RecorderStats
+	{
+		uint64_t frameIssued = 0;
+		uint64_t frameFiltered = 0;
+		uint64_t totalIssued = 0;
+		uint64_t totalFiltered = 0;
+		uint64_t frames = 0;
+	};
+
+	CommandContext();
+	~CommandContext();
+
+	void Create(uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t threadCount);
+	void Destroy();
+
+	void BeginFrame(uint32_t frameIndex);
+
+	VkCommandBuffer BeginPrimary(uint32_t threadIndex);
+	VkCommandBuffer BeginSecondary(uint32_t threadIndex, const VkCommandBufferInheritanceInfo &inheritance);
+
+	// records the tasks into secondary command buffers as jobs, each on the pool of
+	// the worker executing it, and stitches them in task order into the primary.
+	// Tasks of one batch share a recorder, so state repeated across them is filtered too.
+	// Dynamic state is not inherited, given a viewport extent every secondary starts with
+	// viewport and scissor covering it
+	void RecordParallel(JobSystem &jobSystem, VkCommandBuffer primary, const VkCommandBufferInheritanceInfo &inheritance, const std::vector<RecordFunc> &tasks,
+		const VkExtent2D* viewportExtent = nullptr);
+
+	// recorders created over this context's command buffers report here
+	CommandRecorderStats* GetRecorderStatsSink() { return &recorderStats; }
+
+	// frame counts cover the last completed frame, as of the latest BeginFrame
+	RecorderStats GetRecorderStats() const { return frameStats; }
+	void PrintStats(std::ostream &stream) const;
+
+	uint32_t GetThreadCount() const { return threadCount; }
+	uint32_t GetFrameIndex() const { return frameIndex; }
+
+private:
+	struct ThreadPool
+	{
+		VkCommandPool pool = VK_NULL_HANDLE;
+
+		std::vector<VkCommandBuffer> primaries;
+		std::vector<VkCommandBuffer> secondaries;
+
+		uint32_t primaryCursor = 0;
+		uint32_t secondaryCursor = 0;
+	};
+
+	std::vector<ThreadPool> pools;
+
+	CommandRecorderStats recorderStats;
+	RecorderStats frameStats;
+
+	uint32_t threadCount = 0;
+	uint32_t frameCount = 0;
+	uint32_t frameIndex = 0;
+
+	ThreadPool& GetPool(uint32_t threadIndex);
+	VkCommandBuffer Acquire(ThreadPool &pool, VkCommandBufferLevel level);
+};
+
+#endif // !COMMAND_CONTEXT_HEADER
\ No newline at end of file
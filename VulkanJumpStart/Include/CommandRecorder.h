@@ -0,0 +1,112 @@
+#ifndef COMMAND_RECORDER_HEADER
+#define COMMAND_RECORDER_HEADER
+
+#include <atomic>
+#include <string.h>
+
+#include "VKFW.h"
+
+// Per-frame totals, filled by every recorder of the frame when it ends.
+struct CommandRecorderStats
+{
+	std::atomic<uint64_t> issued{ 0 };
+	std::atomic<uint64_t> filtered{ 0 };
+};
+
+// Thin layer over the vkCmd* state setters of one command buffer. It shadows the bound
+// pipelines, descriptor sets, vertex and index buffers, viewports, scissors and push
+// constants, and drops calls that would set what is already set. A recorder starts from
+// unknown state, so it lives as long as the recording of its command buffer and no longer.
+class CommandRecorder
+{
+public:
+	static const uint32_t MaxDescriptorSets = 8;
+	static const uint32_t MaxDynamicOffsets = 8;
+	static const uint32_t MaxVertexBindings = 16;
+	static const uint32_t MaxViewports = 4;
+	static const uint32_t MaxPushConstantRanges = 4;
+	static const uint32_t MaxPushConstantSize = 256;
+
+	CommandRecorder(VkCommandBuffer commandBuffer, CommandRecorderStats* stats = nullptr);
+	~CommandRecorder();
+
+	VkCommandBuffer GetCommandBuffer() const { return commandBuffer; }
+
+	// pipelines that bake viewport and scissor in overwrite the dynamic values, say so here.
+	// The layout is the pipeline's, binding it under another layout forgets the push constants
+	void BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline, VkPipelineLayout layout, bool dynamicViewportScissor = true);
+	void BindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount, const VkDescriptorSet* sets, uint32_t dynamicOffsetCount = 0, const uint32_t* dynamicOffsets = nullptr);
+	void BindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets);
+	void BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+	void SetViewport(uint32_t firstViewport, uint32_t viewportCount, const VkViewport* viewports);
+	void SetScissor(uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* scissors);
+	void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values);
+
+	// draws pass straight through, they never repeat state
+	void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+
+	// forget all shadowed state, e.g. after commands recorded around the recorder
+	void Invalidate();
+
+	// hands the counts to the stats, also done on destruction
+	void Flush();
+
+	uint64_t GetIssuedCount() const { return issued; }
+	uint64_t GetFilteredCount() const { return filtered; }
+
+private:
+	struct BoundSet
+	{
+		VkDescriptorSet set;
+		uint32_t dynamicOffsetCount;
+		uint32_t dynamicOffsets[MaxDynamicOffsets];
+	};
+
+	struct BindPointState
+	{
+		VkPipeline pipeline;
+		VkPipelineLayout layout;
+		BoundSet sets[MaxDescriptorSets];
+	};
+
+	// push constants move in 4 byte words, one bit per word of pushData marks it known
+	struct PushConstantStages
+	{
+		VkShaderStageFlags stageFlags;
+		uint64_t knownWords;
+	};
+
+	VkCommandBuffer commandBuffer;
+	CommandRecorderStats* stats;
+
+	// graphics and compute
+	BindPointState bindPoints[2];
+
+	VkBuffer vertexBuffers[MaxVertexBindings];
+	VkDeviceSize vertexOffsets[MaxVertexBindings];
+
+	VkBuffer indexBuffer;
+	VkDeviceSize indexOffset;
+	VkIndexType indexType;
+
+	// viewportCount and scissorCount are how many leading entries are known
+	VkViewport viewports[MaxViewports];
+	VkRect2D scissors[MaxViewports];
+	uint32_t viewportCount;
+	uint32_t scissorCount;
+
+	VkPipelineLayout pushLayout;
+	PushConstantStages pushStages[MaxPushConstantRanges];
+	uint32_t pushStageCount;
+	uint8_t pushData[MaxPushConstantSize];
+
+	uint64_t issued = 0;
+	uint64_t filtered = 0;
+
+	// push constants are disturbed by a pipeline or descriptor set bound under a layout
+	// that is not compatible, which without the layouts' ranges is any other layout
+	void SwitchPushLayout(VkPipelineLayout layout);
+};
+
+#endif // !COMMAND_RECORDER_HEADER
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef DESCRIPTOR_ALLOCATOR_HEADER
+#define DESCRIPTOR_ALLOCATOR_HEADER
+
+#include <vector>
+#include <iostream>
+
+#include "VKFW.h"
+
+// Allocates descriptor sets from chains of pools, one chain per (frame, thread, layout class).
+// A layout class describes the descriptor mix of a family of similar layouts, pools of a
+// class are sized for it. A chain grows by a new, larger pool whenever the current one runs
+// out, and BeginFrame resets all of a frame's pools at once instead of freeing sets.
+class DescriptorAllocator
+{
+public:
+	static const uint32_t InitialSetsPerPool = 64;
+	static const uint32_t MaxSetsPerPool = 4096;
+
+	struct ClassStats
+	{
+		uint64_t frameAllocations = 0;
+		uint64_t totalAllocations = 0;
+		uint32_t poolCount = 0;
+		uint32_t setsAllocated = 0;
+		uint32_t setCapacity = 0;
+	};
+
+	DescriptorAllocator();
+	~DescriptorAllocator();
+
+	// pool flags apply to every pool, FREE_DESCRIPTOR_SET_BIT for allocators that free sets
+	void Create(uint32_t frameCount, uint32_t threadCount, VkDescriptorPoolCreateFlags poolFlags = 0);
+	void Destroy();
+
+	// descriptorsPerSet is the largest count of each descriptor type a set of the class uses
+	uint32_t RegisterLayoutClass(const std::vector<VkDescriptorPoolSize> &descriptorsPerSet);
+
+	void BeginFrame(uint32_t frameIndex);
+
+	// the pool the set came from is returned through sourcePool, Free needs it
+	VkDescriptorSet Allocate(uint32_t threadIndex, uint32_t layoutClass, VkDescriptorSetLayout layout, VkDescriptorPool* sourcePool = nullptr);
+
+	// only valid with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, for long-lived sets
+	void Free(uint32_t threadIndex, uint32_t layoutClass, VkDescriptorPool pool, VkDescriptorSet set);
+
+	ClassStats GetStats(uint32_t layoutClass) const;
+	void PrintStats(std::ostream &stream) const;
+
+	uint32_t GetLayoutClassCount() const { return (uint32_t)layoutClasses.size(); }
+
+private:
+	struct Pool
+	{
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		uint32_t maxSets = 0;
+		uint32_t allocatedSets = 0;
+	};
+
+	struct PoolChain
+	{
+		std::vector<Pool> pools;
+		uint32_t current = 0;
+
+		uint64_t frameAllocations = 0;
+		uint64_t totalAllocations = 0;
+	};
+
+	std::vector<std::vector<VkDescriptorPoolSize>> layoutClasses;
+
+	// indexed by frame, then thread, then layout class
+	std::vector<std::vector<PoolChain>> chains;
+
+	uint32_t frameCount = 0;
+	uint32_t threadCount = 0;
+	uint32_t frameIndex = 0;
+
+	VkDescriptorPoolCreateFlags poolFlags = 0;
+
+	PoolChain& GetChain(uint32_t frame, uint32_t thread, uint32_t layoutClass);
+	const PoolChain& GetChain(uint32_t frame, uint32_t thread, uint32_t layoutClass) const;
+
+	Pool CreatePool(uint32_t layoutClass, uint32_t maxSets);
+};
+
+#endif // !DESCRIPTOR_ALLOCATOR_HEADER
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef DESCRIPTOR_BINDER_HEADER
+#define DESCRIPTOR_BINDER_HEADER
+
+#include <vector>
+
+#include "VKFW.h"
+#include "DescriptorAllocator.h"
+
+// One binding call for transient per-draw descriptors, backed by whichever update path
+// the device offers for each layout: push descriptors through an update template, plain
+// push descriptors, a per-frame set filled from an update template, or a per-frame set
+// filled from VkWriteDescriptorSet arrays. Callers always hand over the same flat array
+// of DescriptorInfo, one element per descriptor in binding order.
+class DescriptorBinder
+{
+public:
+	enum Strategy
+	{
+		StrategyWrites,
+		StrategyTemplate,
+		StrategyPush,
+		StrategyPushTemplate,
+		StrategyCount
+	};
+
+	union DescriptorInfo
+	{
+		VkDescriptorImageInfo image;
+		VkDescriptorBufferInfo buffer;
+		VkBufferView texelBuffer;
+	};
+
+	DescriptorBinder();
+	~DescriptorBinder();
+
+	// sets for the non-push strategies come from the per-frame allocator
+	void Create(DescriptorAllocator* allocator);
+	void Destroy();
+
+	static const char* GetStrategyName(Strategy strategy);
+	bool IsStrategySupported(Strategy strategy) const;
+
+	// picks the fastest supported strategy no faster than preferred, the returned id stands for the layout
+	uint32_t CreateLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings, Strategy preferred = StrategyPushTemplate);
+
+	// set layout to build pipeline layouts from, push layouts cannot share pipeline layouts with the others
+	VkDescriptorSetLayout GetSetLayout(uint32_t layoutId) const { return layouts[layoutId].setLayout; }
+	Strategy GetStrategy(uint32_t layoutId) const { return layouts[layoutId].strategy; }
+	uint32_t GetDescriptorCount(uint32_t layoutId) const { return layouts[layoutId].descriptorCount; }
+
+	// template strategies need this once the first pipeline layout using the set layout exists,
+	// push templates are tied to it and later pipeline layouts only have to be compatible
+	void CreateUpdateTemplate(uint32_t layoutId, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set);
+
+	// data holds GetDescriptorCount(layoutId) elements, threadIndex picks the allocator chain
+	void Bind(VkCommandBuffer commandBuffer, uint32_t threadIndex, uint32_t layoutId, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set, const DescriptorInfo* data);
+
+private:
+	struct Layout
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		uint32_t descriptorCount = 0;
+
+		Strategy strategy = StrategyWrites;
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		VkDescriptorUpdateTemplateKHR updateTemplate = VK_NULL_HANDLE;
+		uint32_t layoutClass = 0;
+	};
+
+	DescriptorAllocator* allocator = nullptr;
+
+	std::vector<Layout> layouts;
+
+	bool hasTemplates = false;
+	bool hasPush = false;
+	uint32_t maxPushDescriptors = 0;
+
+	VkDescriptorSet AllocateSet(uint32_t threadIndex, const Layout &layout);
+	uint32_t BuildWrites(const Layout &layout, VkDescriptorSet set, const DescriptorInfo* data);
+};
+
+#endif // !DESCRIPTOR_BINDER_HEADER
\ No newline at end of file
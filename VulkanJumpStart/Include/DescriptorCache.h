@@ -0,0 +1,114 @@
+#ifndef DESCRIPTOR_CACHE_HEADER
+#define DESCRIPTOR_CACHE_HEADER
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <iostream>
+
+#include "VKFW.h"
+#include "DescriptorAllocator.h"
+
+// Everything a descriptor set points at. Used both to write a set and as the cache key,
+// so the same bindings must be added in the same order to hit the same entry.
+class DescriptorSetContents
+{
+public:
+	void Clear();
+
+	void SetBuffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t arrayElement = 0);
+	void SetImage(uint32_t binding, VkDescriptorType type, VkSampler sampler, VkImageView view, VkImageLayout layout, uint32_t arrayElement = 0);
+	void SetTexelBuffer(uint32_t binding, VkDescriptorType type, VkBufferView view, uint32_t arrayElement = 0);
+
+	uint64_t Hash() const;
+	bool operator ==(const DescriptorSetContents &rhs) const;
+
+	bool References(uint64_t handle) const;
+
+	void Write(VkDescriptorSet set) const;
+
+private:
+	struct Entry
+	{
+		uint32_t binding;
+		uint32_t arrayElement;
+		VkDescriptorType type;
+		uint32_t infoIndex;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<VkDescriptorBufferInfo> bufferInfos;
+	std::vector<VkDescriptorImageInfo> imageInfos;
+	std::vector<VkBufferView> texelBufferViews;
+};
+
+// Returns an existing descriptor set for identical (layout, contents) pairs instead of
+// allocating and rewriting one. Sets unused for evictAfterFrames frames are freed, which
+// must be at least the number of frames in flight.
+class DescriptorCache
+{
+public:
+	struct Stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		uint32_t size = 0;
+	};
+
+	DescriptorCache();
+	~DescriptorCache();
+
+	void Create(uint32_t evictAfterFrames);
+	void Destroy();
+
+	uint32_t RegisterLayoutClass(const std::vector<VkDescriptorPoolSize> &descriptorsPerSet);
+
+	// safe to call from several recording jobs at once
+	VkDescriptorSet Get(uint32_t layoutClass, VkDescriptorSetLayout layout, const DescriptorSetContents &contents);
+
+	// drops every set pointing at a buffer, image view, sampler or buffer view about to be destroyed
+	void Invalidate(uint64_t handle);
+
+	void BeginFrame();
+
+	Stats GetStats() const;
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	struct Entry
+	{
+		VkDescriptorSetLayout layout;
+		DescriptorSetContents contents;
+
+		VkDescriptorSet set;
+		VkDescriptorPool pool;
+		uint32_t layoutClass;
+		uint64_t lastUsedFrame;
+	};
+
+	struct RetiredSet
+	{
+		VkDescriptorSet set;
+		VkDescriptorPool pool;
+		uint32_t layoutClass;
+		uint64_t retiredFrame;
+	};
+
+	DescriptorAllocator allocator;
+
+	// keyed by hash, entries whose hashes collide share a bucket
+	std::unordered_map<uint64_t, std::vector<Entry>> entries;
+	uint32_t entryCount = 0;
+
+	std::vector<RetiredSet> retired;
+
+	mutable std::mutex mutex;
+
+	uint64_t frameNumber = 0;
+	uint32_t evictAfterFrames = 0;
+
+	Stats stats;
+};
+
+#endif // !DESCRIPTOR_CACHE_HEADER
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef DRAW_LIST_HEADER
+#define DRAW_LIST_HEADER
+
+#include <atomic>
+#include <vector>
+
+#include "VKFW.h"
+#include "JobSystem.h"
+#include "CommandContext.h"
+#include "CommandRecorder.h"
+
+// Draws collected for a frame, each with a 64-bit sort key. Sorting the keys before
+// recording groups draws by state and orders them front to back inside a group.
+// Opaque keys, from the most significant bits down:
+//   layer 4 | pass 4 | pipeline 16 | material 16 | depth 24
+// Translucent keys trade state grouping for back to front order:
+//   layer 4 | pass 4 | inverted depth 24 | pipeline 16 | material 16
+class DrawList
+{
+public:
+	static const uint32_t DepthBits = 24;
+	static const uint32_t MaxDepth = (1u << DepthBits) - 1;
+
+	// below this many draws a single thread beats the fan-out
+	static const uint32_t ParallelSortThreshold = 16384;
+
+	struct Draw
+	{
+		VkPipeline pipeline;
+		VkPipelineLayout pipelineLayout;
+		VkDescriptorSet materialSet;
+
+		VkBuffer vertexBuffer;
+		VkDeviceSize vertexBufferOffset;
+		// without an index buffer indexCount vertices are drawn from vertexOffset
+		VkBuffer indexBuffer;
+		VkDeviceSize indexBufferOffset;
+		VkIndexType indexType;
+
+		uint32_t indexCount;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t firstInstance;
+	};
+
+	struct SortItem
+	{
+		uint64_t key;
+		uint32_t drawIndex;
+	};
+
+	static uint64_t MakeOpaqueKey(uint32_t layer, uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth);
+	static uint64_t MakeTranslucentKey(uint32_t layer, uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth);
+
+	// maps view depth between the planes to the key's depth range, nearer is smaller
+	static uint32_t QuantizeDepth(float viewDepth, float nearPlane, float farPlane);
+
+	DrawList();
+	~DrawList();
+
+	// Add never grows the list, so it has to be reserved for the frame's worst case,
+	// instanceDataSize is the fixed size of the per-instance data draws may carry
+	void Reserve(uint32_t capacity, uint32_t instanceDataSize = 0);
+	void Clear();
+
+	// safe to call from several culling jobs at once. Draws with instance data are single
+	// instances the InstanceBatcher may merge, the data is copied
+	void Add(uint64_t key, const Draw &draw, const void* instanceData = nullptr);
+
+	// stable parallel LSD radix sort of the keys, one byte per pass,
+	// passes where every key has the same byte are skipped
+	void Sort(JobSystem &jobSystem);
+
+	uint32_t GetCount() const { return count.load(std::memory_order_relaxed); }
+	uint32_t GetCapacity() const { return (uint32_t)draws.size(); }
+	const SortItem* GetSortedItems() const { return items.data(); }
+
+	const Draw& GetDraw(uint32_t drawIndex) const { return draws[drawIndex]; }
+	// nullptr for draws added without instance data
+	const void* GetInstanceData(uint32_t drawIndex) const;
+	uint32_t GetInstanceDataSize() const { return instanceDataSize; }
+
+	// records draws [begin, end) of the sorted list, the recorder drops the state they share
+	void Record(CommandRecorder &recorder, uint32_t begin, uint32_t end) const;
+
+	// splits the sorted list into ranges of drawsPerTask for CommandContext::RecordParallel
+	void AppendRecordTasks(std::vector<CommandContext::RecordFunc> &tasks, uint32_t drawsPerTask) const;
+
+private:
+	static const uint32_t RadixBits = 8;
+	static const uint32_t RadixSize = 1 << RadixBits;
+	static const uint32_t PassCount = 64 / RadixBits;
+
+	std::vector<Draw> draws;
+	std::vector<uint8_t> hasInstanceData;
+	std::vector<uint8_t> instanceData;
+	uint32_t instanceDataSize = 0;
+
+	std::vector<SortItem> items;
+	std::vector<SortItem> scratch;
+	std::atomic<uint32_t> count{ 0 };
+
+	// per chunk digit counts, turned into scatter offsets in place
+	std::vector<uint32_t> histograms;
+
+	void SortSerial(uint32_t itemCount);
+};
+
+#endif // !DRAW_LIST_HEADER
\ No newline at end of file
@@ -0,0 +1,140 @@
+#ifndef FRAME_PACER_HEADER
+#define FRAME_PACER_HEADER
+
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <iostream>
+
+#include "VKFW.h"
+#include "FrameRing.h"
+#include "Profiler.h"
+
+// Decides when the CPU starts a frame. Unlimited starts as soon as the frame ring has a free
+// context, Limit caps the frame rate, and JustInTime holds the start back so the frame is
+// submitted just as the GPU runs out of work rather than queueing behind the frames in
+// flight, which keeps the input sampled at the start fresh without leaving the GPU idle.
+// The GPU timeline is modelled from submit times and the GPU time of recent frames, and
+// pinned to the real completion whenever a fence wait shows it. With VK_KHR_present_wait
+// the time each frame reached the display is measured as well, and JustInTime keeps at
+// most one frame queued for presentation.
+class FramePacer
+{
+public:
+	enum Mode
+	{
+		ModeUnlimited,
+		ModeLimit,
+		ModeJustInTime,
+	};
+
+	struct Stats
+	{
+		uint64_t frames = 0;
+		double sleepSeconds = 0.0;
+		double presentWaitSeconds = 0.0;
+
+		// from the start of a frame, when its input is sampled, to its GPU completion and
+		// to it reaching the display
+		double maxLatencySeconds = 0.0;
+		double maxPresentLatencySeconds = 0.0;
+	};
+
+	FramePacer();
+	~FramePacer();
+
+	// targetFrameRate caps the frame rate in any mode, 0 for no cap
+	void Create(FrameRing &frameRing, Mode mode, double targetFrameRate, Profiler &sink);
+
+	// right after FrameRing::BeginFrame: takes note of the frames that completed and sleeps
+	// until the frame should start, the frame's input is sampled after it
+	void BeginFrame(const FrameRing::FrameContext &context);
+
+	// right after the frame was submitted and presented, gpuSeconds being the GPU time of
+	// the latest frame read back, 0 when unknown
+	void EndFrame(double gpuSeconds);
+
+	// the id to chain into the frame's present through VkPresentIdKHR, 0 without present ids
+	uint64_t GetPresentId() const;
+	void OnPresent(VkSwapchainKHR swapchain, uint64_t presentId);
+
+	// before a retired swapchain is handed over for destruction, its presents are never
+	// waited on after this
+	void OnSwapchainRetired(VkSwapchainKHR swapchain);
+
+	static bool IsPresentIdSupported();
+	static bool IsPresentWaitSupported();
+
+	Stats GetStats() const { return stats; }
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// the share of the GPU frame time, and the minimum, left as slack for the CPU to be late
+	static constexpr double MarginFraction = 0.1;
+	static constexpr double MinMarginSeconds = 0.0005;
+
+	// weight of the newest sample in the CPU and GPU time averages
+	static constexpr double AverageWeight = 0.1;
+
+	// JustInTime gives up on a present after this long, e.g. while the window is minimized
+	static const uint64_t PresentWaitTimeout = 100000000;
+
+	// presents never seen, e.g. while minimized, are dropped past this many
+	static const size_t MaxPendingPresents = 16;
+
+	struct Frame
+	{
+		// submitted, its completion not seen yet
+		bool pending = false;
+
+		Clock::time_point start;
+		Clock::time_point gpuDone;
+	};
+
+	// a present not seen on the display yet, kept apart from the frame slots since FIFO and
+	// mailbox may still hold it when its frame context comes around again
+	struct PendingPresent
+	{
+		uint64_t presentId;
+		VkSwapchainKHR swapchain;
+		Clock::time_point start;
+	};
+
+	void Complete(Frame &frame, Clock::time_point done, bool exact);
+	void WaitForPresents();
+
+	// takes the presents that reached the display off the queue, without blocking
+	void PollPresents();
+
+	FrameRing* frameRing = nullptr;
+	Profiler* sink = nullptr;
+
+	Mode mode = ModeUnlimited;
+	double frameInterval = 0.0;
+
+	std::vector<Frame> frames;
+	uint32_t current = 0;
+
+	// in present order, a present being seen means every earlier one to its swapchain was
+	std::deque<PendingPresent> presents;
+
+	double cpuSeconds = 0.0;
+	double gpuSeconds = 0.0;
+
+	// when the GPU is expected to run out of submitted work
+	Clock::time_point gpuFree;
+	Clock::time_point lastStart;
+
+	uint64_t nextPresentId = 1;
+	uint64_t lastPresentId = 0;
+	VkSwapchainKHR lastSwapchain = VK_NULL_HANDLE;
+
+	// the first id presented to lastSwapchain, ids before it were never presented there
+	uint64_t firstPresentId = 0;
+
+	Stats stats;
+};
+
+#endif // !FRAME_PACER_HEADER
\ No newline at end of file
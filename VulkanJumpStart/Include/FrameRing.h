@@ -0,0 +1,90 @@
+#ifndef FRAME_RING_HEADER
+#define FRAME_RING_HEADER
+
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <iostream>
+
+#include "VKFW.h"
+
+// The frames in flight, two or three of them used round robin. Each frame context owns the
+// fence its submission signals, the semaphores tying it to a swapchain image and the
+// objects whose destruction has to wait until the GPU is done with the frame. The command
+// pools, upload ring regions and descriptor pools of a frame stay in their systems, which
+// take the context's index. BeginFrame only waits for the frame submitted frameCount
+// frames ago, so the CPU records one frame while the GPU works through the others.
+class FrameRing
+{
+public:
+	static const uint32_t MinFrameCount = 2;
+	static const uint32_t MaxFrameCount = 3;
+
+	struct FrameContext
+	{
+		uint32_t index = 0;
+		uint64_t frameNumber = 0;
+
+		VkFence fence = VK_NULL_HANDLE;
+
+		// how long the last BeginFrame blocked on the fence, the GPU finished the context's
+		// previous frame right at the end of it whenever it is above zero
+		double fenceWaitSeconds = 0.0;
+
+		// signalled by the swapchain when the frame's image is ready, and by the frame's
+		// last submission for presentation to wait on
+		VkSemaphore imageAvailable = VK_NULL_HANDLE;
+		VkSemaphore renderFinished = VK_NULL_HANDLE;
+
+		// run once the fence has passed, in the order they were deferred
+		std::vector<std::function<void()>> deletions;
+	};
+
+	struct Stats
+	{
+		uint64_t frames = 0;
+
+		// time BeginFrame spent on fences, the CPU running ahead of the GPU
+		double fenceWaitSeconds = 0.0;
+		double maxFenceWaitSeconds = 0.0;
+	};
+
+	FrameRing();
+	~FrameRing();
+
+	void Create(uint32_t frameCount);
+
+	// the device must be idle, pending deletions run first
+	void Destroy();
+
+	// waits for the context's previous frame, resets its fence and runs its deletions
+	FrameContext& BeginFrame();
+
+	// moves on to the next context, after the frame was submitted with its fence
+	void EndFrame();
+
+	// destroy runs once the frame being recorded has completed, safe to call from any thread
+	void Defer(std::function<void()> destroy);
+
+	// runs every pending deletion, the device must be idle
+	void Flush();
+
+	FrameContext& GetCurrent() { return contexts[current]; }
+	FrameContext& GetContext(uint32_t index) { return contexts[index]; }
+	uint32_t GetFrameCount() const { return (uint32_t)contexts.size(); }
+
+	Stats GetStats() const { return stats; }
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	std::vector<FrameContext> contexts;
+	uint32_t current = 0;
+	uint64_t frameNumber = 0;
+
+	// guards the deletion lists, frames are only begun and ended from one thread
+	std::mutex mutex;
+
+	Stats stats;
+};
+
+#endif // !FRAME_RING_HEADER
\ No newline at end of file
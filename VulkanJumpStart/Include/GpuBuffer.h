@@ -0,0 +1,33 @@
+#ifndef GPU_BUFFER_HEADER
+#define GPU_BUFFER_HEADER
+
+#include "VKFW.h"
+
+// A VkBuffer with its own dedicated allocation. Host visible buffers stay mapped
+// for their whole lifetime, GetMapped returns nullptr for everything else.
+class GpuBuffer
+{
+public:
+	GpuBuffer();
+	~GpuBuffer();
+
+	// preferred properties are only taken when a memory type has them on top of the required ones
+	void Create(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred = 0);
+	void Destroy();
+
+	// makes device writes visible to mapped reads, nothing to do for host coherent memory
+	void InvalidateMapped();
+
+	VkBuffer GetBuffer() const { return buffer; }
+	VkDeviceSize GetSize() const { return size; }
+	void* GetMapped() const { return mapped; }
+
+private:
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize size = 0;
+	void* mapped = nullptr;
+	bool coherent = false;
+};
+
+#endif // !GPU_BUFFER_HEADER
\ No newline at end of file
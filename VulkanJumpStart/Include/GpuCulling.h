@@ -0,0 +1,109 @@
+#ifndef GPU_CULLING_HEADER
+#define GPU_CULLING_HEADER
+
+#include <vector>
+
+#include "VKFW.h"
+#include "GpuBuffer.h"
+#include "PipelineCache.h"
+#include "ShaderBundle.h"
+
+// GPU-driven drawing of large instance sets. Instance bounds and draw parameters live in
+// a GPU buffer, a compute pass frustum culls them and writes VkDrawIndexedIndirectCommand
+// records plus a visible count, and one indirect call draws the survivors. The CPU only
+// touches instances when they change. Each frame in flight owns its own buffers.
+class GpuCulling
+{
+public:
+	static const uint32_t GroupSize = 64;
+
+	// must match Instance in Shaders/Cull.comp. instanceId reaches the vertex shader as
+	// gl_InstanceIndex through firstInstance, to fetch whatever else the instance needs
+	struct Instance
+	{
+		float sphere[4];
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t instanceId;
+	};
+
+	// from best to worst, the count variants skip culled slots entirely
+	enum DrawPath
+	{
+		DrawPathCountKHR,
+		DrawPathCountAMD,
+		DrawPathMultiDraw,
+		DrawPathSingleDraws
+	};
+
+	GpuCulling();
+	~GpuCulling();
+
+	// indirect draws carrying a non-zero firstInstance need drawIndirectFirstInstance
+	static bool IsSupported();
+
+	// called from the main thread, the pipeline comes from its cache
+	void Create(uint32_t maxInstances, uint32_t frameCount, PipelineCache &pipelineCache, const ShaderBundle &shaders, const char* shaderName = "Cull.comp");
+	void Destroy();
+
+	// the frame's fence must have been waited on, its buffers may still be in use otherwise
+	void UpdateInstances(uint32_t frameIndex, const Instance* instances, uint32_t count);
+
+	// planes as (normal, distance) pointing inwards, from a column-major view projection matrix
+	static void ExtractFrustumPlanes(const float viewProjection[16], float planes[6][4]);
+
+	// records the culling dispatch, outside of a render pass. Syncing its results with the
+	// draws and the readback of the count is the caller's, through the buffers below
+	void Cull(VkCommandBuffer commandBuffer, uint32_t frameIndex, const float planes[6][4]);
+
+	// records the indirect draws inside the render pass, pipeline and geometry already bound
+	void Draw(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+	// the instances as written by UpdateInstances, indexed by instanceId, are read by Cull.
+	// It clears and writes the draw records and the count, Draw reads them as indirect arguments
+	const GpuBuffer& GetInstanceBuffer(uint32_t frameIndex) const { return frames[frameIndex].instances; }
+	const GpuBuffer& GetDrawBuffer(uint32_t frameIndex) const { return frames[frameIndex].draws; }
+	const GpuBuffer& GetDrawCountBuffer(uint32_t frameIndex) const { return frames[frameIndex].drawCount; }
+
+	uint32_t GetInstanceCount(uint32_t frameIndex) const { return frames[frameIndex].instanceCount; }
+	uint32_t GetMaxInstances() const { return maxInstances; }
+
+	// what the GPU found visible when the frame last ran, valid once its fence signaled
+	uint32_t GetVisibleCount(uint32_t frameIndex) const;
+
+	DrawPath GetDrawPath() const { return drawPath; }
+
+private:
+	struct PushConstants
+	{
+		float planes[6][4];
+		uint32_t instanceCount;
+		uint32_t compact;
+	};
+
+	struct FrameResources
+	{
+		GpuBuffer instances;
+		GpuBuffer draws;
+		GpuBuffer drawCount;
+
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		uint32_t instanceCount = 0;
+	};
+
+	std::vector<FrameResources> frames;
+
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	uint32_t maxInstances = 0;
+	DrawPath drawPath = DrawPathSingleDraws;
+
+	void CreatePipeline(PipelineCache &pipelineCache, const ShaderBundle &shaders, const char* shaderName);
+	void CreateDescriptorSets();
+};
+
+#endif // !GPU_CULLING_HEADER
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef HASH_HEADER
+#define HASH_HEADER
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 64-bit FNV-1a, stable across runs so hashes can also key on-disk data
+
+const uint64_t HashSeed = 14695981039346656037ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = HashSeed)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// meant for scalars and handles, structs with padding must be hashed field by field
+template<typename T>
+inline uint64_t HashValue(const T &value, uint64_t hash)
+{
+	return HashBytes(&value, sizeof(T), hash);
+}
+
+#endif // !HASH_HEADER
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef HEADLESS_TARGET_HEADER
+#define HEADLESS_TARGET_HEADER
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "VKFW.h"
+#include "GpuBuffer.h"
+#include "PresentTarget.h"
+
+// Offscreen rendering without a window or surface. Each frame context has its own image
+// and a host visible readback buffer the frame copies the image into; once the context
+// comes around again its fence has passed and the pixels are written out, so readback
+// never stalls the frames in flight. PNG frames render to RGBA8, EXR frames to RGBA16F,
+// as <outputDirectory>/frame_<number>.<png|exr>. Headless mode skips the window and surface
+// at run time on Windows, and is the only mode of the Linux build from CMakeLists.txt.
+class HeadlessTarget : public PresentTarget
+{
+public:
+	enum Output
+	{
+		// read back but not written, to time the readback alone
+		OutputNone,
+		OutputPng,
+		OutputExr,
+	};
+
+	struct Stats
+	{
+		uint64_t frames = 0;
+		uint64_t writtenFrames = 0;
+		uint64_t readbackBytes = 0;
+		double writeSeconds = 0.0;
+	};
+
+	HeadlessTarget();
+	~HeadlessTarget();
+
+	void Create(FrameRing &frameRing, uint32_t width, uint32_t height, Output output, const char* outputDirectory);
+
+	// the device must be idle, frames not written yet are dropped
+	void Destroy();
+
+	// writes the frames still waiting in their readback buffers, the device must be idle
+	void Flush();
+
+	// writes out the context's previous frame, its fence has passed
+	bool Acquire(const FrameRing::FrameContext &context) override;
+	RenderGraph::Resource Import(RenderGraph &graph) override;
+
+	// copies the image into the context's readback buffer
+	void AddFinalPasses(RenderGraph &graph, RenderGraph::Resource image) override;
+
+	// nothing to wait for, the frame's fence covers the readback
+	VkSemaphore GetAcquireSemaphore(const FrameRing::FrameContext &) const override { return VK_NULL_HANDLE; }
+	VkSemaphore GetPresentSemaphore(const FrameRing::FrameContext &) const override { return VK_NULL_HANDLE; }
+
+	void Present(const FrameRing::FrameContext &context, uint64_t presentId) override;
+
+	VkFormat GetFormat() const override { return format; }
+	VkExtent2D GetExtent() const override { return extent; }
+
+	Stats GetStats() const { return stats; }
+	void PrintStats(std::ostream &stream) const override;
+
+private:
+	struct Slot
+	{
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		GpuBuffer readback;
+
+		// presented and not written out yet
+		bool pending = false;
+		uint64_t frameNumber = 0;
+	};
+
+	void Write(Slot &slot);
+
+	// GpuBuffer is not copyable, the slots are created once and never move
+	std::vector<Slot> slots;
+	uint32_t current = 0;
+
+	Output output = OutputNone;
+	std::string outputDirectory;
+
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	VkExtent2D extent = {};
+	uint32_t pixelSize = 0;
+
+	Stats stats;
+};
+
+#endif // !HEADLESS_TARGET_HEADER
\ No newline at end of file
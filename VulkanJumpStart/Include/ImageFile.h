@@ -0,0 +1,21 @@
+#ifndef IMAGE_FILE_HEADER
+#define IMAGE_FILE_HEADER
+
+#include <stdint.h>
+#include <vector>
+
+// Writers for frames read back from the GPU, uncompressed so they stay simple and fast and
+// compare byte for byte. PNG takes 8 bit RGBA in stored deflate blocks, OpenEXR takes half
+// float RGBA as NO_COMPRESSION scanlines. Rows are tightly packed, top row first.
+class ImageFile
+{
+public:
+	// throw when the file cannot be written
+	static void WritePng(const char* path, uint32_t width, uint32_t height, const uint8_t* rgba);
+	static void WriteExr(const char* path, uint32_t width, uint32_t height, const uint16_t* rgbaHalf);
+
+private:
+	static void WriteFile(const char* path, const std::vector<uint8_t> &data);
+};
+
+#endif // !IMAGE_FILE_HEADER
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef INSTANCE_BATCHER_HEADER
+#define INSTANCE_BATCHER_HEADER
+
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+
+#include "VKFW.h"
+#include "DrawList.h"
+#include "UploadRing.h"
+#include "CommandContext.h"
+#include "CommandRecorder.h"
+
+// Turns the sorted draw list into fewer, instanced draws. Inside every run of draws with
+// the same key above the depth bits (same layer, pass, pipeline and material for opaque
+// keys) draws that carry instance data and share a mesh become a single draw. Their
+// instance data is packed into the frame's upload ring, one block for the whole frame
+// bound at instanceBinding, and firstInstance picks each batch's slice of it.
+// Translucent draws should be added without instance data, they pass through in order.
+class InstanceBatcher
+{
+public:
+	struct Stats
+	{
+		uint64_t inputDraws = 0;
+		uint64_t outputDraws = 0;
+		uint64_t instances = 0;
+	};
+
+	InstanceBatcher();
+	~InstanceBatcher();
+
+	void Create(uint32_t maxDraws, uint32_t instanceBinding);
+	void Destroy();
+
+	void Build(const DrawList &drawList, UploadRing &uploadRing);
+
+	uint32_t GetCount() const { return (uint32_t)batches.size(); }
+
+	// records batches [begin, end), same contract as DrawList::Record
+	void Record(CommandRecorder &recorder, uint32_t begin, uint32_t end) const;
+	void AppendRecordTasks(std::vector<CommandContext::RecordFunc> &tasks, uint32_t drawsPerTask) const;
+
+	const Stats& GetStats() const { return stats; }
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	static const uint32_t NoMember = ~0u;
+
+	// everything that has to match for two draws to share an instanced draw
+	struct MeshKey
+	{
+		VkPipeline pipeline;
+		VkDescriptorSet materialSet;
+		VkBuffer vertexBuffer;
+		VkDeviceSize vertexBufferOffset;
+		VkBuffer indexBuffer;
+		VkDeviceSize indexBufferOffset;
+		VkIndexType indexType;
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+
+		uint64_t Hash() const;
+		bool operator ==(const MeshKey &rhs) const;
+	};
+
+	struct MeshKeyHasher
+	{
+		size_t operator ()(const MeshKey &key) const { return (size_t)key.Hash(); }
+	};
+
+	// a batch with instances lists its draws through memberNext, starting at firstMember
+	struct Batch
+	{
+		DrawList::Draw draw;
+		uint32_t firstMember;
+		uint32_t lastMember;
+	};
+
+	uint32_t instanceBinding = 0;
+
+	std::vector<Batch> batches;
+	std::vector<uint32_t> memberNext;
+
+	// batches of the current run by mesh, cleared between runs
+	std::unordered_map<MeshKey, uint32_t, MeshKeyHasher> runBatches;
+
+	VkBuffer instanceBuffer = VK_NULL_HANDLE;
+	VkDeviceSize instanceOffset = 0;
+
+	Stats stats;
+};
+
+#endif // !INSTANCE_BATCHER_HEADER
\ No newline at end of file
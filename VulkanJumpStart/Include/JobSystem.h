@@ -0,0 +1,152 @@
+#ifndef JOB_SYSTEM_HEADER
+#define JOB_SYSTEM_HEADER
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <iostream>
+
+#include "VKFW.h"
+
+struct Job;
+struct JobFiber;
+
+// Counts outstanding jobs. Jobs queued behind a counter start once it drops to zero,
+// fibers parked on it are resumed at the same point.
+struct JobCounter
+{
+	std::atomic<int32_t> value{ 0 };
+
+	std::mutex mutex;
+	std::vector<Job*> continuations;
+	std::vector<JobFiber*> waitingFibers;
+
+	// the first exception thrown by one of the counter's jobs, WaitForCounter rethrows it
+	std::exception_ptr exception;
+};
+
+struct Job
+{
+	std::function<void()> entry;
+	JobCounter* counter = nullptr;
+};
+
+// Chase-Lev work-stealing deque. The owning worker pushes and pops at the bottom,
+// any other worker steals from the top.
+class WorkStealingQueue
+{
+public:
+	static const int64_t Capacity = 4096;
+
+	bool Push(Job* job);
+	Job* Pop();
+	Job* Steal();
+
+private:
+	std::atomic<int64_t> top{ 0 };
+	std::atomic<int64_t> bottom{ 0 };
+	std::atomic<Job*> jobs[Capacity];
+};
+
+struct WorkerStats
+{
+	uint64_t jobsExecuted = 0;
+	uint64_t jobsStolen = 0;
+	uint64_t busyNanoseconds = 0;
+	uint64_t idleNanoseconds = 0;
+};
+
+class JobSystem
+{
+public:
+	JobSystem();
+	~JobSystem();
+
+	static const uint32_t FiberCount = 128;
+	static const size_t FiberStackSize = 256 * 1024;
+
+	// worker 0 is the thread calling Create, the remaining workers get their own thread.
+	// With fibers, jobs on workers 1..n run on pooled fibers and a job waiting on a
+	// counter parks its fiber instead of holding the worker. Worker 0 keeps its own
+	// stack so the main thread never migrates, and helps out while it waits instead.
+	void Create(uint32_t workerCount, bool pinThreads, bool useFibers = false);
+	void Destroy();
+
+	void Run(std::function<void()> entry, JobCounter* counter, JobCounter* dependency = nullptr);
+
+	// splits [0, count) into batches and runs them as individual jobs
+	void ParallelFor(uint32_t count, uint32_t batchSize, std::function<void(uint32_t, uint32_t)> entry, JobCounter* counter, JobCounter* dependency = nullptr);
+
+	// yields the fiber, or executes other jobs, until the counter reaches zero.
+	// Rethrows the first exception any of the counter's jobs threw
+	void WaitForCounter(JobCounter* counter);
+
+	uint32_t GetWorkerCount() const { return (uint32_t)workers.size(); }
+	bool IsUsingFibers() const { return useFibers; }
+	static uint32_t GetWorkerIndex();
+
+	const WorkerStats& GetStats(uint32_t worker) const { return workers[worker]->stats; }
+	void ResetStats();
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	static const uint32_t JobRingSize = 8192;
+
+	struct Worker
+	{
+		WorkStealingQueue queue;
+		WorkerStats stats;
+
+		std::vector<Job> jobRing;
+		uint32_t jobRingCursor = 0;
+
+		std::thread thread;
+		uint32_t rngState = 0;
+
+		FiberHandle threadFiber = nullptr;
+		JobFiber* currentFiber = nullptr;
+
+		// set right before a switch, resolved by the fiber switched to
+		JobFiber* switchedFiber = nullptr;
+		JobCounter* switchedCounter = nullptr;
+	};
+
+	std::vector<Worker*> workers;
+
+	bool useFibers = false;
+	std::vector<JobFiber*> fibers;
+
+	std::mutex fiberMutex;
+	std::vector<JobFiber*> freeFibers;
+	std::vector<JobFiber*> readyFibers;
+	std::atomic<int32_t> readyFiberCount{ 0 };
+
+	std::atomic<bool> running{ false };
+	std::atomic<int32_t> queuedJobs{ 0 };
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+
+	Job* AllocateJob();
+	void Submit(Job* job);
+	void Finish(Job* job);
+
+	Job* FindJob(Worker &worker);
+	void Execute(Job* job);
+	void Sleep();
+
+	JobFiber* PopFiber(std::vector<JobFiber*> &list);
+	void MakeReady(const std::vector<JobFiber*> &ready);
+	void SwitchFiber(JobFiber* to, JobCounter* waitCounter);
+	void CompleteSwitch();
+
+	void WorkerMain(uint32_t index, bool pinThread);
+	void FiberLoop();
+	static void FIBER_CALL FiberMain(void* param);
+};
+
+#endif // !JOB_SYSTEM_HEADER
\ No newline at end of file
@@ -1,14 +1,517 @@
 #ifndef OS_HEADER
 #define OS_HEADER
 
+#include <stdint.h>
+#include <string>
+#include <vector>
+
 #ifdef VK_USE_PLATFORM_WIN32_KHR
 	#define LoadProcAddress GetProcAddress
+#else
+	#include <dlfcn.h>
+
+	#define LoadProcAddress dlsym
 #endif // VK_USE_PLATFORM_WIN32_KHR
 
 #ifdef VK_USE_PLATFORM_WIN32_KHR
 	typedef HMODULE LibraryHandle;
+#else
+	typedef void* LibraryHandle;
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+// nullptr when the library cannot be found or loaded
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	inline LibraryHandle OSLoadLibrary(const char* name)
+	{
+		return LoadLibraryA(name);
+	}
+#else
+	inline LibraryHandle OSLoadLibrary(const char* name)
+	{
+		return dlopen(name, RTLD_NOW | RTLD_LOCAL);
+	}
 #endif // VK_USE_PLATFORM_WIN32_KHR
 
 //LibraryHandle VulkanLibrary;
 
+// moves from over to, replacing an existing file in one step so readers never see a partial one
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	inline bool OSReplaceFile(const char* from, const char* to)
+	{
+		return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+	}
+#else
+	#include <stdio.h>
+
+	inline bool OSReplaceFile(const char* from, const char* to)
+	{
+		return rename(from, to) == 0;
+	}
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	inline void PinCurrentThread(uint32_t core)
+	{
+		SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (core % (sizeof(DWORD_PTR) * 8)));
+	}
+#else
+	#include <pthread.h>
+	#include <sched.h>
+
+	inline void PinCurrentThread(uint32_t core)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(core % CPU_SETSIZE, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+// Read-only view of a whole file, the pages load on first touch and stay shared with the
+// file cache instead of being copied into the process
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	struct MappedFile
+	{
+		const void* data;
+		size_t size;
+		HANDLE file;
+		HANDLE mapping;
+	};
+
+	inline bool OSMapFile(const char* path, MappedFile* mappedFile)
+	{
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0
+			? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+			: nullptr;
+
+		const void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+		if (!data)
+		{
+			if (mapping)
+				CloseHandle(mapping);
+
+			CloseHandle(file);
+			return false;
+		}
+
+		mappedFile->data = data;
+		mappedFile->size = (size_t)size.QuadPart;
+		mappedFile->file = file;
+		mappedFile->mapping = mapping;
+		return true;
+	}
+
+	inline void OSUnmapFile(MappedFile* mappedFile)
+	{
+		UnmapViewOfFile(mappedFile->data);
+		CloseHandle(mappedFile->mapping);
+		CloseHandle(mappedFile->file);
+	}
+
+	// regular files only, names relative to the directory
+	inline bool OSListDirectory(const char* path, std::vector<std::string> &fileNames)
+	{
+		WIN32_FIND_DATAA data;
+		HANDLE find = FindFirstFileA((std::string(path) + "\\*").c_str(), &data);
+
+		if (find == INVALID_HANDLE_VALUE)
+			return false;
+
+		do
+		{
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				fileNames.push_back(data.cFileName);
+		} while (FindNextFileA(find, &data));
+
+		FindClose(find);
+		return true;
+	}
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <dirent.h>
+	#include <unistd.h>
+
+	struct MappedFile
+	{
+		const void* data;
+		size_t size;
+	};
+
+	inline bool OSMapFile(const char* path, MappedFile* mappedFile)
+	{
+		int descriptor = open(path, O_RDONLY | O_CLOEXEC);
+		if (descriptor < 0)
+			return false;
+
+		struct stat status;
+		void* data = fstat(descriptor, &status) == 0 && status.st_size > 0
+			? mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, descriptor, 0)
+			: MAP_FAILED;
+
+		// the mapping keeps the file alive on its own
+		close(descriptor);
+
+		if (data == MAP_FAILED)
+			return false;
+
+		mappedFile->data = data;
+		mappedFile->size = (size_t)status.st_size;
+		return true;
+	}
+
+	inline void OSUnmapFile(MappedFile* mappedFile)
+	{
+		munmap((void*)mappedFile->data, mappedFile->size);
+	}
+
+	// regular files only, names relative to the directory
+	inline bool OSListDirectory(const char* path, std::vector<std::string> &fileNames)
+	{
+		DIR* directory = opendir(path);
+		if (!directory)
+			return false;
+
+		while (const dirent* entry = readdir(directory))
+		{
+			struct stat status;
+			std::string fullPath = std::string(path) + "/" + entry->d_name;
+
+			if (stat(fullPath.c_str(), &status) == 0 && S_ISREG(status.st_mode))
+				fileNames.push_back(entry->d_name);
+		}
+
+		closedir(directory);
+		return true;
+	}
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+// Runs a program with the given arguments and waits for it to exit. No shell is involved,
+// so arguments pass through as they are. Returns the exit code, -1 if it could not run
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	inline int OSRunProcess(const std::vector<std::string> &arguments)
+	{
+		// every argument quoted the way the C runtime splits the command line again
+		std::string commandLine;
+		for (const std::string &argument : arguments)
+		{
+			if (!commandLine.empty())
+				commandLine += ' ';
+
+			commandLine += '"';
+
+			// backslashes are only special in front of a quote
+			size_t backslashes = 0;
+			for (char c : argument)
+			{
+				if (c == '\\')
+				{
+					backslashes++;
+					continue;
+				}
+
+				commandLine.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+				commandLine += c;
+				backslashes = 0;
+			}
+
+			commandLine.append(backslashes * 2, '\\');
+			commandLine += '"';
+		}
+
+		STARTUPINFOA startupInfo = {};
+		startupInfo.cb = sizeof(startupInfo);
+
+		PROCESS_INFORMATION processInfo = {};
+
+		// without an application name the program is searched for like the shell would
+		if (!CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo))
+			return -1;
+
+		WaitForSingleObject(processInfo.hProcess, INFINITE);
+
+		DWORD exitCode = (DWORD)-1;
+		GetExitCodeProcess(processInfo.hProcess, &exitCode);
+
+		CloseHandle(processInfo.hThread);
+		CloseHandle(processInfo.hProcess);
+		return (int)exitCode;
+	}
+#else
+	#include <spawn.h>
+	#include <sys/wait.h>
+	#include <errno.h>
+
+	extern char** environ;
+
+	inline int OSRunProcess(const std::vector<std::string> &arguments)
+	{
+		std::vector<char*> argv;
+		for (const std::string &argument : arguments)
+			argv.push_back((char*)argument.c_str());
+
+		argv.push_back(nullptr);
+
+		pid_t pid;
+		if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0)
+			return -1;
+
+		int status;
+		while (waitpid(pid, &status, 0) < 0)
+		{
+			if (errno != EINTR)
+				return -1;
+		}
+
+		return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	}
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+// Reports files created or rewritten in a directory, not its subdirectories. Names are
+// relative to the directory, the same file may be reported several times per save.
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	struct DirectoryWatch
+	{
+		HANDLE directory;
+		OVERLAPPED overlapped;
+		// DWORD aligned, as ReadDirectoryChangesW requires
+		DWORD buffer[4096];
+	};
+
+	inline bool OSArmDirectoryWatch(DirectoryWatch* watch)
+	{
+		return ReadDirectoryChangesW(watch->directory, watch->buffer, sizeof(watch->buffer), FALSE,
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr, &watch->overlapped, nullptr) != 0;
+	}
+
+	inline DirectoryWatch* OSCreateDirectoryWatch(const char* path)
+	{
+		HANDLE directory = CreateFileA(path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+
+		if (directory == INVALID_HANDLE_VALUE)
+			return nullptr;
+
+		DirectoryWatch* watch = new DirectoryWatch();
+		watch->directory = directory;
+		watch->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+
+		if (!OSArmDirectoryWatch(watch))
+		{
+			CloseHandle(watch->overlapped.hEvent);
+			CloseHandle(directory);
+			delete watch;
+			return nullptr;
+		}
+
+		return watch;
+	}
+
+	inline void OSDestroyDirectoryWatch(DirectoryWatch* watch)
+	{
+		CancelIo(watch->directory);
+		CloseHandle(watch->overlapped.hEvent);
+		CloseHandle(watch->directory);
+		delete watch;
+	}
+
+	// waits up to timeoutMs for changes and appends the changed file names
+	inline void OSReadDirectoryChanges(DirectoryWatch* watch, uint32_t timeoutMs, std::vector<std::string> &fileNames)
+	{
+		if (WaitForSingleObject(watch->overlapped.hEvent, timeoutMs) != WAIT_OBJECT_0)
+			return;
+
+		DWORD size = 0;
+		bool completed = GetOverlappedResult(watch->directory, &watch->overlapped, &size, FALSE) != 0;
+		ResetEvent(watch->overlapped.hEvent);
+
+		// a zero size means the buffer overflowed and the changes are lost
+		for (size_t offset = 0; completed && size > 0;)
+		{
+			const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)((const char*)watch->buffer + offset);
+
+			if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+			{
+				int wideLength = (int)(info->FileNameLength / sizeof(WCHAR));
+				int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, nullptr, 0, nullptr, nullptr);
+
+				std::string name(length, '\0');
+				WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, &name[0], length, nullptr, nullptr);
+				fileNames.push_back(name);
+			}
+
+			if (info->NextEntryOffset == 0)
+				break;
+
+			offset += info->NextEntryOffset;
+		}
+
+		OSArmDirectoryWatch(watch);
+	}
+#else
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+
+	struct DirectoryWatch
+	{
+		int descriptor;
+		int watchDescriptor;
+	};
+
+	inline DirectoryWatch* OSCreateDirectoryWatch(const char* path)
+	{
+		int descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (descriptor < 0)
+			return nullptr;
+
+		// editors either rewrite in place or write a new file and move it over the old one
+		int watchDescriptor = inotify_add_watch(descriptor, path, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (watchDescriptor < 0)
+		{
+			close(descriptor);
+			return nullptr;
+		}
+
+		return new DirectoryWatch{ descriptor, watchDescriptor };
+	}
+
+	inline void OSDestroyDirectoryWatch(DirectoryWatch* watch)
+	{
+		close(watch->descriptor);
+		delete watch;
+	}
+
+	// waits up to timeoutMs for changes and appends the changed file names
+	inline void OSReadDirectoryChanges(DirectoryWatch* watch, uint32_t timeoutMs, std::vector<std::string> &fileNames)
+	{
+		pollfd descriptor = { watch->descriptor, POLLIN, 0 };
+
+		if (poll(&descriptor, 1, (int)timeoutMs) <= 0)
+			return;
+
+		alignas(inotify_event) char buffer[4096];
+
+		ssize_t size;
+		while ((size = read(watch->descriptor, buffer, sizeof(buffer))) > 0)
+		{
+			for (ssize_t offset = 0; offset < size;)
+			{
+				const inotify_event* event = (const inotify_event*)(buffer + offset);
+
+				if (event->len > 0 && !(event->mask & IN_ISDIR))
+					fileNames.push_back(event->name);
+
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+// Minimal fiber layer for the job system, Win32 fibers or ucontext elsewhere.
+// The entry point must never return, a fiber is left by switching to another one.
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	#define FIBER_CALL WINAPI
+
+	typedef LPVOID FiberHandle;
+	typedef void (FIBER_CALL *FiberEntry)(void*);
+
+	inline FiberHandle OSConvertThreadToFiber()
+	{
+		return ConvertThreadToFiber(nullptr);
+	}
+
+	inline void OSConvertFiberToThread(FiberHandle)
+	{
+		ConvertFiberToThread();
+	}
+
+	inline FiberHandle OSCreateFiber(size_t stackSize, FiberEntry entry, void* param)
+	{
+		return CreateFiber(stackSize, entry, param);
+	}
+
+	inline void OSDeleteFiber(FiberHandle fiber)
+	{
+		DeleteFiber(fiber);
+	}
+
+	inline void OSSwitchFiber(FiberHandle, FiberHandle to)
+	{
+		SwitchToFiber(to);
+	}
+#else
+	#include <ucontext.h>
+	#include <stdlib.h>
+
+	#define FIBER_CALL
+
+	typedef void (FIBER_CALL *FiberEntry)(void*);
+
+	struct FiberContext
+	{
+		ucontext_t context;
+		void* stack;
+		FiberEntry entry;
+		void* param;
+	};
+
+	typedef FiberContext* FiberHandle;
+
+	// makecontext only forwards int arguments, so the context pointer is split in two
+	inline void OSFiberTrampoline(unsigned int high, unsigned int low)
+	{
+		FiberHandle fiber = (FiberHandle)(((uintptr_t)high << 16 << 16) | (uintptr_t)low);
+		fiber->entry(fiber->param);
+	}
+
+	inline FiberHandle OSConvertThreadToFiber()
+	{
+		FiberHandle fiber = new FiberContext();
+		fiber->stack = nullptr;
+		return fiber;
+	}
+
+	inline void OSConvertFiberToThread(FiberHandle fiber)
+	{
+		delete fiber;
+	}
+
+	inline FiberHandle OSCreateFiber(size_t stackSize, FiberEntry entry, void* param)
+	{
+		FiberHandle fiber = new FiberContext();
+		fiber->stack = malloc(stackSize);
+		fiber->entry = entry;
+		fiber->param = param;
+
+		getcontext(&fiber->context);
+		fiber->context.uc_stack.ss_sp = fiber->stack;
+		fiber->context.uc_stack.ss_size = stackSize;
+		fiber->context.uc_link = nullptr;
+
+		uintptr_t address = (uintptr_t)fiber;
+		makecontext(&fiber->context, (void(*)())OSFiberTrampoline, 2, (unsigned int)(address >> 16 >> 16), (unsigned int)address);
+
+		return fiber;
+	}
+
+	inline void OSDeleteFiber(FiberHandle fiber)
+	{
+		free(fiber->stack);
+		delete fiber;
+	}
+
+	inline void OSSwitchFiber(FiberHandle from, FiberHandle to)
+	{
+		swapcontext(&from->context, &to->context);
+	}
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
 #endif // !OS_HEADER
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef PIPELINE_CACHE_HEADER
+#define PIPELINE_CACHE_HEADER
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+
+#include "VKFW.h"
+#include "Profiler.h"
+
+// VkPipelineCache persisted to disk between runs. The file is only handed to the driver
+// when its header matches the selected physical device, and only the merged cache is seeded
+// from it, so the loaded data is held once. A warm cache is mostly lookups, served by the
+// driver's own locking of the merged cache, while a cold one spends its time compiling and
+// every thread gets an empty cache of its own so creation never contends on one cache.
+// Saving merges the thread caches and replaces the file in one rename.
+class PipelineCache
+{
+public:
+	enum LoadResult
+	{
+		LoadMissing,
+		LoadAccepted,
+		LoadRejected
+	};
+
+	PipelineCache();
+	~PipelineCache();
+
+	// a saveIntervalSeconds of zero only saves when Save is called
+	void Create(const char* path, uint32_t threadCount, double saveIntervalSeconds, Profiler &profiler);
+	void Destroy();
+
+	// the cache pipelines created on the thread go through
+	VkPipelineCache GetThreadCache(uint32_t threadIndex) const { return loadResult == LoadAccepted ? mergedCache : threadCaches[threadIndex]; }
+
+	// creation through the thread's cache, timed into the profiler split by warm and cold cache
+	VkPipeline CreateGraphicsPipeline(uint32_t threadIndex, const VkGraphicsPipelineCreateInfo &createInfo);
+	VkPipeline CreateComputePipeline(uint32_t threadIndex, const VkComputePipelineCreateInfo &createInfo);
+
+	// saves once the interval has passed since the last save, call once per frame
+	void Update();
+
+	// skips the write when the merged cache has not grown since the last save. A failed write
+	// is logged and returns false, the cache stays in memory and the next save tries again
+	bool Save();
+
+	LoadResult GetLoadResult() const { return loadResult; }
+
+private:
+	std::string path;
+	double saveIntervalSeconds = 0.0;
+	Profiler* profiler = nullptr;
+
+	LoadResult loadResult = LoadMissing;
+
+	// the thread caches are merged into mergedCache, which is what gets written
+	std::vector<VkPipelineCache> threadCaches;
+	VkPipelineCache mergedCache = VK_NULL_HANDLE;
+
+	size_t savedSize = 0;
+	std::chrono::steady_clock::time_point lastSave;
+	std::mutex saveMutex;
+
+	static bool IsCompatible(const std::vector<char> &data);
+
+	VkPipelineCache CreateCache(const std::vector<char> &initialData);
+	const char* GetCreationSection() const;
+};
+
+#endif // !PIPELINE_CACHE_HEADER
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef PIPELINE_COMPILER_HEADER
+#define PIPELINE_COMPILER_HEADER
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+
+#include "VKFW.h"
+#include "PipelineDesc.h"
+#include "PipelineCache.h"
+
+// A pipeline that may still be compiling. Update picks up the result once it is ready and
+// Get returns the fallback until then, a VK_NULL_HANDLE fallback means the draws using
+// it are skipped. Does not own either pipeline.
+class AsyncPipeline
+{
+public:
+	AsyncPipeline();
+	AsyncPipeline(std::shared_future<VkPipeline> future, VkPipeline fallback = VK_NULL_HANDLE);
+
+	// once per frame before recording starts, from a single thread. Rethrows creation errors
+	void Update();
+
+	// safe from any recording job between Updates
+	VkPipeline Get() const { return pipeline != VK_NULL_HANDLE ? pipeline : fallback; }
+	bool IsReady() const { return pipeline != VK_NULL_HANDLE; }
+
+	// blocks until the compile is done, for the few pipelines needed before the first frame
+	VkPipeline Wait();
+
+	// swaps in a rebuilt pipeline between frames, the previous one is still the owner's to destroy
+	void Replace(VkPipeline pipeline);
+
+	// what Get returns until the compile is done, also between frames
+	void SetFallback(VkPipeline fallback) { this->fallback = fallback; }
+
+private:
+	std::shared_future<VkPipeline> future;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkPipeline fallback = VK_NULL_HANDLE;
+};
+
+// Dedicated threads that create pipelines off the frame's critical path. Creation blocks
+// for milliseconds to tens of milliseconds at a time, so it does not go through the job
+// system where it would hold workers the frame is waiting on. Each thread creates through
+// its own pipeline cache, threads use caches firstCacheThread and up.
+class PipelineCompiler
+{
+public:
+	PipelineCompiler();
+	~PipelineCompiler();
+
+	void Create(PipelineCache &pipelineCache, uint32_t threadCount, uint32_t firstCacheThread);
+
+	// requests still queued resolve to VK_NULL_HANDLE
+	void Destroy();
+
+	// the pipeline belongs to the caller once the future is ready. Before Create or after
+	// Destroy the future holds an error instead of waiting forever
+	std::shared_future<VkPipeline> Compile(PipelineDesc desc);
+
+	uint32_t GetPendingCount() const;
+
+private:
+	struct Request
+	{
+		PipelineDesc desc;
+		std::promise<VkPipeline> promise;
+	};
+
+	PipelineCache* pipelineCache = nullptr;
+
+	std::vector<std::thread> threads;
+	std::deque<Request> queue;
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+
+	// also set while not created, nothing would take requests off the queue
+	bool stopping = true;
+
+	void ThreadMain(uint32_t cacheThread);
+};
+
+#endif // !PIPELINE_COMPILER_HEADER
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef PIPELINE_DESC_HEADER
+#define PIPELINE_DESC_HEADER
+
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "VKFW.h"
+#include "PipelineCache.h"
+
+struct ShaderStageDesc
+{
+	VkShaderStageFlagBits stage;
+	// not owned, has to outlive every pipeline creation from the description
+	VkShaderModule module;
+	// the SPIR-V the module was created from. When set, stages match by code instead of by
+	// handle, so a module recreated from the same code finds the existing pipeline
+	std::shared_ptr<const std::vector<uint32_t>> code;
+	// hash of the code, zero without code
+	uint64_t moduleHash;
+	std::string entryPoint;
+
+	std::vector<VkSpecializationMapEntry> specializationEntries;
+	std::vector<uint8_t> specializationData;
+};
+
+// Everything needed to create a graphics or compute pipeline, held by value with no pointers
+// into the caller's memory, so a description can be queued and compiled on another thread.
+// Defaults describe an opaque, depth tested, back face culled triangle list, color
+// attachments have to be added. Viewport and scissor are always dynamic.
+class PipelineDesc
+{
+public:
+	PipelineDesc();
+
+	void AddStage(VkShaderStageFlagBits stage, VkShaderModule module, std::shared_ptr<const std::vector<uint32_t>> code = nullptr, const char* entryPoint = "main");
+
+	// adds a specialization constant to the most recently added stage
+	void SetSpecialization(uint32_t constantId, const void* data, size_t size);
+
+	// adds a specialization constant to every stage in stageMask
+	void SetSpecialization(VkShaderStageFlags stageMask, uint32_t constantId, const void* data, size_t size);
+
+	void AddVertexBinding(uint32_t binding, uint32_t stride, VkVertexInputRate inputRate);
+	void AddVertexAttribute(uint32_t location, uint32_t binding, VkFormat format, uint32_t offset);
+
+	// blending disabled and all channels written unless a state is given
+	void AddColorAttachment();
+	void AddColorAttachment(const VkPipelineColorBlendAttachmentState &state);
+
+	// matches the pipeline against render passes by compatibility instead of by handle
+	void SetRenderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo &createInfo);
+
+	VkPipeline Create(PipelineCache &pipelineCache, uint32_t threadIndex) const;
+
+	// covers everything that changes the resulting pipeline, render passes by compatibility
+	// when one was set through SetRenderPass
+	uint64_t Hash() const;
+	bool operator ==(const PipelineDesc &rhs) const;
+
+	// the parts of a render pass that decide compatibility in the sense of the spec, load and
+	// store ops and layouts are left out. Compatible render passes give equal descriptions
+	static std::vector<uint32_t> DescribeRenderPassCompatibility(const VkRenderPassCreateInfo &createInfo);
+	static uint64_t HashRenderPassCompatibility(const VkRenderPassCreateInfo &createInfo);
+
+	VkPipelineBindPoint bindPoint;
+	VkPipelineLayout layout;
+	std::vector<ShaderStageDesc> stages;
+
+	// everything below only applies to graphics pipelines
+	std::vector<VkVertexInputBindingDescription> vertexBindings;
+	std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+
+	VkPrimitiveTopology topology;
+	VkBool32 primitiveRestart;
+
+	VkBool32 depthClamp;
+	VkPolygonMode polygonMode;
+	VkCullModeFlags cullMode;
+	VkFrontFace frontFace;
+	VkBool32 depthBias;
+	float depthBiasConstant;
+	float depthBiasSlope;
+	float lineWidth;
+
+	VkSampleCountFlagBits samples;
+	VkBool32 alphaToCoverage;
+
+	VkBool32 depthTest;
+	VkBool32 depthWrite;
+	VkCompareOp depthCompare;
+	VkBool32 stencilTest;
+	VkStencilOpState stencilFront;
+	VkStencilOpState stencilBack;
+
+	std::vector<VkPipelineColorBlendAttachmentState> colorAttachments;
+	float blendConstants[4];
+
+	// on top of viewport and scissor
+	std::vector<VkDynamicState> dynamicStates;
+
+	// the pipeline is usable with any render pass compatible with this one
+	VkRenderPass renderPass;
+	uint64_t renderPassHash;
+	std::vector<uint32_t> renderPassCompatibility;
+	uint32_t subpass;
+
+private:
+	VkPipeline CreateGraphics(PipelineCache &pipelineCache, uint32_t threadIndex, const VkPipelineShaderStageCreateInfo* stageInfos) const;
+};
+
+#endif // !PIPELINE_DESC_HEADER
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef PIPELINE_LAYOUT_CACHE_HEADER
+#define PIPELINE_LAYOUT_CACHE_HEADER
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <iostream>
+
+#include "VKFW.h"
+#include "ShaderReflection.h"
+
+// Builds descriptor set and pipeline layouts from shader reflection instead of by hand.
+// The stages of a pipeline are merged, each binding only lists the stages that use it and
+// push constants become a single range, and every layout is created once per distinct
+// content and shared from then on. Owns all the layouts it returns.
+class PipelineLayoutCache
+{
+public:
+	struct Layout
+	{
+		VkPipelineLayout pipelineLayout;
+		// one per set up to the highest one used, unused sets get an empty layout
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		// per set, what DescriptorAllocator::RegisterLayoutClass takes
+		std::vector<std::vector<VkDescriptorPoolSize>> setPoolSizes;
+	};
+
+	struct Stats
+	{
+		uint64_t requests = 0;
+		uint64_t hits = 0;
+		uint32_t setLayouts = 0;
+		uint32_t pipelineLayouts = 0;
+	};
+
+	PipelineLayoutCache();
+	~PipelineLayoutCache();
+
+	void Destroy();
+
+	// fixedSetLayouts entries that are not VK_NULL_HANDLE replace the reflected set, e.g. for
+	// the bindless heap whose runtime sized arrays reflection cannot size. The returned
+	// layout stays valid until Destroy, safe to call from any thread
+	const Layout& Get(const std::vector<const ShaderReflection*> &stages, const std::vector<VkDescriptorSetLayout> &fixedSetLayouts = {});
+
+	VkDescriptorSetLayout GetSetLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings);
+
+	Stats GetStats() const;
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	struct SetLayoutEntry
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		VkDescriptorSetLayout layout;
+	};
+
+	struct PipelineLayoutEntry
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		VkPushConstantRange pushConstants;
+		Layout layout;
+	};
+
+	// keyed by hash, entries whose hashes collide share a bucket. Get hands out references
+	// to pipeline layout entries, so their bucket is a list that never moves them
+	std::unordered_map<uint64_t, std::vector<SetLayoutEntry>> setLayouts;
+	std::unordered_map<uint64_t, std::list<PipelineLayoutEntry>> pipelineLayouts;
+
+	mutable std::mutex mutex;
+
+	Stats stats;
+};
+
+#endif // !PIPELINE_LAYOUT_CACHE_HEADER
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef PIPELINE_REGISTRY_HEADER
+#define PIPELINE_REGISTRY_HEADER
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <future>
+#include <iostream>
+
+#include "VKFW.h"
+#include "PipelineDesc.h"
+#include "PipelineCompiler.h"
+
+// Owns every pipeline created through it and hands out the existing one for an identical
+// description, compiled or still compiling, so materials resolving to the same state share
+// one pipeline. Descriptions are compared in full after the hash matches.
+class PipelineRegistry
+{
+public:
+	struct Stats
+	{
+		uint64_t requests = 0;
+		uint64_t hits = 0;
+		uint32_t size = 0;
+	};
+
+	PipelineRegistry();
+	~PipelineRegistry();
+
+	void Create(PipelineCompiler &compiler);
+
+	// waits for pipelines still compiling, then destroys everything
+	void Destroy();
+
+	// safe to call from any thread
+	AsyncPipeline Get(const PipelineDesc &desc, VkPipeline fallback = VK_NULL_HANDLE);
+
+	Stats GetStats() const;
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	struct Entry
+	{
+		PipelineDesc desc;
+		std::shared_future<VkPipeline> future;
+	};
+
+	PipelineCompiler* compiler = nullptr;
+
+	// keyed by hash, entries whose hashes collide share a bucket
+	std::unordered_map<uint64_t, std::vector<Entry>> entries;
+
+	mutable std::mutex mutex;
+
+	Stats stats;
+};
+
+#endif // !PIPELINE_REGISTRY_HEADER
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef PRESENT_TARGET_HEADER
+#define PRESENT_TARGET_HEADER
+
+#include <iostream>
+
+#include "VKFW.h"
+#include "FrameRing.h"
+#include "RenderGraph.h"
+
+// Where frames end up, the window's swapchain or offscreen images read back to files. A
+// frame calls Acquire after FrameRing::BeginFrame, Import once the render graph is reset,
+// AddFinalPasses after declaring its own passes, submits waiting on the acquire semaphore
+// and signalling the present semaphore, and finally calls Present.
+class PresentTarget
+{
+public:
+	virtual ~PresentTarget() {}
+
+	// false when there is nothing to draw to, the frame then skips the rest
+	virtual bool Acquire(const FrameRing::FrameContext &context) = 0;
+
+	// the acquired image as a graph resource, drawn to as a color attachment
+	virtual RenderGraph::Resource Import(RenderGraph &graph) = 0;
+
+	// passes that have to follow everything drawing to the image
+	virtual void AddFinalPasses(RenderGraph &, RenderGraph::Resource) {}
+
+	// VK_NULL_HANDLE when the target needs no semaphore
+	virtual VkSemaphore GetAcquireSemaphore(const FrameRing::FrameContext &context) const = 0;
+	virtual VkSemaphore GetPresentSemaphore(const FrameRing::FrameContext &context) const = 0;
+
+	// after the frame was submitted, presentId is 0 unless the swapchain uses present ids
+	virtual void Present(const FrameRing::FrameContext &context, uint64_t presentId) = 0;
+
+	virtual VkFormat GetFormat() const = 0;
+	virtual VkExtent2D GetExtent() const = 0;
+
+	virtual void PrintStats(std::ostream &stream) const = 0;
+};
+
+#endif // !PRESENT_TARGET_HEADER
\ No newline at end of file
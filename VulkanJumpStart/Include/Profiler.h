@@ -0,0 +1,48 @@
+#ifndef PROFILER_HEADER
+#define PROFILER_HEADER
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+
+// Named CPU timings, accumulated per name in the order names first appear. Meant for
+// coarse, one-off work such as startup and resource creation, not per-frame hot paths.
+class Profiler
+{
+public:
+	// times its own lifetime into a section
+	class Scope
+	{
+	public:
+		Scope(Profiler &profiler, const char* name);
+		~Scope();
+
+	private:
+		Profiler &profiler;
+		const char* name;
+		std::chrono::high_resolution_clock::time_point start;
+	};
+
+	Profiler();
+	~Profiler();
+
+	// safe to call from any thread
+	void Add(const char* name, double seconds);
+
+	void Print(std::ostream &stream) const;
+
+private:
+	struct Section
+	{
+		std::string name;
+		double seconds;
+		uint32_t count;
+	};
+
+	std::vector<Section> sections;
+	mutable std::mutex mutex;
+};
+
+#endif // !PROFILER_HEADER
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef QUEUE_PROFILER_HEADER
+#define QUEUE_PROFILER_HEADER
+
+#include <string>
+#include <vector>
+
+#include "VKFW.h"
+#include "Profiler.h"
+
+// GPU timings per queue from timestamp queries, one query pool per queue and frame in
+// flight. Results are read back once the frame's fence has passed and go into a Profiler
+// as "<queue>: <scope>" sections, next to the busy time of each queue and how much of it
+// overlapped with the other queues, which is what async compute is meant to buy.
+class QueueProfiler
+{
+public:
+	static const uint32_t MaxScopesPerQueue = 128;
+
+	QueueProfiler();
+	~QueueProfiler();
+
+	// queues on families without timestamp support are not timed
+	void Create(uint32_t frameCount, const std::vector<uint32_t> &queueFamilyIndices, const std::vector<std::string> &queueNames, Profiler &sink);
+	void Destroy();
+
+	// after the frame's fence was waited on
+	void BeginFrame(uint32_t frameIndex);
+
+	// Begin returns the scope to hand to End, InvalidScope when the queue is not timed
+	static const uint32_t InvalidScope = UINT32_MAX;
+	uint32_t Begin(VkCommandBuffer commandBuffer, uint32_t queue, const char* name);
+	void End(VkCommandBuffer commandBuffer, uint32_t scope);
+
+	// span from the first to the last timestamp of the frame BeginFrame read back, over all
+	// queues, 0 when nothing of it was timed
+	double GetFrameSeconds() const { return frameSeconds; }
+
+private:
+	struct Scope
+	{
+		uint32_t queue;
+		std::string name;
+		uint32_t query;
+	};
+
+	struct QueueFrame
+	{
+		VkQueryPool pool = VK_NULL_HANDLE;
+		uint32_t queryCount = 0;
+	};
+
+	struct Frame
+	{
+		std::vector<QueueFrame> queues;
+		std::vector<Scope> scopes;
+	};
+
+	std::vector<Frame> frames;
+	std::vector<std::string> queueNames;
+	std::vector<uint64_t> timestampMasks;
+	double timestampPeriod = 1.0;
+	uint32_t frameIndex = 0;
+	double frameSeconds = 0.0;
+
+	Profiler* sink = nullptr;
+};
+
+#endif // !QUEUE_PROFILER_HEADER
\ No newline at end of file
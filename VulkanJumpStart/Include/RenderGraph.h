@@ -0,0 +1,403 @@
+#ifndef RENDER_GRAPH_HEADER
+#define RENDER_GRAPH_HEADER
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include <iostream>
+
+#include "VKFW.h"
+#include "QueueProfiler.h"
+
+// A frame described as passes and the images and buffers each of them uses. Compile culls
+// passes nothing depends on, places the barriers and layout transitions between the passes
+// that remain, one batched vkCmdPipelineBarrier per pass at most, and wraps passes drawing
+// to attachments in a render pass whose load and store ops follow from what comes before
+// and after them. Submit records and submits the result. The graph is declared anew every
+// frame, Reset, declare, Compile, Submit, while transient images and buffers, render passes
+// and framebuffers are kept from frame to frame. Transient resources whose lifetimes do not
+// overlap share memory, and attachments that never leave a single pass go to lazily
+// allocated memory where the device has it, which tilers never back with real memory.
+//
+// Compute passes may ask for the async compute queue. Runs of consecutive passes on one
+// queue become segments, each its own command buffer and submission; a segment waits on
+// a semaphore for the segments of the other queue whose results it uses, and resources
+// changing queue family with their contents are released and acquired around that wait.
+class RenderGraph
+{
+public:
+	typedef uint32_t Resource;
+	typedef uint32_t Pass;
+	typedef std::function<void(VkCommandBuffer commandBuffer)> RecordFunc;
+
+	enum QueueType
+	{
+		QueueGraphics,
+		// falls back to the graphics queue on devices without a compute-only family
+		QueueCompute,
+		QueueCount
+	};
+
+	// returns a begun primary command buffer for the queue, the graph ends and submits it
+	typedef std::function<VkCommandBuffer(QueueType queue)> BeginFunc;
+
+	// each usage stands for fixed pipeline stages, access and image layout, see UsageInfos
+	enum Usage
+	{
+		// contents undefined, only meaningful as the initial usage of an imported resource
+		UsageNone,
+		UsageColorAttachment,
+		UsageDepthAttachment,
+		UsageDepthRead,
+		UsageSampledGraphics,
+		UsageSampledCompute,
+		UsageStorageReadGraphics,
+		UsageStorageReadCompute,
+		UsageStorageWriteCompute,
+		UsageUniformGraphics,
+		UsageUniformCompute,
+		UsageVertexBuffer,
+		UsageIndexBuffer,
+		UsageIndirectBuffer,
+		UsageTransferSrc,
+		UsageTransferDst,
+		UsageHostRead,
+		UsagePresent,
+		UsageCount
+	};
+
+	struct ImageDesc
+	{
+		VkFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels = 1;
+		uint32_t arrayLayers = 1;
+		VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+	};
+
+	// counts for the latest Compile
+	struct Stats
+	{
+		uint32_t passes = 0;
+		uint32_t culledPasses = 0;
+		uint32_t segments = 0;
+		uint32_t semaphores = 0;
+		uint32_t queueTransfers = 0;
+		uint32_t barrierBatches = 0;
+		uint32_t imageBarriers = 0;
+		uint32_t renderPasses = 0;
+		uint32_t transientImages = 0;
+		uint32_t transientBuffers = 0;
+
+		// peak transient memory, with every resource in its own allocation and aliased
+		VkDeviceSize unaliasedMemory = 0;
+		VkDeviceSize transientMemory = 0;
+		VkDeviceSize lazyMemory = 0;
+	};
+
+	RenderGraph();
+	~RenderGraph();
+
+	// transient resources are kept per frame in flight
+	void Create(uint32_t frameCount);
+
+	// the device must be idle
+	void Destroy();
+
+	// drops the passes and resources declared for the previous frame
+	void Reset();
+
+	// transient resources live for one frame and start with undefined contents
+	Resource CreateImage(const char* name, const ImageDesc &desc);
+	Resource CreateBuffer(const char* name, VkDeviceSize size);
+
+	// imported resources belong to the caller and always count as outputs. initialUsage is
+	// how the frame finds them, finalUsage how it has to leave them, UsageNone to keep
+	// whatever the last pass left
+	Resource ImportImage(const char* name, VkImage image, VkImageView view, const ImageDesc &desc, Usage initialUsage, Usage finalUsage);
+	Resource ImportBuffer(const char* name, VkBuffer buffer, VkDeviceSize size, Usage initialUsage, Usage finalUsage);
+
+	// keeps the passes producing a transient resource, for results read after the frame
+	void MarkOutput(Resource resource);
+
+	Pass AddPass(const char* name, RecordFunc record, QueueType queue = QueueGraphics);
+
+	// a pass may use a resource several ways as long as the image layouts agree, passes
+	// on the compute queue only compute and transfer usages
+	void Use(Pass pass, Resource resource, Usage usage);
+
+	// clears an attachment when the pass begins instead of loading it
+	void SetClear(Pass pass, Resource resource, const VkClearValue &value);
+
+	// never culled, for passes whose effect is outside the graph
+	void SetSideEffects(Pass pass);
+
+	// the render pass is begun for secondary command buffers, which the record function
+	// executes. They inherit GetRenderPass and GetFramebuffer and set their own viewport
+	void SetSecondaryCommandBuffers(Pass pass);
+
+	// after the frame's fence was waited on, transient resources of the frame are reused
+	void Compile(uint32_t frameIndex);
+
+	// the first graphics submission waits on waitSemaphore, the last one signals
+	// signalSemaphore and fence after joining whatever compute work is still outstanding,
+	// so the fence covers the whole frame. Either may be VK_NULL_HANDLE
+	void Submit(const BeginFunc &begin, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage,
+		VkSemaphore signalSemaphore, VkFence fence, QueueProfiler* profiler = nullptr);
+
+	// valid from Compile until the next Reset, for use while recording
+	VkImage GetImage(Resource resource) const;
+	VkImageView GetImageView(Resource resource) const;
+	VkBuffer GetBuffer(Resource resource) const;
+	VkRenderPass GetRenderPass(Pass pass) const { return passes[pass].renderPass; }
+	VkFramebuffer GetFramebuffer(Pass pass) const { return passes[pass].framebuffer; }
+	VkExtent2D GetExtent(Pass pass) const { return passes[pass].extent; }
+
+	bool IsCulled(Pass pass) const { return !passes[pass].live; }
+	bool HasAsyncCompute() const { return Vulkan.computeQueue != VK_NULL_HANDLE; }
+
+	Stats GetStats() const { return stats; }
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	struct UsageInfo
+	{
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+		VkImageLayout layout;
+		VkImageUsageFlags imageUsage;
+		VkBufferUsageFlags bufferUsage;
+		bool write;
+	};
+
+	static const UsageInfo UsageInfos[UsageCount];
+
+	struct ResourceEntry
+	{
+		std::string name;
+		bool isImage;
+		bool imported;
+		bool output;
+
+		ImageDesc imageDesc;
+		VkDeviceSize bufferSize;
+
+		Usage initialUsage;
+		Usage finalUsage;
+
+		// accumulated over the passes using it, for creating transient resources
+		VkImageUsageFlags imageUsage;
+		VkBufferUsageFlags bufferUsage;
+
+		VkImage image;
+		VkImageView view;
+		VkBuffer buffer;
+
+		// earlier transients sharing its memory, its first use waits for them
+		std::vector<Resource> aliases;
+	};
+
+	struct PassUse
+	{
+		Resource resource;
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+		VkImageLayout layout;
+		bool write;
+		bool colorAttachment;
+		bool depthAttachment;
+		bool cleared;
+
+		// filled by Compile, for the render pass load and store ops
+		bool hadContents;
+		bool usedLater;
+	};
+
+	// the barriers placed in front of a pass, recorded as a single vkCmdPipelineBarrier
+	struct BarrierBatch
+	{
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+		VkAccessFlags srcAccess = 0;
+		VkAccessFlags dstAccess = 0;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+
+		// only for queue family ownership transfers, other buffer barriers are global
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+		bool IsEmpty() const { return srcStages == 0 && dstStages == 0; }
+		void Record(VkCommandBuffer commandBuffer) const;
+	};
+
+	struct PassEntry
+	{
+		std::string name;
+		RecordFunc record;
+		std::vector<PassUse> uses;
+		std::vector<std::pair<Resource, VkClearValue>> clears;
+		bool sideEffects;
+		bool secondaryCommandBuffers;
+		bool live;
+
+		// as asked for, then as scheduled by Compile
+		QueueType queue;
+		uint32_t segment;
+
+		BarrierBatch barriers;
+		VkRenderPass renderPass;
+		VkFramebuffer framebuffer;
+		VkExtent2D extent;
+		std::vector<VkClearValue> clearValues;
+	};
+
+	// what the barriers so far have made of a resource. The stages are those of the queue
+	// owning it, lastSegment the latest segment of that queue touching it
+	struct ResourceState
+	{
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		bool hasContents = false;
+
+		QueueType queue = QueueGraphics;
+		int32_t lastSegment = -1;
+
+		VkPipelineStageFlags writeStages = 0;
+		VkAccessFlags writeAccess = 0;
+
+		// reads since the last write, later writes wait for them
+		VkPipelineStageFlags readStages = 0;
+
+		// where the last write has been made visible already
+		VkPipelineStageFlags visibleStages = 0;
+		VkAccessFlags visibleAccess = 0;
+	};
+
+	struct SegmentWait
+	{
+		uint32_t segment;
+		VkPipelineStageFlags stages;
+	};
+
+	// consecutive live passes on one queue, recorded and submitted together. release holds
+	// the ownership transfers to the other queue, recorded after the passes
+	struct Segment
+	{
+		QueueType queue;
+		std::vector<Pass> passes;
+		std::vector<SegmentWait> waits;
+		BarrierBatch release;
+	};
+
+	struct AttachmentKey
+	{
+		VkFormat format;
+		VkSampleCountFlagBits samples;
+		VkAttachmentLoadOp loadOp;
+		VkAttachmentStoreOp storeOp;
+		VkImageLayout layout;
+	};
+
+	// color attachments first, then the depth attachment when there is one
+	struct RenderPassKey
+	{
+		std::vector<AttachmentKey> attachments;
+		bool hasDepth;
+
+		uint64_t Hash() const;
+		bool operator ==(const RenderPassKey &rhs) const;
+	};
+
+	struct CachedRenderPass
+	{
+		RenderPassKey key;
+		VkRenderPass renderPass;
+	};
+
+	// placed at offset in the heap of its memory type, lazy ones own their memory
+	struct Transient
+	{
+		bool isImage;
+		bool lazy;
+		VkImage image;
+		VkImageView view;
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+
+		VkMemoryRequirements requirements;
+		uint32_t memoryType;
+		VkDeviceSize offset;
+
+		// live passes from the first to the last use, inclusive
+		uint32_t firstPass;
+		uint32_t lastPass;
+
+		// indices of earlier transients overlapping its memory
+		std::vector<uint32_t> aliases;
+	};
+
+	struct TransientHeap
+	{
+		uint32_t memoryType;
+		VkDeviceSize size;
+		VkDeviceMemory memory;
+	};
+
+	struct CachedFramebuffer
+	{
+		VkRenderPass renderPass;
+		std::vector<VkImageView> views;
+		VkExtent2D extent;
+		VkFramebuffer framebuffer;
+		bool used;
+	};
+
+	// everything a frame in flight may still be using. The transients are laid out for the
+	// graph described by layoutHash and rebuilt when a frame declares a different one
+	struct FrameResources
+	{
+		uint64_t layoutHash = 0;
+		std::vector<Transient> transients;
+		std::vector<TransientHeap> heaps;
+		std::vector<CachedFramebuffer> framebuffers;
+
+		// binary semaphores between segments, one per wait
+		std::vector<VkSemaphore> semaphores;
+	};
+
+	std::vector<ResourceEntry> resources;
+	std::vector<PassEntry> passes;
+	std::vector<Segment> segments;
+	BarrierBatch finalBarriers;
+
+	std::vector<FrameResources> frames;
+	uint32_t frameIndex = 0;
+
+	// memory of images and buffers sharing a heap has to keep this far apart
+	VkDeviceSize bufferImageGranularity = 1;
+	bool hasLazyMemory = false;
+
+	// keyed by hash, entries whose hashes collide share a bucket
+	std::unordered_map<uint64_t, std::vector<CachedRenderPass>> renderPasses;
+
+	Stats stats;
+
+	void CullPasses();
+	void AllocateTransients();
+	void CreateTransients(FrameResources &frame, const std::vector<Resource> &transientResources);
+	void DestroyTransients(FrameResources &frame);
+	void BuildSegments();
+	void PlaceBarriers();
+	void CreateRenderPasses();
+
+	void AddBarrier(BarrierBatch &batch, Resource resource, ResourceState &state, const PassUse &use, uint32_t segment);
+	void AddWait(uint32_t segment, uint32_t waitSegment, VkPipelineStageFlags stages);
+	void RecordPass(VkCommandBuffer commandBuffer, const PassEntry &pass);
+
+	VkRenderPass GetRenderPass(const RenderPassKey &key);
+	VkFramebuffer GetFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView> &views, VkExtent2D extent);
+
+	static VkImageAspectFlags GetAspectMask(VkFormat format);
+};
+
+#endif // !RENDER_GRAPH_HEADER
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef SCENE_HEADER
+#define SCENE_HEADER
+
+#include <vector>
+
+#include "VKFW.h"
+#include "GpuBuffer.h"
+#include "GpuCulling.h"
+#include "DrawList.h"
+
+// A generated scene that keeps the frame's CPU paths busy until real content is loaded:
+// grids of cubes sharing one mesh, spread a little past the clip volume of an identity
+// view projection so culling has something to reject. Objects are culled on the CPU
+// and batched through the draw list, GPU instances go through GpuCulling.
+class Scene
+{
+public:
+	struct Object
+	{
+		// world space center and radius
+		float sphere[4];
+		// column-major world matrix, added to the draw list as the draw's instance data
+		float transform[16];
+	};
+
+	Scene();
+	~Scene();
+
+	void Create(uint32_t objectCount, uint32_t gpuInstanceCount);
+	void Destroy();
+
+	uint32_t GetObjectCount() const { return (uint32_t)objects.size(); }
+	uint32_t GetGpuInstanceCount() const { return (uint32_t)gpuInstances.size(); }
+	const GpuCulling::Instance* GetGpuInstances() const { return gpuInstances.data(); }
+
+	// the shared cube, drawn with the pipeline set here. Objects culled after the call pick it up
+	const DrawList::Draw& GetMeshDraw() const { return meshDraw; }
+	void SetMeshPipeline(VkPipeline pipeline, VkPipelineLayout pipelineLayout);
+
+	// tests objects [begin, end) against the planes and adds the survivors, safe to call
+	// from several culling jobs at once
+	void Cull(DrawList &drawList, const float planes[6][4], uint32_t begin, uint32_t end) const;
+
+private:
+	GpuBuffer mesh;
+	DrawList::Draw meshDraw = {};
+
+	std::vector<Object> objects;
+	std::vector<GpuCulling::Instance> gpuInstances;
+
+	static void PlaceOnGrid(uint32_t index, uint32_t count, float depth, float sphere[4]);
+};
+
+#endif // !SCENE_HEADER
@@ -0,0 +1,89 @@
+#ifndef SHADER_BUNDLE_HEADER
+#define SHADER_BUNDLE_HEADER
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "VKFW.h"
+#include "OS.h"
+#include "ShaderReflection.h"
+
+// Every compiled shader of a directory packed into one file that is mapped rather than read.
+// Layout, all offsets from the start of the file:
+//   Header, a power of two table of Slots keyed by name hash with linear probing, one Entry
+//   per shader, the names, then each shader's SPIR-V at BlobAlignment followed by its
+//   reflection data when it was packed with reflection.
+// Shaders are named after their SPIR-V file without the .spv, e.g. "Cull.comp". Names the
+// bundle does not have, or any name when it is not open, load from looseDirectory instead.
+class ShaderBundle
+{
+public:
+	static const uint32_t Magic = 0x42534A56; // "VJSB"
+	static const uint32_t Version = 1;
+	static const uint32_t BlobAlignment = 64;
+
+	ShaderBundle();
+	~ShaderBundle();
+
+	// false when the bundle does not exist, throws when it exists but is not a valid bundle
+	bool Open(const char* path, const char* looseDirectory);
+	void Close();
+
+	bool IsOpen() const { return file.data != nullptr; }
+
+	// the words live in the mapping, valid until Close. nullptr when the bundle lacks the shader
+	const uint32_t* FindCode(const char* name, size_t* codeSize) const;
+
+	// straight from the mapping when bundled, from <looseDirectory>/<name>.spv otherwise
+	VkShaderModule CreateShaderModule(const char* name, uint64_t* codeHash = nullptr) const;
+
+	// false when the shader is not bundled or was packed without reflection
+	bool GetReflection(const char* name, ShaderReflection &reflection) const;
+
+	uint32_t GetShaderCount() const;
+
+	// offline step, packs every .spv file of directory into outputPath
+	static void Pack(const char* directory, const char* outputPath, bool includeReflection, std::ostream &stream);
+
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t shaderCount;
+		uint32_t slotCount;
+		uint64_t fileSize;
+	};
+
+	struct Slot
+	{
+		uint64_t nameHash;
+		// EmptySlot for unused slots
+		uint32_t entry;
+		uint32_t padding;
+	};
+
+	struct Entry
+	{
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint32_t codeOffset;
+		uint32_t codeSize;
+		uint32_t reflectionOffset;
+		uint32_t reflectionSize;
+	};
+
+	static const uint32_t EmptySlot = 0xFFFFFFFF;
+
+	MappedFile file = {};
+	std::string looseDirectory;
+
+	const Header* header = nullptr;
+	const Slot* slots = nullptr;
+	const Entry* entries = nullptr;
+
+	const Entry* Find(const char* name) const;
+};
+
+#endif // !SHADER_BUNDLE_HEADER
\ No newline at end of file
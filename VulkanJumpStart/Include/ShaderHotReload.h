@@ -0,0 +1,82 @@
+#ifndef SHADER_HOT_RELOAD_HEADER
+#define SHADER_HOT_RELOAD_HEADER
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <future>
+
+#include "VKFW.h"
+#include "OS.h"
+#include "PipelineDesc.h"
+#include "PipelineCompiler.h"
+#include "FrameRing.h"
+
+// Watches a shader directory, recompiles stage sources to SPIR-V as they are saved and
+// rebuilds the pipelines using them through the pipeline compiler. Compiling happens on a
+// background thread, Update swaps finished pipelines in between frames and defers the
+// destruction of the ones they replace until the frames in flight are done with them.
+// Include files (.glsl, .hlsli) recompile everything. HLSL sources are named
+// <name>.<stage>.hlsl so the stage can be told from the name.
+class ShaderHotReload
+{
+public:
+	ShaderHotReload();
+	~ShaderHotReload();
+
+	// compilerPath is a glslangValidator executable, looked up on PATH by default
+	void Create(const char* shaderDirectory, PipelineCompiler &compiler, FrameRing &frameRing, const char* compilerPath = "glslangValidator");
+
+	// the device must be idle, pipelines built by reloads are destroyed
+	void Destroy();
+
+	// stageSources holds one source path per stage of desc, in the same order, with the SPIR-V
+	// next to it as <source>.spv. target must stay alive until Destroy
+	void Watch(AsyncPipeline* target, const PipelineDesc &desc, const std::vector<std::string> &stageSources);
+
+	// at a frame boundary, before recording, from the thread driving frames
+	void Update();
+
+	bool IsWatching() const { return watch != nullptr; }
+
+private:
+	struct Watched
+	{
+		AsyncPipeline* target;
+		PipelineDesc desc;
+		std::vector<std::string> stageSources;
+
+		// the pipeline from the latest reload, the original belongs to whoever created it
+		VkPipeline owned = VK_NULL_HANDLE;
+	};
+
+	struct Rebuild
+	{
+		size_t watchedIndex;
+		std::shared_future<VkPipeline> future;
+		std::vector<VkShaderModule> modules;
+	};
+
+	std::string directory;
+	std::string compilerPath;
+
+	PipelineCompiler* compiler = nullptr;
+	FrameRing* frameRing = nullptr;
+
+	DirectoryWatch* watch = nullptr;
+	std::thread thread;
+	std::atomic<bool> stopping;
+
+	std::vector<Watched> watched;
+	std::vector<Rebuild> rebuilds;
+	std::mutex mutex;
+
+	void ThreadMain();
+
+	bool CompileSource(const std::string &fileName) const;
+	void RebuildPipelines(const std::vector<std::string> &compiledNames);
+};
+
+#endif // !SHADER_HOT_RELOAD_HEADER
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef SHADER_REFLECTION_HEADER
+#define SHADER_REFLECTION_HEADER
+
+#include <vector>
+
+#include "VKFW.h"
+
+struct ReflectedBinding
+{
+	uint32_t set;
+	uint32_t binding;
+	VkDescriptorType type;
+	// zero for runtime sized arrays
+	uint32_t count;
+	VkShaderStageFlags stages;
+};
+
+struct ReflectedVertexInput
+{
+	uint32_t location;
+	// VK_FORMAT_UNDEFINED for inputs without a matching single-location format
+	VkFormat format;
+};
+
+// What the pipeline layout and vertex input of a shader need, read straight from its SPIR-V.
+// Only the first entry point is looked at, and only the handful of instructions carrying
+// types, decorations and interface variables are decoded.
+class ShaderReflection
+{
+public:
+	ShaderReflection();
+
+	// throws on anything that is not well formed SPIR-V
+	void Parse(const std::vector<uint32_t> &code);
+
+	VkShaderStageFlagBits stage;
+
+	// sorted by set, then binding
+	std::vector<ReflectedBinding> bindings;
+
+	// size zero when the shader has no push constants
+	VkPushConstantRange pushConstants;
+
+	// vertex shaders only, sorted by location, matrices take a location per column
+	std::vector<ReflectedVertexInput> vertexInputs;
+};
+
+#endif // !SHADER_REFLECTION_HEADER
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef SHADER_VARIANTS_HEADER
+#define SHADER_VARIANTS_HEADER
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <iostream>
+
+#include "VKFW.h"
+#include "PipelineDesc.h"
+#include "PipelineCompiler.h"
+#include "PipelineRegistry.h"
+
+// The variants of one pipeline that differ only in 32-bit specialization constants: quality
+// levels, feature toggles, workgroup sizes. The shaders are compiled once and each variant
+// is a pipeline specialized from the same modules, built on first use through the registry.
+// A variant is a Key packing one value index per option, starting from GetDefaultKey.
+class ShaderVariants
+{
+public:
+	typedef uint64_t Key;
+
+	ShaderVariants();
+	~ShaderVariants();
+
+	// baseDesc carries no specialization for the declared constants, the modules have to
+	// outlive the variants
+	void Create(PipelineRegistry &registry, const PipelineDesc &baseDesc, const char* name);
+	void Destroy();
+
+	// declarations come before the first Get, each returns the option index for Set.
+	// stages are the shader stages that declare the constant
+	uint32_t AddToggle(const char* name, uint32_t constantId, VkShaderStageFlags stages, bool defaultValue = false);
+	uint32_t AddLevels(const char* name, uint32_t constantId, VkShaderStageFlags stages, uint32_t levelCount, uint32_t defaultLevel = 0);
+	uint32_t AddValues(const char* name, uint32_t constantId, VkShaderStageFlags stages, const std::vector<uint32_t> &values, uint32_t defaultIndex = 0);
+
+	uint32_t FindOption(const char* name) const;
+
+	Key GetDefaultKey() const { return defaultKey; }
+
+	// valueIndex selects from the option's values, for toggles and levels it is the value itself
+	Key Set(Key key, uint32_t option, uint32_t valueIndex) const;
+	uint32_t GetValueIndex(Key key, uint32_t option) const;
+
+	// safe from any thread, the reference stays valid until Destroy. A variant still compiling
+	// takes the fallback of the latest Get that passed one, since that changes the entry
+	// every caller shares, fallbacks are passed outside of recording
+	const AsyncPipeline& Get(Key key, VkPipeline fallback = VK_NULL_HANDLE);
+
+	// once per frame before recording, from a single thread
+	void Update();
+
+	// the product of every option's value count
+	uint64_t GetVariantCount() const;
+
+	void PrintStats(std::ostream &stream) const;
+
+private:
+	struct Option
+	{
+		std::string name;
+		uint32_t constantId;
+		VkShaderStageFlags stages;
+		std::vector<uint32_t> values;
+
+		uint32_t bitOffset;
+		uint32_t bitCount;
+	};
+
+	PipelineRegistry* registry = nullptr;
+	PipelineDesc baseDesc;
+	std::string name;
+
+	std::vector<Option> options;
+	uint32_t keyBits = 0;
+	Key defaultKey = 0;
+
+	// node based, so references handed out by Get survive later inserts
+	std::unordered_map<Key, AsyncPipeline> pipelines;
+	mutable std::mutex mutex;
+
+	PipelineDesc Specialize(Key key) const;
+};
+
+#endif // !SHADER_VARIANTS_HEADER
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef SWAPCHAIN_HEADER
+#define SWAPCHAIN_HEADER
+
+#include <vector>
+#include <iostream>
+
+#include "VKFW.h"
+#include "FrameRing.h"
+#include "FramePacer.h"
+#include "PresentTarget.h"
+
+// The window's surface and the swapchain presenting to it. The present mode is the one
+// asked for when the surface has it, with FIFO, which is always there, as the fallback, and
+// the image count is picked so the frames in flight do not stall on acquiring an image.
+// When the window is resized or the swapchain goes out of date it is recreated from the
+// old one, whose images stay valid for the frames still using them; the old swapchain and
+// its views are handed to the frame ring instead of waiting for the device to go idle.
+class Swapchain : public PresentTarget
+{
+public:
+	struct Stats
+	{
+		uint32_t recreations = 0;
+		uint32_t outOfDate = 0;
+		uint32_t suboptimal = 0;
+
+		// frames without an image to draw to, while minimized
+		uint32_t skippedFrames = 0;
+	};
+
+	Swapchain();
+	~Swapchain();
+
+	// imageCount 0 picks one to suit the present mode and the frames in flight
+	// the frame pacer hears of every swapchain retired by a recreate
+	void Create(Window &window, FrameRing &frameRing, FramePacer &framePacer, VkPresentModeKHR presentMode, uint32_t imageCount = 0);
+
+	// the device must be idle
+	void Destroy();
+
+	// acquires the frame's image, signalling the context's imageAvailable semaphore, after
+	// recreating the swapchain when the window changed. Returns false when there is
+	// nothing to draw to, the frame then neither waits on the semaphore nor presents
+	bool Acquire(const FrameRing::FrameContext &context) override;
+
+	// left for presentation when the frame completes
+	RenderGraph::Resource Import(RenderGraph &graph) override;
+
+	VkSemaphore GetAcquireSemaphore(const FrameRing::FrameContext &context) const override { return context.imageAvailable; }
+	VkSemaphore GetPresentSemaphore(const FrameRing::FrameContext &context) const override { return context.renderFinished; }
+
+	// presents the acquired image once the context's renderFinished semaphore is signalled,
+	// presentId is chained in through VkPresentIdKHR unless 0
+	void Present(const FrameRing::FrameContext &context, uint64_t presentId) override;
+
+	VkSwapchainKHR GetSwapchain() const { return swapchain; }
+	VkFormat GetFormat() const override { return format.format; }
+	VkExtent2D GetExtent() const override { return extent; }
+	VkPresentModeKHR GetPresentMode() const { return presentMode; }
+	uint32_t GetImageCount() const { return (uint32_t)images.size(); }
+
+	// the image Acquire returned
+	VkImage GetImage() const { return images[imageIndex]; }
+	VkImageView GetImageView() const { return views[imageIndex]; }
+
+	Stats GetStats() const { return stats; }
+	void PrintStats(std::ostream &stream) const override;
+
+private:
+	// false while the window has no area to present to
+	bool Recreate();
+
+	Window* window = nullptr;
+	FrameRing* frameRing = nullptr;
+	FramePacer* framePacer = nullptr;
+
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+
+	VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	uint32_t requestedImageCount = 0;
+
+	VkSurfaceFormatKHR format = {};
+	VkExtent2D extent = {};
+
+	std::vector<VkImage> images;
+	std::vector<VkImageView> views;
+	uint32_t imageIndex = 0;
+
+	// set by out of date or suboptimal results, the next Acquire recreates
+	bool stale = false;
+
+	Stats stats;
+};
+
+#endif // !SWAPCHAIN_HEADER
\ No newline at end of file
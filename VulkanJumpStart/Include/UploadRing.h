@@ -0,0 +1,47 @@
+#ifndef UPLOAD_RING_HEADER
+#define UPLOAD_RING_HEADER
+
+#include <atomic>
+
+#include "VKFW.h"
+#include "GpuBuffer.h"
+
+// One persistently mapped, host coherent buffer split into a region per frame in flight.
+// Allocations bump a pointer through the current frame's region and are never freed one
+// by one, BeginFrame rewinds the region once the frame that used it last has finished.
+class UploadRing
+{
+public:
+	struct Allocation
+	{
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		void* data;
+	};
+
+	UploadRing();
+	~UploadRing();
+
+	void Create(VkDeviceSize sizePerFrame, uint32_t frameCount, VkBufferUsageFlags usage);
+	void Destroy();
+
+	void BeginFrame(uint32_t frameIndex);
+
+	// safe to call from several jobs at once, alignment must be a power of two
+	Allocation Allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+	VkBuffer GetBuffer() const { return buffer.GetBuffer(); }
+	VkDeviceSize GetFrameUsed() const { return head.load(std::memory_order_relaxed) - frameBegin; }
+	VkDeviceSize GetSizePerFrame() const { return sizePerFrame; }
+
+private:
+	GpuBuffer buffer;
+
+	VkDeviceSize sizePerFrame = 0;
+	uint32_t frameCount = 0;
+
+	VkDeviceSize frameBegin = 0;
+	std::atomic<VkDeviceSize> head{ 0 };
+};
+
+#endif // !UPLOAD_RING_HEADER
\ No newline at end of file
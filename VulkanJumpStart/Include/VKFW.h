@@ -6,7 +6,9 @@
 #include "VulkanFunctions.h"
 #include "VkPtr.h"
 #include "OS.h"
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 #include "Window.h"
+#endif // VK_USE_PLATFORM_WIN32_KHR
 
 #ifdef _DEBUG
 	#define VKFW_ENABLE_VALIDATION_LAYERS
@@ -18,10 +20,33 @@ struct VulkanContext
 
 	std::vector<char*> extensions;
 	std::vector<char*> validationLayers;
+	std::vector<const char*> deviceExtensions;
 
 	VkPtr<VkInstance> instance{ &vkDestroyInstance };
 	VkPtr<VkDevice> device{ &vkDestroyDevice };
 
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+
+	uint32_t graphicsQueueFamilyIndex = UINT32_MAX;
+	VkQueue graphicsQueue = VK_NULL_HANDLE;
+
+	// a compute-only family for async compute, left unset when the device has none
+	uint32_t computeQueueFamilyIndex = UINT32_MAX;
+	VkQueue computeQueue = VK_NULL_HANDLE;
+
+	// rendering offscreen only, the instance goes without surface extensions
+	bool headless = false;
+
+	// core features turned on at device creation
+	VkPhysicalDeviceFeatures enabledFeatures = {};
+
+	// filled in at device creation when VK_EXT_descriptor_indexing is enabled
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+
+	// filled in at device creation when VK_KHR_present_id and VK_KHR_present_wait are enabled
+	VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+	VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+
 #ifdef VKFW_ENABLE_VALIDATION_LAYERS
 	bool enableValidationLayers = 1;
 
@@ -52,6 +77,19 @@ void vkfwInit();
 
 const char** vkfwGetRequiredInstanceExtensions(uint32_t*);
 const char** vkfwGetRequiredInstanceLayers(uint32_t*);
+const char** vkfwGetDeviceExtensions(uint32_t*);
+bool vkfwIsDeviceExtensionEnabled(const char*);
+bool vkfwIsInstanceExtensionEnabled(const char*);
+
+uint32_t vkfwFindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties);
+// a type with the preferred properties on top of the required ones when there is one
+uint32_t vkfwFindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred);
+std::vector<uint32_t> vkfwReadShaderCode(const char* path);
+// codeHash receives a hash of the SPIR-V, for keying pipelines on shader contents
+VkShaderModule vkfwCreateShaderModule(const std::vector<uint32_t> &code, uint64_t* codeHash = nullptr);
+// codeSize in bytes, the words are read in place, e.g. straight out of a mapped file
+VkShaderModule vkfwCreateShaderModule(const uint32_t* code, size_t codeSize, uint64_t* codeHash = nullptr);
+VkShaderModule vkfwLoadShaderModule(const char* path, uint64_t* codeHash = nullptr);
 
 void _loadExportedEntryPoints();
 void _loadGlobalLevelEntryPoints();
@@ -60,6 +98,7 @@ void _loadDeviceLevelEntryPoints();
 
 void _loadRequiredInstanceExtensions();
 void _loadRequiredInstanceLayers();
+void _loadDeviceExtensions();
 bool _checkValidationLayersAvailable();
 
 #endif // !VKFW_HEADER
\ No newline at end of file
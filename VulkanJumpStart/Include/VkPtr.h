@@ -65,7 +65,7 @@ public:
 	template<typename V>
 	bool operator == (V rhs)
 	{
-		return object == T(rhs)
+		return object == T(rhs);
 	}
 
 private:
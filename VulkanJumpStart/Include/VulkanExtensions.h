@@ -0,0 +1,143 @@
+#ifndef VULKAN_EXTENSIONS_HEADER
+#define VULKAN_EXTENSIONS_HEADER
+
+#ifndef VKAPI_ATTR
+#include "vulkan.h"
+#endif // !VKAPI_ATTR
+
+///
+/// Declarations for extensions newer than the bundled vulkan.h,
+/// each block disappears once the header is updated to a version that has it.
+///
+
+#ifndef VK_KHR_maintenance3
+#define VK_KHR_maintenance3 1
+#define VK_KHR_MAINTENANCE3_EXTENSION_NAME "VK_KHR_maintenance3"
+#endif // !VK_KHR_maintenance3
+
+#ifndef VK_EXT_descriptor_indexing
+#define VK_EXT_descriptor_indexing 1
+#define VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME "VK_EXT_descriptor_indexing"
+
+#define VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT ((VkStructureType)1000161000)
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT ((VkStructureType)1000161001)
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT ((VkStructureType)1000161002)
+
+#define VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT ((VkDescriptorPoolCreateFlagBits)0x00000002)
+#define VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT ((VkDescriptorSetLayoutCreateFlagBits)0x00000002)
+
+typedef enum VkDescriptorBindingFlagBitsEXT {
+	VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT = 0x00000001,
+	VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT = 0x00000002,
+	VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT = 0x00000004,
+	VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT = 0x00000008,
+	VK_DESCRIPTOR_BINDING_FLAG_BITS_MAX_ENUM_EXT = 0x7FFFFFFF
+} VkDescriptorBindingFlagBitsEXT;
+typedef VkFlags VkDescriptorBindingFlagsEXT;
+
+typedef struct VkDescriptorSetLayoutBindingFlagsCreateInfoEXT {
+	VkStructureType sType;
+	const void* pNext;
+	uint32_t bindingCount;
+	const VkDescriptorBindingFlagsEXT* pBindingFlags;
+} VkDescriptorSetLayoutBindingFlagsCreateInfoEXT;
+
+typedef struct VkPhysicalDeviceDescriptorIndexingFeaturesEXT {
+	VkStructureType sType;
+	void* pNext;
+	VkBool32 shaderInputAttachmentArrayDynamicIndexing;
+	VkBool32 shaderUniformTexelBufferArrayDynamicIndexing;
+	VkBool32 shaderStorageTexelBufferArrayDynamicIndexing;
+	VkBool32 shaderUniformBufferArrayNonUniformIndexing;
+	VkBool32 shaderSampledImageArrayNonUniformIndexing;
+	VkBool32 shaderStorageBufferArrayNonUniformIndexing;
+	VkBool32 shaderStorageImageArrayNonUniformIndexing;
+	VkBool32 shaderInputAttachmentArrayNonUniformIndexing;
+	VkBool32 shaderUniformTexelBufferArrayNonUniformIndexing;
+	VkBool32 shaderStorageTexelBufferArrayNonUniformIndexing;
+	VkBool32 descriptorBindingUniformBufferUpdateAfterBind;
+	VkBool32 descriptorBindingSampledImageUpdateAfterBind;
+	VkBool32 descriptorBindingStorageImageUpdateAfterBind;
+	VkBool32 descriptorBindingStorageBufferUpdateAfterBind;
+	VkBool32 descriptorBindingUniformTexelBufferUpdateAfterBind;
+	VkBool32 descriptorBindingStorageTexelBufferUpdateAfterBind;
+	VkBool32 descriptorBindingUpdateUnusedWhilePending;
+	VkBool32 descriptorBindingPartiallyBound;
+	VkBool32 descriptorBindingVariableDescriptorCount;
+	VkBool32 runtimeDescriptorArray;
+} VkPhysicalDeviceDescriptorIndexingFeaturesEXT;
+
+typedef struct VkPhysicalDeviceDescriptorIndexingPropertiesEXT {
+	VkStructureType sType;
+	void* pNext;
+	uint32_t maxUpdateAfterBindDescriptorsInAllPools;
+	VkBool32 shaderUniformBufferArrayNonUniformIndexingNative;
+	VkBool32 shaderSampledImageArrayNonUniformIndexingNative;
+	VkBool32 shaderStorageBufferArrayNonUniformIndexingNative;
+	VkBool32 shaderStorageImageArrayNonUniformIndexingNative;
+	VkBool32 shaderInputAttachmentArrayNonUniformIndexingNative;
+	VkBool32 robustBufferAccessUpdateAfterBind;
+	VkBool32 quadDivergentImplicitLod;
+	uint32_t maxPerStageDescriptorUpdateAfterBindSamplers;
+	uint32_t maxPerStageDescriptorUpdateAfterBindUniformBuffers;
+	uint32_t maxPerStageDescriptorUpdateAfterBindStorageBuffers;
+	uint32_t maxPerStageDescriptorUpdateAfterBindSampledImages;
+	uint32_t maxPerStageDescriptorUpdateAfterBindStorageImages;
+	uint32_t maxPerStageDescriptorUpdateAfterBindInputAttachments;
+	uint32_t maxPerStageUpdateAfterBindResources;
+	uint32_t maxDescriptorSetUpdateAfterBindSamplers;
+	uint32_t maxDescriptorSetUpdateAfterBindUniformBuffers;
+	uint32_t maxDescriptorSetUpdateAfterBindUniformBuffersDynamic;
+	uint32_t maxDescriptorSetUpdateAfterBindStorageBuffers;
+	uint32_t maxDescriptorSetUpdateAfterBindStorageBuffersDynamic;
+	uint32_t maxDescriptorSetUpdateAfterBindSampledImages;
+	uint32_t maxDescriptorSetUpdateAfterBindStorageImages;
+	uint32_t maxDescriptorSetUpdateAfterBindInputAttachments;
+} VkPhysicalDeviceDescriptorIndexingPropertiesEXT;
+#endif // !VK_EXT_descriptor_indexing
+
+#ifndef VK_KHR_draw_indirect_count
+#define VK_KHR_draw_indirect_count 1
+#define VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME "VK_KHR_draw_indirect_count"
+
+typedef void (VKAPI_PTR *PFN_vkCmdDrawIndirectCountKHR)(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride);
+typedef void (VKAPI_PTR *PFN_vkCmdDrawIndexedIndirectCountKHR)(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride);
+#endif // !VK_KHR_draw_indirect_count
+
+#ifndef VK_KHR_present_id
+#define VK_KHR_present_id 1
+#define VK_KHR_PRESENT_ID_EXTENSION_NAME "VK_KHR_present_id"
+
+#define VK_STRUCTURE_TYPE_PRESENT_ID_KHR ((VkStructureType)1000294000)
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR ((VkStructureType)1000294001)
+
+typedef struct VkPresentIdKHR {
+	VkStructureType sType;
+	const void* pNext;
+	uint32_t swapchainCount;
+	const uint64_t* pPresentIds;
+} VkPresentIdKHR;
+
+typedef struct VkPhysicalDevicePresentIdFeaturesKHR {
+	VkStructureType sType;
+	void* pNext;
+	VkBool32 presentId;
+} VkPhysicalDevicePresentIdFeaturesKHR;
+#endif // !VK_KHR_present_id
+
+#ifndef VK_KHR_present_wait
+#define VK_KHR_present_wait 1
+#define VK_KHR_PRESENT_WAIT_EXTENSION_NAME "VK_KHR_present_wait"
+
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR ((VkStructureType)1000248000)
+
+typedef struct VkPhysicalDevicePresentWaitFeaturesKHR {
+	VkStructureType sType;
+	void* pNext;
+	VkBool32 presentWait;
+} VkPhysicalDevicePresentWaitFeaturesKHR;
+
+typedef VkResult (VKAPI_PTR *PFN_vkWaitForPresentKHR)(VkDevice device, VkSwapchainKHR swapchain, uint64_t presentId, uint64_t timeout);
+#endif // !VK_KHR_present_wait
+
+#endif // !VULKAN_EXTENSIONS_HEADER
\ No newline at end of file
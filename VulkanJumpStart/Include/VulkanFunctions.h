@@ -2,6 +2,7 @@
 #define VULKAN_FUNCTIONS_HEADER
 
 #include "vulkan.h"
+#include "VulkanExtensions.h"
 
 #define VK_EXPORTED_FUNCTION( FUNC ) extern PFN_##FUNC FUNC;
 #define VK_GLOBAL_LEVEL_FUNCTION( FUNC ) extern PFN_##FUNC FUNC;
@@ -15,6 +15,7 @@ VK_EXPORTED_FUNCTION( vkGetInstanceProcAddr )
 
 VK_GLOBAL_LEVEL_FUNCTION( vkCreateInstance )
 VK_GLOBAL_LEVEL_FUNCTION( vkEnumerateInstanceLayerProperties )
+VK_GLOBAL_LEVEL_FUNCTION( vkEnumerateInstanceExtensionProperties )
 
 #undef VK_GLOBAL_LEVEL_FUNCTION
 #endif
@@ -25,6 +26,23 @@ VK_INSTANCE_LEVEL_FUNCTION( vkGetDeviceProcAddr )
 VK_INSTANCE_LEVEL_FUNCTION( vkDestroyInstance )
 VK_INSTANCE_LEVEL_FUNCTION( vkCreateDebugReportCallbackEXT )
 VK_INSTANCE_LEVEL_FUNCTION( vkDestroyDebugReportCallbackEXT )
+VK_INSTANCE_LEVEL_FUNCTION( vkEnumeratePhysicalDevices )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceProperties )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceFeatures )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceQueueFamilyProperties )
+VK_INSTANCE_LEVEL_FUNCTION( vkCreateDevice )
+VK_INSTANCE_LEVEL_FUNCTION( vkEnumerateDeviceExtensionProperties )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceFeatures2KHR )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceProperties2KHR )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceMemoryProperties )
+VK_INSTANCE_LEVEL_FUNCTION( vkDestroySurfaceKHR )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceSurfaceSupportKHR )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceSurfaceCapabilitiesKHR )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceSurfaceFormatsKHR )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceSurfacePresentModesKHR )
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+VK_INSTANCE_LEVEL_FUNCTION( vkCreateWin32SurfaceKHR )
+#endif // VK_USE_PLATFORM_WIN32_KHR
 
 #undef VK_INSTANCE_LEVEL_FUNCTION
 #endif
@@ -32,6 +50,95 @@ VK_INSTANCE_LEVEL_FUNCTION( vkDestroyDebugReportCallbackEXT )
 #ifdef VK_DEVICE_LEVEL_FUNCTION
 
 VK_DEVICE_LEVEL_FUNCTION( vkDestroyDevice )
+VK_DEVICE_LEVEL_FUNCTION( vkGetDeviceQueue )
+VK_DEVICE_LEVEL_FUNCTION( vkDeviceWaitIdle )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateCommandPool )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyCommandPool )
+VK_DEVICE_LEVEL_FUNCTION( vkResetCommandPool )
+VK_DEVICE_LEVEL_FUNCTION( vkAllocateCommandBuffers )
+VK_DEVICE_LEVEL_FUNCTION( vkBeginCommandBuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkEndCommandBuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdExecuteCommands )
+VK_DEVICE_LEVEL_FUNCTION( vkQueueSubmit )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateFence )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyFence )
+VK_DEVICE_LEVEL_FUNCTION( vkWaitForFences )
+VK_DEVICE_LEVEL_FUNCTION( vkResetFences )
+VK_DEVICE_LEVEL_FUNCTION( vkGetFenceStatus )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateSemaphore )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroySemaphore )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateQueryPool )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyQueryPool )
+VK_DEVICE_LEVEL_FUNCTION( vkGetQueryPoolResults )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateDescriptorPool )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyDescriptorPool )
+VK_DEVICE_LEVEL_FUNCTION( vkResetDescriptorPool )
+VK_DEVICE_LEVEL_FUNCTION( vkAllocateDescriptorSets )
+VK_DEVICE_LEVEL_FUNCTION( vkFreeDescriptorSets )
+VK_DEVICE_LEVEL_FUNCTION( vkUpdateDescriptorSets )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateDescriptorSetLayout )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyDescriptorSetLayout )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdBindDescriptorSets )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdBindPipeline )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdBindVertexBuffers )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdBindIndexBuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdSetViewport )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdSetScissor )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdPushConstants )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdDraw )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdDrawIndexed )
+VK_DEVICE_LEVEL_FUNCTION( vkCreatePipelineLayout )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyPipelineLayout )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateDescriptorUpdateTemplateKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyDescriptorUpdateTemplateKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkUpdateDescriptorSetWithTemplateKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdPushDescriptorSetKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdPushDescriptorSetWithTemplateKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateBuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyBuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkGetBufferMemoryRequirements )
+VK_DEVICE_LEVEL_FUNCTION( vkAllocateMemory )
+VK_DEVICE_LEVEL_FUNCTION( vkFreeMemory )
+VK_DEVICE_LEVEL_FUNCTION( vkBindBufferMemory )
+VK_DEVICE_LEVEL_FUNCTION( vkMapMemory )
+VK_DEVICE_LEVEL_FUNCTION( vkUnmapMemory )
+VK_DEVICE_LEVEL_FUNCTION( vkInvalidateMappedMemoryRanges )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateImage )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyImage )
+VK_DEVICE_LEVEL_FUNCTION( vkGetImageMemoryRequirements )
+VK_DEVICE_LEVEL_FUNCTION( vkBindImageMemory )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateImageView )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyImageView )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateRenderPass )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyRenderPass )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateFramebuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyFramebuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateShaderModule )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyShaderModule )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateComputePipelines )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateGraphicsPipelines )
+VK_DEVICE_LEVEL_FUNCTION( vkCreatePipelineCache )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyPipelineCache )
+VK_DEVICE_LEVEL_FUNCTION( vkGetPipelineCacheData )
+VK_DEVICE_LEVEL_FUNCTION( vkMergePipelineCaches )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyPipeline )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdDispatch )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdFillBuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdCopyImageToBuffer )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdPipelineBarrier )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdBeginRenderPass )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdEndRenderPass )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdResetQueryPool )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdWriteTimestamp )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdDrawIndexedIndirect )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdDrawIndexedIndirectCountKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdDrawIndexedIndirectCountAMD )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateSwapchainKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroySwapchainKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkGetSwapchainImagesKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkAcquireNextImageKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkQueuePresentKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkWaitForPresentKHR )
 
 #undef VK_DEVICE_LEVEL_FUNCTION
 #endif
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "InstanceBatcher.h"
+
+#include <algorithm>
+#include <string.h>
+#include <assert.h>
+
+#include "Hash.h"
+
+uint64_t InstanceBatcher::MeshKey::Hash() const
+{
+	uint64_t hash = HashSeed;
+	hash = HashValue(pipeline, hash);
+	hash = HashValue(materialSet, hash);
+	hash = HashValue(vertexBuffer, hash);
+	hash = HashValue(vertexBufferOffset, hash);
+	hash = HashValue(indexBuffer, hash);
+	hash = HashValue(indexBufferOffset, hash);
+	hash = HashValue(indexType, hash);
+	hash = HashValue(indexCount, hash);
+	hash = HashValue(firstIndex, hash);
+	hash = HashValue(vertexOffset, hash);
+	return hash;
+}
+
+bool InstanceBatcher::MeshKey::operator ==(const MeshKey &rhs) const
+{
+	return pipeline == rhs.pipeline
+		&& materialSet == rhs.materialSet
+		&& vertexBuffer == rhs.vertexBuffer
+		&& vertexBufferOffset == rhs.vertexBufferOffset
+		&& indexBuffer == rhs.indexBuffer
+		&& indexBufferOffset == rhs.indexBufferOffset
+		&& indexType == rhs.indexType
+		&& indexCount == rhs.indexCount
+		&& firstIndex == rhs.firstIndex
+		&& vertexOffset == rhs.vertexOffset;
+}
+
+InstanceBatcher::InstanceBatcher()
+{
+}
+
+InstanceBatcher::~InstanceBatcher()
+{
+	Destroy();
+}
+
+void InstanceBatcher::Create(uint32_t maxDraws, uint32_t instanceBinding)
+{
+	assert(instanceBinding < CommandRecorder::MaxVertexBindings);
+
+	this->instanceBinding = instanceBinding;
+
+	batches.reserve(maxDraws);
+	memberNext.resize(maxDraws);
+}
+
+void InstanceBatcher::Destroy()
+{
+	batches.clear();
+	memberNext.clear();
+	runBatches.clear();
+}
+
+void InstanceBatcher::Build(const DrawList &drawList, UploadRing &uploadRing)
+{
+	uint32_t drawCount = drawList.GetCount();
+	uint32_t dataSize = drawList.GetInstanceDataSize();
+	const DrawList::SortItem* items = drawList.GetSortedItems();
+
+	assert(drawCount <= memberNext.size());
+
+	batches.clear();
+	instanceBuffer = VK_NULL_HANDLE;
+	instanceOffset = 0;
+
+	uint32_t instanceCount = 0;
+	for (uint32_t i = 0; i < drawCount; i++)
+	{
+		if (drawList.GetInstanceData(items[i].drawIndex))
+			instanceCount++;
+	}
+
+	uint8_t* instanceData = nullptr;
+
+	if (instanceCount > 0)
+	{
+		UploadRing::Allocation allocation = uploadRing.Allocate((VkDeviceSize)instanceCount * dataSize, 16);
+		instanceBuffer = allocation.buffer;
+		instanceOffset = allocation.offset;
+		instanceData = (uint8_t*)allocation.data;
+	}
+
+	uint32_t nextInstance = 0;
+
+	for (uint32_t runBegin = 0; runBegin < drawCount;)
+	{
+		uint64_t runState = items[runBegin].key >> DrawList::DepthBits;
+
+		uint32_t runEnd = runBegin + 1;
+		while (runEnd < drawCount && (items[runEnd].key >> DrawList::DepthBits) == runState)
+			runEnd++;
+
+		uint32_t firstRunBatch = (uint32_t)batches.size();
+		runBatches.clear();
+
+		// a batch sits where its nearest draw was, so the run stays roughly front to back
+		for (uint32_t i = runBegin; i < runEnd; i++)
+		{
+			const DrawList::Draw &draw = drawList.GetDraw(items[i].drawIndex);
+			memberNext[i] = NoMember;
+
+			if (!drawList.GetInstanceData(items[i].drawIndex))
+			{
+				batches.push_back({ draw, NoMember, NoMember });
+				continue;
+			}
+
+			MeshKey key;
+			key.pipeline = draw.pipeline;
+			key.materialSet = draw.materialSet;
+			key.vertexBuffer = draw.vertexBuffer;
+			key.vertexBufferOffset = draw.vertexBufferOffset;
+			key.indexBuffer = draw.indexBuffer;
+			key.indexBufferOffset = draw.indexBufferOffset;
+			key.indexType = draw.indexType;
+			key.indexCount = draw.indexCount;
+			key.firstIndex = draw.firstIndex;
+			key.vertexOffset = draw.vertexOffset;
+
+			auto found = runBatches.find(key);
+			if (found == runBatches.end())
+			{
+				runBatches.emplace(key, (uint32_t)batches.size());
+				batches.push_back({ draw, i, i });
+			}
+			else
+			{
+				Batch &batch = batches[found->second];
+				memberNext[batch.lastMember] = i;
+				batch.lastMember = i;
+			}
+		}
+
+		// members are contiguous in the instance block, in the order they were sorted
+		for (uint32_t b = firstRunBatch; b < batches.size(); b++)
+		{
+			Batch &batch = batches[b];
+			if (batch.firstMember == NoMember)
+				continue;
+
+			batch.draw.firstInstance = nextInstance;
+			batch.draw.instanceCount = 0;
+
+			for (uint32_t member = batch.firstMember; member != NoMember; member = memberNext[member])
+			{
+				memcpy(instanceData + (size_t)nextInstance * dataSize, drawList.GetInstanceData(items[member].drawIndex), dataSize);
+				nextInstance++;
+				batch.draw.instanceCount++;
+			}
+		}
+
+		runBegin = runEnd;
+	}
+
+	assert(nextInstance == instanceCount);
+
+	stats.inputDraws += drawCount;
+	stats.outputDraws += batches.size();
+	stats.instances += instanceCount;
+}
+
+void InstanceBatcher::Record(CommandRecorder &recorder, uint32_t begin, uint32_t end) const
+{
+	assert(end <= batches.size());
+
+	// one binding for the whole frame, the recorder drops it after the first batch
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const Batch &batch = batches[i];
+		const DrawList::Draw &draw = batch.draw;
+
+		// the pipeline is still compiling and the material has no fallback
+		if (draw.pipeline == VK_NULL_HANDLE)
+			continue;
+
+		recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline, draw.pipelineLayout);
+
+		if (draw.materialSet != VK_NULL_HANDLE)
+			recorder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipelineLayout, 0, 1, &draw.materialSet);
+
+		recorder.BindVertexBuffers(0, 1, &draw.vertexBuffer, &draw.vertexBufferOffset);
+
+		if (batch.firstMember != NoMember)
+			recorder.BindVertexBuffers(instanceBinding, 1, &instanceBuffer, &instanceOffset);
+
+		if (draw.indexBuffer != VK_NULL_HANDLE)
+		{
+			recorder.BindIndexBuffer(draw.indexBuffer, draw.indexBufferOffset, draw.indexType);
+			recorder.DrawIndexed(draw.indexCount, draw.instanceCount, draw.firstIndex, draw.vertexOffset, draw.firstInstance);
+		}
+		else
+		{
+			recorder.Draw(draw.indexCount, draw.instanceCount, (uint32_t)draw.vertexOffset, draw.firstInstance);
+		}
+	}
+}
+
+void InstanceBatcher::AppendRecordTasks(std::vector<CommandContext::RecordFunc> &tasks, uint32_t drawsPerTask) const
+{
+	assert(drawsPerTask > 0);
+
+	uint32_t batchCount = GetCount();
+
+	for (uint32_t begin = 0; begin < batchCount; begin += drawsPerTask)
+	{
+		uint32_t end = std::min(batchCount, begin + drawsPerTask);
+
+		tasks.push_back([this, begin, end](CommandRecorder &recorder)
+		{
+			Record(recorder, begin, end);
+		});
+	}
+}
+
+void InstanceBatcher::PrintStats(std::ostream &stream) const
+{
+	stream << "instancing: " << stats.inputDraws << " draws recorded as " << stats.outputDraws
+		<< ", " << stats.instances << " batched instances" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "Benchmarks.h"
+
+#include <chrono>
+#include <atomic>
+
+#include "JobSystem.h"
+
+static std::atomic<uint32_t> workSink{ 0 };
+
+// stands in for real per-job CPU work
+static void SimulateWork(uint32_t iterations)
+{
+	uint32_t state = iterations | 1;
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+	}
+
+	workSink.fetch_add(state, std::memory_order_relaxed);
+}
+
+// Culling fans out wide, recording depends on culling and every record job waits on
+// its own sub-batches, uploads run alongside and wait on a staging copy each. The
+// nested waits are where blocking workers stall and fibers keep them busy.
+static void RunFrameGraph(JobSystem &jobSystem)
+{
+	JobCounter cullCounter;
+	jobSystem.ParallelFor(256, 2, [](uint32_t begin, uint32_t end)
+	{
+		SimulateWork((end - begin) * 4000);
+	}, &cullCounter);
+
+	JobCounter recordCounter;
+	for (uint32_t i = 0; i < 32; i++)
+	{
+		jobSystem.Run([&jobSystem]()
+		{
+			JobCounter batchCounter;
+			jobSystem.ParallelFor(8, 1, [](uint32_t, uint32_t) { SimulateWork(8000); }, &batchCounter);
+			jobSystem.WaitForCounter(&batchCounter);
+
+			SimulateWork(2000);
+		}, &recordCounter, &cullCounter);
+	}
+
+	JobCounter uploadCounter;
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		jobSystem.Run([&jobSystem]()
+		{
+			JobCounter copyCounter;
+			jobSystem.Run([]() { SimulateWork(12000); }, &copyCounter);
+			jobSystem.WaitForCounter(&copyCounter);
+
+			SimulateWork(4000);
+		}, &uploadCounter);
+	}
+
+	jobSystem.WaitForCounter(&recordCounter);
+	jobSystem.WaitForCounter(&uploadCounter);
+	jobSystem.WaitForCounter(&cullCounter);
+}
+
+static void RunFrameGraphBenchmark(std::ostream &stream, bool useFibers)
+{
+	const uint32_t warmupFrames = 20;
+	const uint32_t frames = 500;
+
+	uint32_t workerCount = std::thread::hardware_concurrency();
+	if (workerCount == 0)
+		workerCount = 1;
+
+	JobSystem jobSystem;
+	jobSystem.Create(workerCount, true, useFibers);
+
+	for (uint32_t frame = 0; frame < warmupFrames; frame++)
+		RunFrameGraph(jobSystem);
+
+	jobSystem.ResetStats();
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t frame = 0; frame < frames; frame++)
+		RunFrameGraph(jobSystem);
+
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	uint64_t jobs = 0;
+	for (uint32_t i = 0; i < jobSystem.GetWorkerCount(); i++)
+		jobs += jobSystem.GetStats(i).jobsExecuted;
+
+	stream << (useFibers ? "fibers" : "threads")
+		<< ": " << workerCount << " workers, "
+		<< frames / seconds << " frames/s, "
+		<< 1000.0 * seconds / frames << " ms/frame, "
+		<< jobs / seconds << " jobs/s" << std::endl;
+
+	jobSystem.PrintStats(stream);
+	jobSystem.Destroy();
+}
+
+void RunJobBenchmark(std::ostream &stream)
+{
+	RunFrameGraphBenchmark(stream, false);
+	RunFrameGraphBenchmark(stream, true);
+}
\ No newline at end of file
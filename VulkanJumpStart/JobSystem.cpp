@@ -0,0 +1,600 @@
+#include "JobSystem.h"
+
+#include <chrono>
+#include <assert.h>
+
+// fibers migrate between threads, on MSVC this relies on fiber-safe TLS (/GT)
+static thread_local uint32_t currentWorkerIndex = UINT32_MAX;
+static thread_local uint32_t threadExecutionDepth = 0;
+
+struct JobFiber
+{
+	FiberHandle handle = nullptr;
+	JobSystem* system = nullptr;
+
+	// time spent parked inside the job currently running on this fiber
+	uint64_t parkedNanoseconds = 0;
+	uint32_t executionDepth = 0;
+};
+
+static uint64_t Now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+bool WorkStealingQueue::Push(Job* job)
+{
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+
+	if (b - t >= Capacity)
+		return false;
+
+	jobs[b & (Capacity - 1)].store(job, std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_release);
+
+	return true;
+}
+
+Job* WorkStealingQueue::Pop()
+{
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+
+	if (t > b)
+	{
+		// queue was already empty
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = jobs[b & (Capacity - 1)].load(std::memory_order_acquire);
+
+	if (t == b)
+	{
+		// last item, race against thieves for it
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+Job* WorkStealingQueue::Steal()
+{
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+
+	if (t >= b)
+		return nullptr;
+
+	Job* job = jobs[t & (Capacity - 1)].load(std::memory_order_acquire);
+
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+
+	return job;
+}
+
+JobSystem::JobSystem()
+{
+}
+
+JobSystem::~JobSystem()
+{
+	Destroy();
+}
+
+void JobSystem::Create(uint32_t workerCount, bool pinThreads, bool useFibers)
+{
+	assert(workerCount > 0);
+
+	this->useFibers = useFibers;
+
+	if (useFibers)
+	{
+		for (uint32_t i = 0; i < FiberCount; i++)
+		{
+			JobFiber* fiber = new JobFiber();
+			fiber->system = this;
+			fiber->handle = OSCreateFiber(FiberStackSize, &JobSystem::FiberMain, fiber);
+
+			if (!fiber->handle)
+				throw std::runtime_error("Failed to create job fiber");
+
+			fibers.push_back(fiber);
+		}
+
+		freeFibers = fibers;
+	}
+
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		Worker* worker = new Worker();
+		worker->jobRing.resize(JobRingSize);
+		worker->rngState = 0x9E3779B9u * (i + 1);
+		workers.push_back(worker);
+	}
+
+	running = true;
+
+	currentWorkerIndex = 0;
+	if (pinThreads)
+		PinCurrentThread(0);
+
+	for (uint32_t i = 1; i < workerCount; i++)
+		workers[i]->thread = std::thread(&JobSystem::WorkerMain, this, i, pinThreads);
+}
+
+void JobSystem::Destroy()
+{
+	if (workers.empty())
+		return;
+
+	running = false;
+	sleepCondition.notify_all();
+
+	// join everyone before freeing, idle workers still steal from the other queues
+	for (Worker* worker : workers)
+	{
+		if (worker->thread.joinable())
+			worker->thread.join();
+	}
+
+	for (Worker* worker : workers)
+		delete worker;
+
+	// fibers still parked on a counter are simply dropped with their stacks
+	for (JobFiber* fiber : fibers)
+	{
+		OSDeleteFiber(fiber->handle);
+		delete fiber;
+	}
+
+	workers.clear();
+	fibers.clear();
+	freeFibers.clear();
+	readyFibers.clear();
+	readyFiberCount = 0;
+	useFibers = false;
+	currentWorkerIndex = UINT32_MAX;
+}
+
+void JobSystem::Run(std::function<void()> entry, JobCounter* counter, JobCounter* dependency)
+{
+	Job* job = AllocateJob();
+	job->entry = std::move(entry);
+	job->counter = counter;
+
+	if (counter)
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+
+	if (dependency)
+	{
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (dependency->value.load(std::memory_order_acquire) > 0)
+		{
+			dependency->continuations.push_back(job);
+			return;
+		}
+	}
+
+	Submit(job);
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, std::function<void(uint32_t, uint32_t)> entry, JobCounter* counter, JobCounter* dependency)
+{
+	assert(batchSize > 0);
+
+	for (uint32_t begin = 0; begin < count; begin += batchSize)
+	{
+		uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+		Run([entry, begin, end]() { entry(begin, end); }, counter, dependency);
+	}
+}
+
+void JobSystem::WaitForCounter(JobCounter* counter)
+{
+	assert(currentWorkerIndex < workers.size());
+
+	while (counter->value.load(std::memory_order_acquire) > 0)
+	{
+		Worker &worker = *workers[currentWorkerIndex];
+
+		if (worker.currentFiber)
+		{
+			// park this fiber on the counter and let the worker carry on with something else
+			JobFiber* next = PopFiber(readyFibers);
+			if (!next)
+				next = PopFiber(freeFibers);
+
+			if (next)
+			{
+				JobFiber* fiber = worker.currentFiber;
+				uint64_t parkStart = Now();
+
+				SwitchFiber(next, counter);
+
+				fiber->parkedNanoseconds += Now() - parkStart;
+				continue;
+			}
+		}
+
+		// no fiber to switch to, help out until the counter drops
+		uint64_t idleStart = Now();
+		Job* job = FindJob(worker);
+		worker.stats.idleNanoseconds += Now() - idleStart;
+
+		if (job)
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+
+	std::exception_ptr exception;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		exception = counter->exception;
+		counter->exception = nullptr;
+	}
+
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+uint32_t JobSystem::GetWorkerIndex()
+{
+	return currentWorkerIndex;
+}
+
+void JobSystem::ResetStats()
+{
+	for (Worker* worker : workers)
+		worker->stats = WorkerStats();
+}
+
+void JobSystem::PrintStats(std::ostream &stream) const
+{
+	for (uint32_t i = 0; i < workers.size(); i++)
+	{
+		const WorkerStats &stats = workers[i]->stats;
+		uint64_t total = stats.busyNanoseconds + stats.idleNanoseconds;
+
+		stream << "worker " << i
+			<< ": jobs " << stats.jobsExecuted
+			<< ", stolen " << stats.jobsStolen
+			<< ", busy " << stats.busyNanoseconds / 1000000.0 << " ms"
+			<< " (" << (total ? 100.0 * stats.busyNanoseconds / total : 0.0) << "%)" << std::endl;
+	}
+}
+
+Job* JobSystem::AllocateJob()
+{
+	assert(currentWorkerIndex < workers.size());
+
+	// ring allocation, assumes a worker never has more than JobRingSize jobs in flight
+	Worker &worker = *workers[currentWorkerIndex];
+	return &worker.jobRing[worker.jobRingCursor++ & (JobRingSize - 1)];
+}
+
+void JobSystem::Submit(Job* job)
+{
+	Worker &worker = *workers[currentWorkerIndex < workers.size() ? currentWorkerIndex : 0];
+
+	if (!worker.queue.Push(job))
+	{
+		// deque is full, run inline rather than drop the job
+		Execute(job);
+		return;
+	}
+
+	queuedJobs.fetch_add(1, std::memory_order_release);
+	sleepCondition.notify_one();
+}
+
+void JobSystem::Finish(Job* job)
+{
+	JobCounter* counter = job->counter;
+	job->entry = nullptr;
+
+	if (!counter)
+		return;
+
+	int32_t value = counter->value.load(std::memory_order_relaxed);
+	while (value > 1)
+	{
+		if (counter->value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			return;
+	}
+
+	// the last decrement happens under the lock, a waiter seeing zero takes the same
+	// lock before returning so the counter outlives this call
+	std::vector<Job*> ready;
+	std::vector<JobFiber*> resumed;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			ready.swap(counter->continuations);
+			resumed.swap(counter->waitingFibers);
+		}
+	}
+
+	for (Job* continuation : ready)
+		Submit(continuation);
+
+	if (!resumed.empty())
+		MakeReady(resumed);
+}
+
+Job* JobSystem::FindJob(Worker &worker)
+{
+	Job* job = worker.queue.Pop();
+
+	if (!job && workers.size() > 1)
+	{
+		// xorshift to pick a random victim
+		worker.rngState ^= worker.rngState << 13;
+		worker.rngState ^= worker.rngState >> 17;
+		worker.rngState ^= worker.rngState << 5;
+
+		uint32_t victim = worker.rngState % workers.size();
+		if (workers[victim] != &worker)
+		{
+			job = workers[victim]->queue.Steal();
+			if (job)
+				worker.stats.jobsStolen++;
+		}
+	}
+
+	if (job)
+		queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+	return job;
+}
+
+void JobSystem::Execute(Job* job)
+{
+	JobFiber* fiber = workers[currentWorkerIndex]->currentFiber;
+	uint64_t parked = fiber ? fiber->parkedNanoseconds : 0;
+
+	// jobs run while helping out inside a wait are already covered by the outer job
+	uint32_t &depth = fiber ? fiber->executionDepth : threadExecutionDepth;
+
+	uint64_t start = Now();
+	depth++;
+
+	try
+	{
+		job->entry();
+	}
+	catch (...)
+	{
+		// unwinding out of a fiber would terminate, the waiting thread rethrows it instead
+		if (job->counter)
+		{
+			std::lock_guard<std::mutex> lock(job->counter->mutex);
+			if (!job->counter->exception)
+				job->counter->exception = std::current_exception();
+		}
+		else
+		{
+			std::cerr << "Exception in a job nothing waits on, dropped" << std::endl;
+		}
+	}
+
+	depth--;
+
+	// the job may have parked and resumed on a different worker
+	Worker &worker = *workers[currentWorkerIndex];
+	parked = fiber ? fiber->parkedNanoseconds - parked : 0;
+
+	if (depth == 0)
+		worker.stats.busyNanoseconds += Now() - start - parked;
+
+	worker.stats.jobsExecuted++;
+
+	Finish(job);
+}
+
+void JobSystem::Sleep()
+{
+	std::unique_lock<std::mutex> lock(sleepMutex);
+
+	// the timeout covers a notify racing with the predicate check
+	sleepCondition.wait_for(lock, std::chrono::milliseconds(1), [this]()
+	{
+		return queuedJobs.load(std::memory_order_acquire) > 0
+			|| readyFiberCount.load(std::memory_order_acquire) > 0
+			|| !running.load(std::memory_order_relaxed);
+	});
+}
+
+JobFiber* JobSystem::PopFiber(std::vector<JobFiber*> &list)
+{
+	if (&list == &readyFibers && readyFiberCount.load(std::memory_order_acquire) == 0)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(fiberMutex);
+
+	if (list.empty())
+		return nullptr;
+
+	JobFiber* fiber = list.back();
+	list.pop_back();
+
+	if (&list == &readyFibers)
+		readyFiberCount.fetch_sub(1, std::memory_order_relaxed);
+
+	return fiber;
+}
+
+void JobSystem::MakeReady(const std::vector<JobFiber*> &ready)
+{
+	{
+		std::lock_guard<std::mutex> lock(fiberMutex);
+		readyFibers.insert(readyFibers.end(), ready.begin(), ready.end());
+		readyFiberCount.fetch_add((int32_t)ready.size(), std::memory_order_release);
+	}
+
+	sleepCondition.notify_all();
+}
+
+void JobSystem::SwitchFiber(JobFiber* to, JobCounter* waitCounter)
+{
+	Worker &worker = *workers[currentWorkerIndex];
+	JobFiber* from = worker.currentFiber;
+
+	// the fiber being left can only be handed to another worker once it is fully
+	// switched out, so the fiber switched to files it away in CompleteSwitch
+	worker.switchedFiber = from;
+	worker.switchedCounter = waitCounter;
+	worker.currentFiber = to;
+
+	OSSwitchFiber(from->handle, to->handle);
+
+	CompleteSwitch();
+}
+
+void JobSystem::CompleteSwitch()
+{
+	Worker &worker = *workers[currentWorkerIndex];
+
+	JobFiber* fiber = worker.switchedFiber;
+	JobCounter* counter = worker.switchedCounter;
+
+	worker.switchedFiber = nullptr;
+	worker.switchedCounter = nullptr;
+
+	if (!fiber)
+		return;
+
+	if (counter)
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->value.load(std::memory_order_acquire) > 0)
+		{
+			counter->waitingFibers.push_back(fiber);
+			return;
+		}
+	}
+
+	if (counter)
+	{
+		// the counter dropped while switching, resume straight away
+		MakeReady(std::vector<JobFiber*>(1, fiber));
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(fiberMutex);
+		freeFibers.push_back(fiber);
+	}
+}
+
+void JobSystem::WorkerMain(uint32_t index, bool pinThread)
+{
+	currentWorkerIndex = index;
+
+	if (pinThread)
+		PinCurrentThread(index);
+
+	Worker &worker = *workers[index];
+
+	if (useFibers)
+	{
+		worker.threadFiber = OSConvertThreadToFiber();
+		worker.currentFiber = PopFiber(freeFibers);
+
+		if (worker.currentFiber)
+		{
+			OSSwitchFiber(worker.threadFiber, worker.currentFiber->handle);
+
+			// back on the thread's own fiber, the loop has shut down
+			worker.currentFiber = nullptr;
+			worker.switchedFiber = nullptr;
+			OSConvertFiberToThread(worker.threadFiber);
+			return;
+		}
+
+		// pool exhausted, run this worker without fibers
+		OSConvertFiberToThread(worker.threadFiber);
+	}
+
+	uint32_t spins = 0;
+
+	while (running.load(std::memory_order_relaxed))
+	{
+		uint64_t idleStart = Now();
+		Job* job = FindJob(worker);
+
+		if (!job && ++spins > 64)
+		{
+			Sleep();
+			spins = 0;
+		}
+
+		worker.stats.idleNanoseconds += Now() - idleStart;
+
+		if (job)
+		{
+			spins = 0;
+			Execute(job);
+		}
+	}
+}
+
+void JobSystem::FiberLoop()
+{
+	CompleteSwitch();
+
+	uint32_t spins = 0;
+
+	while (running.load(std::memory_order_relaxed))
+	{
+		// resumed fibers go first, they hold half-finished jobs
+		JobFiber* ready = PopFiber(readyFibers);
+		if (ready)
+		{
+			SwitchFiber(ready, nullptr);
+			continue;
+		}
+
+		Worker &worker = *workers[currentWorkerIndex];
+
+		uint64_t idleStart = Now();
+		Job* job = FindJob(worker);
+
+		if (!job && ++spins > 64)
+		{
+			Sleep();
+			spins = 0;
+		}
+
+		worker.stats.idleNanoseconds += Now() - idleStart;
+
+		if (job)
+		{
+			spins = 0;
+			Execute(job);
+		}
+	}
+
+	// hand the thread back to the fiber it started on
+	Worker &worker = *workers[currentWorkerIndex];
+	worker.switchedFiber = worker.currentFiber;
+	worker.switchedCounter = nullptr;
+
+	OSSwitchFiber(worker.currentFiber->handle, worker.threadFiber);
+}
+
+void FIBER_CALL JobSystem::FiberMain(void* param)
+{
+	JobFiber* fiber = (JobFiber*)param;
+	fiber->system->FiberLoop();
+}
\ No newline at end of file
@@ -1,32 +1,459 @@
 #include <iostream>
 #include <exception>
+#include <thread>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
 #include <assert.h>
 
 #include "VKFW.h"
+#include "CommandContext.h"
+#include "DescriptorAllocator.h"
+#include "DescriptorCache.h"
+#include "BindlessHeap.h"
+#include "DescriptorBinder.h"
+#include "DrawList.h"
+#include "UploadRing.h"
+#include "InstanceBatcher.h"
+#include "GpuCulling.h"
+#include "Scene.h"
+#include "RenderGraph.h"
+#include "PipelineCache.h"
+#include "PipelineCompiler.h"
+#include "PipelineRegistry.h"
+#include "PipelineLayoutCache.h"
+#include "FrameRing.h"
+#include "FramePacer.h"
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+#include "Swapchain.h"
+#endif // VK_USE_PLATFORM_WIN32_KHR
+#include "HeadlessTarget.h"
+#include "ShaderHotReload.h"
+#include "ShaderBundle.h"
+#include "Profiler.h"
+#include "QueueProfiler.h"
+#include "JobSystem.h"
+#include "Benchmarks.h"
 
 class VulkanApplication
 {
 public:
+	static const uint32_t DefaultFrameCount = 2;
+	static const uint32_t MaxBindlessTextures = 16384;
+	static const uint32_t MaxBindlessBuffers = 4096;
+	// caps the scene's objects, the draw list holds one draw per object
+	static const uint32_t MaxDraws = 1 << 20;
+	static const uint32_t DrawsPerRecordTask = 512;
+	static const uint32_t MaxGpuInstances = 1 << 16;
+	static const uint32_t ObjectsPerCullTask = 1024;
+	// for everything uploaded per frame besides the batched instance data, which is added to it
+	static const VkDeviceSize UploadRingSizePerFrame = 16 << 20;
+	// one column-major mat4 per instance, read from vertex binding 1 at instance rate
+	static const uint32_t InstanceDataSize = 64;
+	static const uint32_t InstanceBinding = 1;
+	static constexpr const char* PipelineCachePath = "PipelineCache.bin";
+	static constexpr double PipelineCacheSaveInterval = 60.0;
+	static const uint32_t PipelineCompilerThreads = 2;
+	static constexpr const char* ShaderDirectory = "Shaders";
+	static constexpr const char* ShaderBundlePath = "Shaders.bundle";
+
+	struct Settings
+	{
+		// from FrameRing::MinFrameCount to FrameRing::MaxFrameCount
+		uint32_t frameCount = DefaultFrameCount;
+
+		FramePacer::Mode pacingMode = FramePacer::ModeUnlimited;
+		// 0 for no limit
+		double frameRateLimit = 0.0;
+
+		// falls back to FIFO where the surface does not have it
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		// 0 to pick one to suit the present mode
+		uint32_t swapchainImages = 0;
+
+		// renders this many frames offscreen and exits, without a window, when above 0
+		uint32_t headlessFrames = 0;
+		uint32_t headlessWidth = 1280;
+		uint32_t headlessHeight = 720;
+		HeadlessTarget::Output headlessOutput = HeadlessTarget::OutputPng;
+		const char* outputDirectory = ".";
+
+		// the generated scene, CPU culled objects and GPU culled instances
+		uint32_t sceneObjects = 16384;
+		uint32_t sceneGpuInstances = 16384;
+	};
+
+	VulkanApplication(const Settings &settings)
+		: settings(settings), frameCount(settings.frameCount)
+	{
+	}
+
 	void Run()
+	{
+#ifndef VK_USE_PLATFORM_WIN32_KHR
+		// windows and surfaces are Win32 only so far
+		if (settings.headlessFrames == 0)
+			throw std::runtime_error("Failed to create window, only --headless is supported on this platform");
+#endif // !VK_USE_PLATFORM_WIN32_KHR
+
+		InitVulkan();
+		startupProfiler.Print(std::cout);
+
+		if (settings.headlessFrames > 0)
+			RenderHeadless();
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+		else
+			MainLoop();
+#endif // VK_USE_PLATFORM_WIN32_KHR
+	}
+
+	void BenchmarkDescriptors()
 	{
 		InitVulkan();
-		MainLoop();
+		RunDescriptorBenchmark(std::cout, commandContext, descriptorAllocator);
 	}
 
 private:
+	Profiler startupProfiler;
+	Profiler gpuProfiler;
+	Profiler frameProfiler;
+	QueueProfiler queueProfiler;
+	PipelineCache pipelineCache;
+	PipelineCompiler pipelineCompiler;
+	PipelineRegistry pipelineRegistry;
+	PipelineLayoutCache pipelineLayoutCache;
+	FrameRing frameRing;
+	FramePacer framePacer;
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	Swapchain swapchain;
+#endif // VK_USE_PLATFORM_WIN32_KHR
+	HeadlessTarget headlessTarget;
+
+	// the swapchain, or the headless target
+	PresentTarget* presentTarget = nullptr;
+	ShaderHotReload shaderHotReload;
+	ShaderBundle shaderBundle;
+	JobSystem jobSystem;
+	CommandContext commandContext;
+	CommandContext computeContext;
+	DescriptorAllocator descriptorAllocator;
+	DescriptorCache descriptorCache;
+	BindlessHeap bindlessHeap;
+	DescriptorBinder descriptorBinder;
+	DrawList drawList;
+	UploadRing uploadRing;
+	InstanceBatcher instanceBatcher;
+	GpuCulling gpuCulling;
+	Scene scene;
+	RenderGraph renderGraph;
+
+	// column-major, identity until a camera drives it
+	float viewProjection[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	Settings settings;
+	uint32_t frameCount;
+
+	// the context of the frame between BeginFrame and EndFrame
+	FrameRing::FrameContext* frame = nullptr;
+
+	// the swapchain image the frame draws to, unless the window has no area
+	bool hasBackbuffer = false;
+	RenderGraph::Resource backbuffer = 0;
+
+	// the frame's pass drawing the scene, its recording inherits the pass's render pass
+	RenderGraph::Pass drawPass = 0;
+
+	// the scene's cube, through the draw list and as GPU culled instances
+	AsyncPipeline meshPipeline;
+	AsyncPipeline culledMeshPipeline;
+	JobCounter uploadCounter;
+
+	// per-frame CPU work, registered by the systems that need it
+	std::vector<std::function<void()>> cullTasks;
+	std::vector<std::function<void()>> uploadTasks;
+	std::vector<CommandContext::RecordFunc> recordTasks;
 
 	void InitVulkan()
 	{
+		Profiler::Scope scope(startupProfiler, "startup");
+
+		// no window means no surface, the surface extensions are left out
+		Vulkan.headless = settings.headlessFrames > 0;
+
 		vkfwInit();
 		this->CreateInstance();
 		this->SetupDebugLogging();
+		this->PickPhysicalDevice();
+		this->CreateLogicalDevice();
+		this->CreateJobSystem();
+		this->CreateFrameRing();
+		this->CreatePipelineCache();
+		this->CreateCommandContext();
+		this->CreateDescriptorAllocator();
+		this->OpenShaderBundle();
+		this->CreateGpuCulling();
+		this->CreateScene();
+		this->CreateDrawList();
+		this->CreateUploadRing();
+		this->CreateRenderGraph();
 	}
 
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 	void MainLoop()
 	{
 		Window window = Window();
 		window.Create();
+
+		swapchain.Create(window, frameRing, framePacer, settings.presentMode, settings.swapchainImages);
+		presentTarget = &swapchain;
+
+		this->CreateMeshPipelines();
+
+		while (window.ProcessMessages())
+		{
+			this->BeginFrame();
+			this->DrawFrame();
+			this->EndFrame();
+		}
+
+		vkDeviceWaitIdle(Vulkan.device);
+
+		shaderHotReload.Destroy();
+		frameRing.Flush();
+		renderGraph.Destroy();
+		queueProfiler.Destroy();
+
+		swapchain.PrintStats(std::cout);
+		swapchain.Destroy();
 		window.Destroy();
+
+		Shutdown();
+	}
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+	// the same frames as the window gets, read back to files instead of presented
+	void RenderHeadless()
+	{
+		headlessTarget.Create(frameRing, settings.headlessWidth, settings.headlessHeight, settings.headlessOutput, settings.outputDirectory);
+		presentTarget = &headlessTarget;
+
+		this->CreateMeshPipelines();
+
+		for (uint32_t i = 0; i < settings.headlessFrames; i++)
+		{
+			this->BeginFrame();
+			this->DrawFrame();
+			this->EndFrame();
+		}
+
+		vkDeviceWaitIdle(Vulkan.device);
+
+		shaderHotReload.Destroy();
+		frameRing.Flush();
+		renderGraph.Destroy();
+		queueProfiler.Destroy();
+
+		// the last frames in flight are still in their readback buffers
+		headlessTarget.Flush();
+		headlessTarget.PrintStats(std::cout);
+		headlessTarget.Destroy();
+
+		Shutdown();
+	}
+
+	// what is left once either loop has idled the device and let go of its target
+	void Shutdown()
+	{
+		pipelineCompiler.Destroy();
+		pipelineCache.Save();
+
+		frameRing.PrintStats(std::cout);
+		framePacer.PrintStats(std::cout);
+		jobSystem.PrintStats(std::cout);
+		commandContext.PrintStats(std::cout);
+		descriptorAllocator.PrintStats(std::cout);
+		descriptorCache.PrintStats(std::cout);
+		instanceBatcher.PrintStats(std::cout);
+		pipelineRegistry.PrintStats(std::cout);
+		pipelineLayoutCache.PrintStats(std::cout);
+		renderGraph.PrintStats(std::cout);
+		gpuProfiler.Print(std::cout);
+		frameProfiler.Print(std::cout);
+	}
+
+	// waits for the frame context to come free, then readies every per-frame system for it
+	void BeginFrame()
+	{
+		// the context's fence guards its command pools, upload region and descriptor pools
+		// until the GPU is done with them
+		frame = &frameRing.BeginFrame();
+		uint32_t frameIndex = frame->index;
+
+		// may hold the frame back, everything the frame samples comes after it
+		framePacer.BeginFrame(*frame);
+		hasBackbuffer = presentTarget->Acquire(*frame);
+
+		// pipelines rebuilt from edited shaders replace the old ones before anything records
+		shaderHotReload.Update();
+
+		queueProfiler.BeginFrame(frameIndex);
+		commandContext.BeginFrame(frameIndex);
+
+		if (renderGraph.HasAsyncCompute())
+			computeContext.BeginFrame(frameIndex);
+
+		descriptorAllocator.BeginFrame(frameIndex);
+		descriptorCache.BeginFrame();
+		uploadRing.BeginFrame(frameIndex);
+		pipelineCache.Update();
+
+		if (BindlessHeap::IsSupported())
+			bindlessHeap.BeginFrame();
+
+		// the frame's GPU passes are declared anew every frame, the graph orders and syncs them
+		renderGraph.Reset();
+
+		if (hasBackbuffer)
+			backbuffer = presentTarget->Import(renderGraph);
+	}
+
+	void DrawFrame()
+	{
+		uint32_t frameIndex = frame->index;
+
+		// culling jobs fill the draw list
+		drawList.Clear();
+
+		JobCounter cullCounter;
+		for (const std::function<void()> &task : cullTasks)
+			jobSystem.Run(task, &cullCounter);
+
+		// uploads overlap culling and recording, only the submit waits for them
+		for (const std::function<void()> &task : uploadTasks)
+			jobSystem.Run(task, &uploadCounter);
+
+		// GPU culled instances need no CPU work past their upload. The host rewrites the
+		// instances every frame, the draw records and the count are cleared by the culling,
+		// so none of them carries anything over from the last frame
+		bool gpuCulled = scene.GetGpuInstanceCount() > 0;
+		RenderGraph::Resource gpuInstances = 0;
+		RenderGraph::Resource gpuDraws = 0;
+		RenderGraph::Resource gpuDrawCount = 0;
+
+		if (gpuCulled)
+		{
+			const GpuBuffer &instances = gpuCulling.GetInstanceBuffer(frameIndex);
+			const GpuBuffer &draws = gpuCulling.GetDrawBuffer(frameIndex);
+			const GpuBuffer &drawCount = gpuCulling.GetDrawCountBuffer(frameIndex);
+
+			gpuInstances = renderGraph.ImportBuffer("gpu instances", instances.GetBuffer(), instances.GetSize(), RenderGraph::UsageNone, RenderGraph::UsageNone);
+			gpuDraws = renderGraph.ImportBuffer("gpu draws", draws.GetBuffer(), draws.GetSize(), RenderGraph::UsageNone, RenderGraph::UsageNone);
+			gpuDrawCount = renderGraph.ImportBuffer("gpu draw count", drawCount.GetBuffer(), drawCount.GetSize(), RenderGraph::UsageNone, RenderGraph::UsageHostRead);
+
+			// overlaps the graphics work of the frame where there is a compute queue
+			RenderGraph::Pass cullPass = renderGraph.AddPass("gpu culling", [this, frameIndex](VkCommandBuffer commandBuffer)
+			{
+				float planes[6][4];
+				GpuCulling::ExtractFrustumPlanes(viewProjection, planes);
+				gpuCulling.Cull(commandBuffer, frameIndex, planes);
+			}, RenderGraph::QueueCompute);
+
+			renderGraph.Use(cullPass, gpuInstances, RenderGraph::UsageStorageReadCompute);
+			renderGraph.Use(cullPass, gpuDraws, RenderGraph::UsageStorageWriteCompute);
+			renderGraph.Use(cullPass, gpuDrawCount, RenderGraph::UsageTransferDst);
+			renderGraph.Use(cullPass, gpuDrawCount, RenderGraph::UsageStorageWriteCompute);
+		}
+
+		jobSystem.WaitForCounter(&cullCounter);
+
+		// nothing to draw to, e.g. while the window has no area
+		if (!hasBackbuffer)
+			return;
+
+		drawList.Sort(jobSystem);
+		instanceBatcher.Build(drawList, uploadRing);
+
+		std::vector<CommandContext::RecordFunc> frameRecordTasks = recordTasks;
+		instanceBatcher.AppendRecordTasks(frameRecordTasks, DrawsPerRecordTask);
+
+		// the draws record in parallel into secondaries executed inside the pass's render pass
+		drawPass = renderGraph.AddPass("draw", [this, frameRecordTasks](VkCommandBuffer commandBuffer)
+		{
+			VkExtent2D extent = renderGraph.GetExtent(drawPass);
+
+			VkCommandBufferInheritanceInfo inheritance = {};
+			inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritance.pNext = nullptr;
+			inheritance.renderPass = renderGraph.GetRenderPass(drawPass);
+			inheritance.subpass = 0;
+			inheritance.framebuffer = renderGraph.GetFramebuffer(drawPass);
+			inheritance.occlusionQueryEnable = VK_FALSE;
+			inheritance.queryFlags = 0;
+			inheritance.pipelineStatistics = 0;
+
+			commandContext.RecordParallel(jobSystem, commandBuffer, inheritance, frameRecordTasks, &extent);
+		});
+
+		VkClearValue clearValue = {};
+		clearValue.color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+
+		renderGraph.Use(drawPass, backbuffer, RenderGraph::UsageColorAttachment);
+		renderGraph.SetClear(drawPass, backbuffer, clearValue);
+		renderGraph.SetSecondaryCommandBuffers(drawPass);
+
+		if (gpuCulled)
+		{
+			renderGraph.Use(drawPass, gpuInstances, RenderGraph::UsageVertexBuffer);
+			renderGraph.Use(drawPass, gpuDraws, RenderGraph::UsageIndirectBuffer);
+			renderGraph.Use(drawPass, gpuDrawCount, RenderGraph::UsageIndirectBuffer);
+		}
+
+		presentTarget->AddFinalPasses(renderGraph, backbuffer);
+	}
+
+	// records and submits the frame's passes, signalling its fence, and moves to the next context
+	void EndFrame()
+	{
+		renderGraph.Compile(frame->index);
+
+		jobSystem.WaitForCounter(&uploadCounter);
+
+		// each queue records into command buffers from its own family's pools
+		RenderGraph::BeginFunc begin = [this](RenderGraph::QueueType queue)
+		{
+			CommandContext &context = queue == RenderGraph::QueueCompute ? computeContext : commandContext;
+			return context.BeginPrimary(JobSystem::GetWorkerIndex());
+		};
+
+		// the backbuffer is first written as a color attachment, which is where the acquire is waited on
+		if (hasBackbuffer)
+		{
+			renderGraph.Submit(begin, presentTarget->GetAcquireSemaphore(*frame), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				presentTarget->GetPresentSemaphore(*frame), frame->fence, &queueProfiler);
+
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+			// only presents to the swapchain have ids for the pacer to wait on
+			if (presentTarget == &swapchain)
+			{
+				uint64_t presentId = framePacer.GetPresentId();
+				swapchain.Present(*frame, presentId);
+				framePacer.OnPresent(swapchain.GetSwapchain(), presentId);
+			}
+			else
+#endif // VK_USE_PLATFORM_WIN32_KHR
+			{
+				presentTarget->Present(*frame, 0);
+			}
+		}
+		else
+		{
+			renderGraph.Submit(begin, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, frame->fence, &queueProfiler);
+		}
+
+		framePacer.EndFrame(queueProfiler.GetFrameSeconds());
+
+		frameRing.EndFrame();
+		frame = nullptr;
 	}
 
 	void CreateInstance()
@@ -64,8 +491,10 @@ private:
 		_loadInstanceLevelEntryPoints();
 	}
 
+	// the callback only exists in builds with validation layers
 	void SetupDebugLogging()
 	{
+#ifdef VKFW_ENABLE_VALIDATION_LAYERS
 		if (!Vulkan.enableValidationLayers)
 			return;
 
@@ -78,16 +507,513 @@ private:
 
 		if (vkCreateDebugReportCallbackEXT(Vulkan.instance, &createInfo, nullptr, Vulkan.debugCallback.Replace()) != VK_SUCCESS)
 			throw std::runtime_error("CreateDebugReportCallbackEXT failed");
+#endif // VKFW_ENABLE_VALIDATION_LAYERS
+	}
+
+	void PickPhysicalDevice()
+	{
+		uint32_t deviceCount;
+		vkEnumeratePhysicalDevices(Vulkan.instance, &deviceCount, nullptr);
+
+		if (deviceCount == 0)
+			throw std::runtime_error("No Vulkan capable device found");
+
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(Vulkan.instance, &deviceCount, devices.data());
+
+		for (VkPhysicalDevice device : devices)
+		{
+			uint32_t familyCount;
+			vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+
+			std::vector<VkQueueFamilyProperties> families(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, families.data());
+
+			for (uint32_t i = 0; i < familyCount; i++)
+			{
+				if (families[i].queueCount > 0 && (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+				{
+					Vulkan.physicalDevice = device;
+					Vulkan.graphicsQueueFamilyIndex = i;
+					break;
+				}
+			}
+
+			if (Vulkan.physicalDevice != device)
+				continue;
+
+			// a family without graphics runs compute next to the graphics queue
+			for (uint32_t i = 0; i < familyCount; i++)
+			{
+				if (families[i].queueCount > 0 && (families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+				{
+					Vulkan.computeQueueFamilyIndex = i;
+					break;
+				}
+			}
+
+			return;
+		}
+
+		throw std::runtime_error("No device with a graphics queue found");
+	}
+
+	void CreateLogicalDevice()
+	{
+		float queuePriority = 1.0f;
+
+		VkDeviceQueueCreateInfo queueInfos[2] = {};
+		uint32_t queueInfoCount = 1;
+
+		queueInfos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfos[0].pNext = nullptr;
+		queueInfos[0].flags = 0;
+		queueInfos[0].queueFamilyIndex = Vulkan.graphicsQueueFamilyIndex;
+		queueInfos[0].queueCount = 1;
+		queueInfos[0].pQueuePriorities = &queuePriority;
+
+		if (Vulkan.computeQueueFamilyIndex != UINT32_MAX)
+		{
+			queueInfos[1] = queueInfos[0];
+			queueInfos[1].queueFamilyIndex = Vulkan.computeQueueFamilyIndex;
+			queueInfoCount++;
+		}
+
+		// only what the renderer uses, indirect drawing for GPU culling
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(Vulkan.physicalDevice, &supportedFeatures);
+
+		VkPhysicalDeviceFeatures &features = Vulkan.enabledFeatures;
+		features = {};
+		features.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		features.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+		_loadDeviceExtensions();
+
+		uint32_t extensionCount;
+		const char** extensionNames = vkfwGetDeviceExtensions(&extensionCount);
+
+		VkDeviceCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+		createInfo.queueCreateInfoCount = queueInfoCount;
+		createInfo.pQueueCreateInfos = queueInfos;
+		createInfo.enabledLayerCount = 0;
+		createInfo.ppEnabledLayerNames = nullptr;
+		createInfo.enabledExtensionCount = extensionCount;
+		createInfo.ppEnabledExtensionNames = extensionNames;
+		createInfo.pEnabledFeatures = &features;
+
+		// extension features have to be queried and chained in to be usable
+		void* featureChain = nullptr;
+
+		if (vkfwIsDeviceExtensionEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+		{
+			Vulkan.descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+			Vulkan.descriptorIndexingFeatures.pNext = featureChain;
+			featureChain = &Vulkan.descriptorIndexingFeatures;
+		}
+
+		// present wait builds on present ids, both only matter to frame pacing
+		if (vkfwIsDeviceExtensionEnabled(VK_KHR_PRESENT_ID_EXTENSION_NAME))
+		{
+			Vulkan.presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+			Vulkan.presentIdFeatures.pNext = featureChain;
+			featureChain = &Vulkan.presentIdFeatures;
+		}
+
+		if (vkfwIsDeviceExtensionEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+		{
+			Vulkan.presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+			Vulkan.presentWaitFeatures.pNext = featureChain;
+			featureChain = &Vulkan.presentWaitFeatures;
+		}
+
+		if (featureChain != nullptr)
+		{
+			VkPhysicalDeviceFeatures2KHR features2 = {};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+			features2.pNext = featureChain;
+			vkGetPhysicalDeviceFeatures2KHR(Vulkan.physicalDevice, &features2);
+
+			createInfo.pNext = featureChain;
+		}
+
+		if (vkCreateDevice(Vulkan.physicalDevice, &createInfo, nullptr, Vulkan.device.Replace()) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create logical device");
+
+		_loadDeviceLevelEntryPoints();
+
+		vkGetDeviceQueue(Vulkan.device, Vulkan.graphicsQueueFamilyIndex, 0, &Vulkan.graphicsQueue);
+
+		if (Vulkan.computeQueueFamilyIndex != UINT32_MAX)
+			vkGetDeviceQueue(Vulkan.device, Vulkan.computeQueueFamilyIndex, 0, &Vulkan.computeQueue);
+	}
+
+	void CreateJobSystem()
+	{
+		uint32_t workerCount = std::thread::hardware_concurrency();
+		if (workerCount == 0)
+			workerCount = 1;
+
+		jobSystem.Create(workerCount, true);
+	}
+
+	void CreateFrameRing()
+	{
+		frameRing.Create(frameCount);
+		framePacer.Create(frameRing, settings.pacingMode, settings.frameRateLimit, frameProfiler);
+	}
+
+	void CreatePipelineCache()
+	{
+		// one cache per worker, any of them may end up creating pipelines, then one per compiler thread
+		uint32_t workerCount = jobSystem.GetWorkerCount();
+		pipelineCache.Create(PipelineCachePath, workerCount + PipelineCompilerThreads, PipelineCacheSaveInterval, startupProfiler);
+
+		pipelineCompiler.Create(pipelineCache, PipelineCompilerThreads, workerCount);
+		pipelineRegistry.Create(pipelineCompiler);
+
+#ifdef _DEBUG
+		shaderHotReload.Create(ShaderDirectory, pipelineCompiler, frameRing);
+#endif // _DEBUG
+	}
+
+	void CreateCommandContext()
+	{
+		commandContext.Create(Vulkan.graphicsQueueFamilyIndex, frameCount, jobSystem.GetWorkerCount());
+
+		if (Vulkan.computeQueue != VK_NULL_HANDLE)
+			computeContext.Create(Vulkan.computeQueueFamilyIndex, frameCount, jobSystem.GetWorkerCount());
+	}
+
+	void CreateDescriptorAllocator()
+	{
+		descriptorAllocator.Create(frameCount, jobSystem.GetWorkerCount());
+
+		// a cached set must sit unused well past the frames in flight before it goes
+		descriptorCache.Create(frameCount * 8);
+
+		// without descriptor indexing everything keeps going through per-draw sets
+		if (BindlessHeap::IsSupported())
+			bindlessHeap.Create(MaxBindlessTextures, MaxBindlessBuffers, frameCount);
+
+		descriptorBinder.Create(&descriptorAllocator);
+	}
+
+	void OpenShaderBundle()
+	{
+		Profiler::Scope scope(startupProfiler, "shader bundle open");
+
+		// without a bundle every shader loads from its own .spv file
+		if (shaderBundle.Open(ShaderBundlePath, ShaderDirectory))
+			std::cout << "shader bundle: " << shaderBundle.GetShaderCount() << " shaders" << std::endl;
+	}
+
+	void CreateGpuCulling()
+	{
+		if (GpuCulling::IsSupported())
+			gpuCulling.Create(MaxGpuInstances, frameCount, pipelineCache, shaderBundle);
+	}
+
+	void CreateScene()
+	{
+		uint32_t gpuInstances = GpuCulling::IsSupported() ? std::min(settings.sceneGpuInstances, gpuCulling.GetMaxInstances()) : 0;
+		scene.Create(settings.sceneObjects < MaxDraws ? settings.sceneObjects : MaxDraws, gpuInstances);
+
+		// the objects fan out over the culling jobs, each adds its survivors to the draw list
+		uint32_t objectCount = scene.GetObjectCount();
+
+		for (uint32_t begin = 0; begin < objectCount; begin += ObjectsPerCullTask)
+		{
+			uint32_t end = std::min(objectCount, begin + ObjectsPerCullTask);
+
+			cullTasks.push_back([this, begin, end]()
+			{
+				float planes[6][4];
+				GpuCulling::ExtractFrustumPlanes(viewProjection, planes);
+				scene.Cull(drawList, planes, begin, end);
+			});
+		}
+
+		// the frame's instance buffer is rewritten every time the frame comes around
+		if (gpuInstances > 0)
+		{
+			uploadTasks.push_back([this]()
+			{
+				gpuCulling.UpdateInstances(frame->index, scene.GetGpuInstances(), scene.GetGpuInstanceCount());
+			});
+
+			// the survivors are drawn with the shared mesh from the records the culling pass wrote
+			recordTasks.push_back([this](CommandRecorder &recorder)
+			{
+				const DrawList::Draw &mesh = scene.GetMeshDraw();
+
+				VkPipeline pipeline = culledMeshPipeline.Get();
+				if (pipeline == VK_NULL_HANDLE)
+					return;
+
+				// firstInstance is the instance's index, so the instances are bound from the start
+				VkBuffer instanceBuffer = gpuCulling.GetInstanceBuffer(frame->index).GetBuffer();
+				VkDeviceSize instanceOffset = 0;
+
+				recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline, mesh.pipelineLayout);
+				recorder.BindVertexBuffers(0, 1, &mesh.vertexBuffer, &mesh.vertexBufferOffset);
+				recorder.BindVertexBuffers(InstanceBinding, 1, &instanceBuffer, &instanceOffset);
+				recorder.BindIndexBuffer(mesh.indexBuffer, mesh.indexBufferOffset, mesh.indexType);
+
+				gpuCulling.Draw(recorder.GetCommandBuffer(), frame->index);
+			});
+		}
+	}
+
+	void CreateDrawList()
+	{
+		// every object may be visible, and each one adds a single draw
+		uint32_t drawCapacity = scene.GetObjectCount();
+
+		drawList.Reserve(drawCapacity, InstanceDataSize);
+		instanceBatcher.Create(drawCapacity, InstanceBinding);
+	}
+
+	void CreateUploadRing()
+	{
+		// the batcher packs the instance data of every draw in the list into one allocation
+		VkDeviceSize instanceDataSize = (VkDeviceSize)drawList.GetCapacity() * InstanceDataSize;
+
+		uploadRing.Create(UploadRingSizePerFrame + instanceDataSize, frameCount,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	}
+
+	// the scene's pipelines are needed before the first frame. Pipelines only have to be
+	// compatible with the render passes they are used in, so a render pass with a single
+	// attachment in the target's format stands in for the ones the graph creates
+	void CreateMeshPipelines()
+	{
+		Profiler::Scope scope(startupProfiler, "mesh pipelines");
+
+		VkAttachmentDescription attachment = {};
+		attachment.flags = 0;
+		attachment.format = presentTarget->GetFormat();
+		attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+		VkSubpassDescription subpass = {};
+		subpass.flags = 0;
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.inputAttachmentCount = 0;
+		subpass.pInputAttachments = nullptr;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorReference;
+		subpass.pResolveAttachments = nullptr;
+		subpass.pDepthStencilAttachment = nullptr;
+		subpass.preserveAttachmentCount = 0;
+		subpass.pPreserveAttachments = nullptr;
+
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.pNext = nullptr;
+		renderPassInfo.flags = 0;
+		renderPassInfo.attachmentCount = 1;
+		renderPassInfo.pAttachments = &attachment;
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = 0;
+		renderPassInfo.pDependencies = nullptr;
+
+		VkRenderPass renderPass;
+		if (vkCreateRenderPass(Vulkan.device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create mesh render pass");
+
+		// the mesh shaders read nothing but their vertex attributes
+		VkPipelineLayout pipelineLayout = pipelineLayoutCache.Get({}).pipelineLayout;
+
+		VkShaderModule vertexModule = shaderBundle.CreateShaderModule("Mesh.vert");
+		VkShaderModule culledVertexModule = shaderBundle.CreateShaderModule("MeshCulled.vert");
+		VkShaderModule fragmentModule = shaderBundle.CreateShaderModule("Mesh.frag");
+
+		// the cubes overlap without a depth buffer and are seen from both sides
+		auto describe = [&](VkShaderModule vertex)
+		{
+			PipelineDesc desc;
+			desc.layout = pipelineLayout;
+			desc.AddStage(VK_SHADER_STAGE_VERTEX_BIT, vertex);
+			desc.AddStage(VK_SHADER_STAGE_FRAGMENT_BIT, fragmentModule);
+			desc.AddVertexBinding(0, 3 * sizeof(float), VK_VERTEX_INPUT_RATE_VERTEX);
+			desc.AddVertexAttribute(0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0);
+			desc.cullMode = VK_CULL_MODE_NONE;
+			desc.depthTest = VK_FALSE;
+			desc.depthWrite = VK_FALSE;
+			desc.AddColorAttachment();
+			desc.SetRenderPass(renderPass, renderPassInfo);
+			return desc;
+		};
+
+		// draw list objects carry their world matrix, a location per column
+		PipelineDesc meshDesc = describe(vertexModule);
+		meshDesc.AddVertexBinding(InstanceBinding, InstanceDataSize, VK_VERTEX_INPUT_RATE_INSTANCE);
+
+		for (uint32_t column = 0; column < 4; column++)
+			meshDesc.AddVertexAttribute(1 + column, InstanceBinding, VK_FORMAT_R32G32B32A32_SFLOAT, column * 4 * sizeof(float));
+
+		// GPU culled instances read their sphere straight from the culling input
+		PipelineDesc culledDesc = describe(culledVertexModule);
+		culledDesc.AddVertexBinding(InstanceBinding, sizeof(GpuCulling::Instance), VK_VERTEX_INPUT_RATE_INSTANCE);
+		culledDesc.AddVertexAttribute(1, InstanceBinding, VK_FORMAT_R32G32B32A32_SFLOAT, 0);
+
+		meshPipeline = pipelineRegistry.Get(meshDesc);
+		culledMeshPipeline = pipelineRegistry.Get(culledDesc);
+
+		scene.SetMeshPipeline(meshPipeline.Wait(), pipelineLayout);
+		culledMeshPipeline.Wait();
+
+		// created pipelines keep neither their modules nor the render pass
+		vkDestroyShaderModule(Vulkan.device, vertexModule, nullptr);
+		vkDestroyShaderModule(Vulkan.device, culledVertexModule, nullptr);
+		vkDestroyShaderModule(Vulkan.device, fragmentModule, nullptr);
+		vkDestroyRenderPass(Vulkan.device, renderPass, nullptr);
+	}
+
+	void CreateRenderGraph()
+	{
+		renderGraph.Create(frameCount);
+
+		std::vector<uint32_t> queueFamilies = { Vulkan.graphicsQueueFamilyIndex };
+		std::vector<std::string> queueNames = { "graphics queue" };
+
+		if (renderGraph.HasAsyncCompute())
+		{
+			queueFamilies.push_back(Vulkan.computeQueueFamilyIndex);
+			queueNames.push_back("compute queue");
+		}
+
+		queueProfiler.Create(frameCount, queueFamilies, queueNames, gpuProfiler);
 	}
 };
 
 int main(int argc, char** argv)
 {
-	VulkanApplication application;
+	if (argc > 1 && !strcmp(argv[1], "--bench-jobs"))
+	{
+		RunJobBenchmark(std::cout);
+		return EXIT_SUCCESS;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "--bench-sort"))
+	{
+		RunSortBenchmark(std::cout);
+		return EXIT_SUCCESS;
+	}
+
+	// offline step, --pack-shaders [directory] [bundle]
+	if (argc > 1 && !strcmp(argv[1], "--pack-shaders"))
+	{
+		try
+		{
+			ShaderBundle::Pack(argc > 2 ? argv[2] : VulkanApplication::ShaderDirectory,
+				argc > 3 ? argv[3] : VulkanApplication::ShaderBundlePath, true, std::cout);
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	// --frames N sets the frames in flight, two keeps latency down, three keeps the GPU fed
+	VulkanApplication::Settings settings;
+
+	// --frame-limit FPS caps the frame rate, --low-latency starts each frame just in time
+	// --present-mode fifo|mailbox|immediate, --swapchain-images N
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+			settings.frameCount = (uint32_t)atoi(argv[i + 1]);
+
+		if (!strcmp(argv[i], "--frame-limit") && i + 1 < argc)
+		{
+			settings.frameRateLimit = atof(argv[i + 1]);
+
+			if (settings.pacingMode == FramePacer::ModeUnlimited)
+				settings.pacingMode = FramePacer::ModeLimit;
+		}
+
+		if (!strcmp(argv[i], "--low-latency"))
+			settings.pacingMode = FramePacer::ModeJustInTime;
+
+		if (!strcmp(argv[i], "--present-mode") && i + 1 < argc)
+		{
+			if (!strcmp(argv[i + 1], "mailbox"))
+				settings.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+			else if (!strcmp(argv[i + 1], "immediate"))
+				settings.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+			else
+				settings.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		}
+
+		if (!strcmp(argv[i], "--swapchain-images") && i + 1 < argc)
+			settings.swapchainImages = (uint32_t)atoi(argv[i + 1]);
+
+		// --headless FRAMES [--size WIDTHxHEIGHT] [--output png|exr|none] [--output-dir DIRECTORY]
+		if (!strcmp(argv[i], "--headless") && i + 1 < argc)
+			settings.headlessFrames = (uint32_t)atoi(argv[i + 1]);
+
+		if (!strcmp(argv[i], "--size") && i + 1 < argc)
+		{
+			// both dimensions, non-zero and nothing else, %u alone would take signs and wrap them
+			const char* size = argv[i + 1];
+			uint32_t width = 0, height = 0;
+			char rest;
+
+			if (strspn(size, "0123456789x") != strlen(size) || sscanf(size, "%ux%u%c", &width, &height, &rest) != 2 || width == 0 || height == 0)
+			{
+				std::cerr << "Invalid --size " << size << ", expected WIDTHxHEIGHT" << std::endl;
+				return EXIT_FAILURE;
+			}
+
+			settings.headlessWidth = width;
+			settings.headlessHeight = height;
+		}
+
+		if (!strcmp(argv[i], "--output") && i + 1 < argc)
+		{
+			if (!strcmp(argv[i + 1], "exr"))
+				settings.headlessOutput = HeadlessTarget::OutputExr;
+			else if (!strcmp(argv[i + 1], "none"))
+				settings.headlessOutput = HeadlessTarget::OutputNone;
+			else
+				settings.headlessOutput = HeadlessTarget::OutputPng;
+		}
+
+		if (!strcmp(argv[i], "--output-dir") && i + 1 < argc)
+			settings.outputDirectory = argv[i + 1];
+
+		// --objects N and --gpu-objects N size the generated scene
+		if (!strcmp(argv[i], "--objects") && i + 1 < argc)
+			settings.sceneObjects = (uint32_t)atoi(argv[i + 1]);
+
+		if (!strcmp(argv[i], "--gpu-objects") && i + 1 < argc)
+			settings.sceneGpuInstances = (uint32_t)atoi(argv[i + 1]);
+	}
 
 	try
 	{
-		application.Run();
+		VulkanApplication application(settings);
+
+		if (argc > 1 && !strcmp(argv[1], "--bench-descriptors"))
+			application.BenchmarkDescriptors();
+		else
+			application.Run();
 	}
 	catch (const std::exception &e)
 	{
@@ -0,0 +1,192 @@
+#include "PipelineCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "OS.h"
+
+PipelineCache::PipelineCache()
+{
+}
+
+PipelineCache::~PipelineCache()
+{
+	Destroy();
+}
+
+void PipelineCache::Create(const char* path, uint32_t threadCount, double saveIntervalSeconds, Profiler &profiler)
+{
+	assert(threadCount > 0);
+
+	this->path = path;
+	this->saveIntervalSeconds = saveIntervalSeconds;
+	this->profiler = &profiler;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<char> data;
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+	if (file.is_open())
+	{
+		data.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read(data.data(), data.size());
+
+		if (!file || !IsCompatible(data))
+		{
+			loadResult = LoadRejected;
+			data.clear();
+		}
+		else
+		{
+			loadResult = LoadAccepted;
+		}
+	}
+
+	threadCaches.resize(threadCount);
+	for (VkPipelineCache &cache : threadCaches)
+		cache = CreateCache(std::vector<char>());
+
+	mergedCache = CreateCache(data);
+
+	savedSize = data.size();
+	lastSave = std::chrono::steady_clock::now();
+
+	const char* section = loadResult == LoadAccepted ? "pipeline cache load (hit)"
+		: loadResult == LoadRejected ? "pipeline cache load (rejected)"
+		: "pipeline cache load (missing)";
+
+	profiler.Add(section, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+void PipelineCache::Destroy()
+{
+	for (VkPipelineCache cache : threadCaches)
+		vkDestroyPipelineCache(Vulkan.device, cache, nullptr);
+
+	if (mergedCache != VK_NULL_HANDLE)
+		vkDestroyPipelineCache(Vulkan.device, mergedCache, nullptr);
+
+	threadCaches.clear();
+	mergedCache = VK_NULL_HANDLE;
+}
+
+VkPipeline PipelineCache::CreateGraphicsPipeline(uint32_t threadIndex, const VkGraphicsPipelineCreateInfo &createInfo)
+{
+	Profiler::Scope scope(*profiler, GetCreationSection());
+
+	VkPipeline pipeline;
+	if (vkCreateGraphicsPipelines(Vulkan.device, GetThreadCache(threadIndex), 1, &createInfo, nullptr, &pipeline) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create graphics pipeline");
+
+	return pipeline;
+}
+
+VkPipeline PipelineCache::CreateComputePipeline(uint32_t threadIndex, const VkComputePipelineCreateInfo &createInfo)
+{
+	Profiler::Scope scope(*profiler, GetCreationSection());
+
+	VkPipeline pipeline;
+	if (vkCreateComputePipelines(Vulkan.device, GetThreadCache(threadIndex), 1, &createInfo, nullptr, &pipeline) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create compute pipeline");
+
+	return pipeline;
+}
+
+void PipelineCache::Update()
+{
+	if (saveIntervalSeconds <= 0.0)
+		return;
+
+	if (std::chrono::duration<double>(std::chrono::steady_clock::now() - lastSave).count() >= saveIntervalSeconds)
+		Save();
+}
+
+bool PipelineCache::Save()
+{
+	std::lock_guard<std::mutex> lock(saveMutex);
+
+	lastSave = std::chrono::steady_clock::now();
+
+	// entries already in the merged cache are skipped by the driver
+	if (vkMergePipelineCaches(Vulkan.device, mergedCache, (uint32_t)threadCaches.size(), threadCaches.data()) != VK_SUCCESS)
+		throw std::runtime_error("Failed to merge pipeline caches");
+
+	size_t size = 0;
+	if (vkGetPipelineCacheData(Vulkan.device, mergedCache, &size, nullptr) != VK_SUCCESS)
+		throw std::runtime_error("Failed to get pipeline cache size");
+
+	// drivers only ever append to a cache, an unchanged size means nothing new to write
+	if (size == savedSize)
+		return true;
+
+	std::vector<char> data(size);
+	if (vkGetPipelineCacheData(Vulkan.device, mergedCache, &size, data.data()) != VK_SUCCESS)
+		throw std::runtime_error("Failed to get pipeline cache data");
+
+	// write next to the old file and swap it in, a crash mid-write leaves the old cache intact
+	std::string temporaryPath = path + ".tmp";
+
+	std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+	file.write(data.data(), size);
+	file.close();
+
+	// a full disk or a read-only directory must not take the frame down with it
+	if (!file || !OSReplaceFile(temporaryPath.c_str(), path.c_str()))
+	{
+		std::cerr << "Failed to write pipeline cache " << path << std::endl;
+		remove(temporaryPath.c_str());
+		return false;
+	}
+
+	savedSize = size;
+	return true;
+}
+
+bool PipelineCache::IsCompatible(const std::vector<char> &data)
+{
+	// VK_PIPELINE_CACHE_HEADER_VERSION_ONE: header size, version, vendor ID, device ID, cache UUID
+	uint32_t header[4];
+	uint8_t uuid[VK_UUID_SIZE];
+
+	if (data.size() < sizeof(header) + sizeof(uuid))
+		return false;
+
+	memcpy(header, data.data(), sizeof(header));
+	memcpy(uuid, data.data() + sizeof(header), sizeof(uuid));
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(Vulkan.physicalDevice, &properties);
+
+	return header[0] >= sizeof(header) + sizeof(uuid)
+		&& header[0] <= data.size()
+		&& header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& header[2] == properties.vendorID
+		&& header[3] == properties.deviceID
+		&& memcmp(uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+VkPipelineCache PipelineCache::CreateCache(const std::vector<char> &initialData)
+{
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.initialDataSize = initialData.size();
+	createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+	VkPipelineCache cache;
+	if (vkCreatePipelineCache(Vulkan.device, &createInfo, nullptr, &cache) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create pipeline cache");
+
+	return cache;
+}
+
+const char* PipelineCache::GetCreationSection() const
+{
+	return loadResult == LoadAccepted ? "pipeline creation (warm cache)" : "pipeline creation (cold cache)";
+}
\ No newline at end of file
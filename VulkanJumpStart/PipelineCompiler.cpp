@@ -0,0 +1,135 @@
+#include "PipelineCompiler.h"
+
+#include <stdexcept>
+#include <assert.h>
+
+AsyncPipeline::AsyncPipeline()
+{
+}
+
+AsyncPipeline::AsyncPipeline(std::shared_future<VkPipeline> future, VkPipeline fallback)
+	: future(future), fallback(fallback)
+{
+}
+
+void AsyncPipeline::Update()
+{
+	if (pipeline != VK_NULL_HANDLE || !future.valid())
+		return;
+
+	if (future.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		pipeline = future.get();
+}
+
+VkPipeline AsyncPipeline::Wait()
+{
+	if (pipeline == VK_NULL_HANDLE && future.valid())
+		pipeline = future.get();
+
+	return Get();
+}
+
+void AsyncPipeline::Replace(VkPipeline pipeline)
+{
+	this->future = std::shared_future<VkPipeline>();
+	this->pipeline = pipeline;
+}
+
+PipelineCompiler::PipelineCompiler()
+{
+}
+
+PipelineCompiler::~PipelineCompiler()
+{
+	Destroy();
+}
+
+void PipelineCompiler::Create(PipelineCache &pipelineCache, uint32_t threadCount, uint32_t firstCacheThread)
+{
+	assert(threadCount > 0);
+
+	this->pipelineCache = &pipelineCache;
+	this->stopping = false;
+
+	for (uint32_t i = 0; i < threadCount; i++)
+		threads.emplace_back(&PipelineCompiler::ThreadMain, this, firstCacheThread + i);
+}
+
+void PipelineCompiler::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	wake.notify_all();
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	threads.clear();
+
+	for (Request &request : queue)
+		request.promise.set_value(VK_NULL_HANDLE);
+
+	queue.clear();
+}
+
+std::shared_future<VkPipeline> PipelineCompiler::Compile(PipelineDesc desc)
+{
+	Request request;
+	request.desc = std::move(desc);
+
+	std::shared_future<VkPipeline> future = request.promise.get_future().share();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (stopping)
+		{
+			request.promise.set_exception(std::make_exception_ptr(std::runtime_error("Failed to compile pipeline, the compiler is not running")));
+			return future;
+		}
+
+		queue.push_back(std::move(request));
+	}
+
+	wake.notify_one();
+
+	return future;
+}
+
+uint32_t PipelineCompiler::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return (uint32_t)queue.size();
+}
+
+void PipelineCompiler::ThreadMain(uint32_t cacheThread)
+{
+	while (true)
+	{
+		Request request;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+			if (stopping)
+				return;
+
+			request = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		// a failed creation reaches whoever waits on the future instead of ending the thread
+		try
+		{
+			request.promise.set_value(request.desc.Create(*pipelineCache, cacheThread));
+		}
+		catch (...)
+		{
+			request.promise.set_exception(std::current_exception());
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,492 @@
+#include "PipelineDesc.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include "Hash.h"
+
+PipelineDesc::PipelineDesc()
+{
+	bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	layout = VK_NULL_HANDLE;
+
+	topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	primitiveRestart = VK_FALSE;
+
+	depthClamp = VK_FALSE;
+	polygonMode = VK_POLYGON_MODE_FILL;
+	cullMode = VK_CULL_MODE_BACK_BIT;
+	frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	depthBias = VK_FALSE;
+	depthBiasConstant = 0.0f;
+	depthBiasSlope = 0.0f;
+	lineWidth = 1.0f;
+
+	samples = VK_SAMPLE_COUNT_1_BIT;
+	alphaToCoverage = VK_FALSE;
+
+	depthTest = VK_TRUE;
+	depthWrite = VK_TRUE;
+	depthCompare = VK_COMPARE_OP_LESS_OR_EQUAL;
+	stencilTest = VK_FALSE;
+	stencilFront = {};
+	stencilBack = {};
+
+	blendConstants[0] = blendConstants[1] = blendConstants[2] = blendConstants[3] = 0.0f;
+
+	renderPass = VK_NULL_HANDLE;
+	renderPassHash = 0;
+	subpass = 0;
+}
+
+void PipelineDesc::AddStage(VkShaderStageFlagBits stage, VkShaderModule module, std::shared_ptr<const std::vector<uint32_t>> code, const char* entryPoint)
+{
+	ShaderStageDesc stageDesc;
+	stageDesc.stage = stage;
+	stageDesc.module = module;
+	stageDesc.moduleHash = code ? HashBytes(code->data(), code->size() * sizeof(uint32_t)) : 0;
+	stageDesc.code = std::move(code);
+	stageDesc.entryPoint = entryPoint;
+
+	stages.push_back(std::move(stageDesc));
+}
+
+void PipelineDesc::SetSpecialization(uint32_t constantId, const void* data, size_t size)
+{
+	assert(!stages.empty());
+
+	SetSpecialization(stages.back().stage, constantId, data, size);
+}
+
+void PipelineDesc::SetSpecialization(VkShaderStageFlags stageMask, uint32_t constantId, const void* data, size_t size)
+{
+	for (ShaderStageDesc &stage : stages)
+	{
+		if (!(stage.stage & stageMask))
+			continue;
+
+		VkSpecializationMapEntry entry;
+		entry.constantID = constantId;
+		entry.offset = (uint32_t)stage.specializationData.size();
+		entry.size = size;
+
+		stage.specializationEntries.push_back(entry);
+		stage.specializationData.insert(stage.specializationData.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+	}
+}
+
+void PipelineDesc::AddVertexBinding(uint32_t binding, uint32_t stride, VkVertexInputRate inputRate)
+{
+	vertexBindings.push_back({ binding, stride, inputRate });
+}
+
+void PipelineDesc::AddVertexAttribute(uint32_t location, uint32_t binding, VkFormat format, uint32_t offset)
+{
+	vertexAttributes.push_back({ location, binding, format, offset });
+}
+
+void PipelineDesc::AddColorAttachment()
+{
+	VkPipelineColorBlendAttachmentState state = {};
+	state.blendEnable = VK_FALSE;
+	state.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	state.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+	state.colorBlendOp = VK_BLEND_OP_ADD;
+	state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	state.alphaBlendOp = VK_BLEND_OP_ADD;
+	state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	colorAttachments.push_back(state);
+}
+
+void PipelineDesc::AddColorAttachment(const VkPipelineColorBlendAttachmentState &state)
+{
+	colorAttachments.push_back(state);
+}
+
+VkPipeline PipelineDesc::Create(PipelineCache &pipelineCache, uint32_t threadIndex) const
+{
+	assert(!stages.empty() && layout != VK_NULL_HANDLE);
+
+	std::vector<VkSpecializationInfo> specializations(stages.size());
+	std::vector<VkPipelineShaderStageCreateInfo> stageInfos(stages.size());
+
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		const ShaderStageDesc &stage = stages[i];
+
+		VkSpecializationInfo &specialization = specializations[i];
+		specialization.mapEntryCount = (uint32_t)stage.specializationEntries.size();
+		specialization.pMapEntries = stage.specializationEntries.data();
+		specialization.dataSize = stage.specializationData.size();
+		specialization.pData = stage.specializationData.data();
+
+		VkPipelineShaderStageCreateInfo &stageInfo = stageInfos[i];
+		stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stageInfo.pNext = nullptr;
+		stageInfo.flags = 0;
+		stageInfo.stage = stage.stage;
+		stageInfo.module = stage.module;
+		stageInfo.pName = stage.entryPoint.c_str();
+		stageInfo.pSpecializationInfo = stage.specializationEntries.empty() ? nullptr : &specialization;
+	}
+
+	if (bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
+		return CreateGraphics(pipelineCache, threadIndex, stageInfos.data());
+
+	assert(stages.size() == 1 && stages[0].stage == VK_SHADER_STAGE_COMPUTE_BIT);
+
+	VkComputePipelineCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.stage = stageInfos[0];
+	createInfo.layout = layout;
+	createInfo.basePipelineHandle = VK_NULL_HANDLE;
+	createInfo.basePipelineIndex = -1;
+
+	return pipelineCache.CreateComputePipeline(threadIndex, createInfo);
+}
+
+void PipelineDesc::SetRenderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo &createInfo)
+{
+	this->renderPass = renderPass;
+
+	renderPassCompatibility = DescribeRenderPassCompatibility(createInfo);
+	renderPassHash = HashBytes(renderPassCompatibility.data(), renderPassCompatibility.size() * sizeof(uint32_t));
+}
+
+uint64_t PipelineDesc::Hash() const
+{
+	uint64_t hash = HashValue(bindPoint, HashSeed);
+	hash = HashValue(layout, hash);
+
+	for (const ShaderStageDesc &stage : stages)
+	{
+		hash = HashValue(stage.stage, hash);
+		hash = stage.code ? HashValue(stage.moduleHash, hash) : HashValue(stage.module, hash);
+		hash = HashBytes(stage.entryPoint.data(), stage.entryPoint.size(), hash);
+
+		for (const VkSpecializationMapEntry &entry : stage.specializationEntries)
+		{
+			hash = HashValue(entry.constantID, hash);
+			hash = HashValue(entry.offset, hash);
+			hash = HashValue(entry.size, hash);
+		}
+
+		hash = HashBytes(stage.specializationData.data(), stage.specializationData.size(), hash);
+	}
+
+	if (bindPoint != VK_PIPELINE_BIND_POINT_GRAPHICS)
+		return hash;
+
+	for (const VkVertexInputBindingDescription &binding : vertexBindings)
+	{
+		hash = HashValue(binding.binding, hash);
+		hash = HashValue(binding.stride, hash);
+		hash = HashValue(binding.inputRate, hash);
+	}
+
+	for (const VkVertexInputAttributeDescription &attribute : vertexAttributes)
+	{
+		hash = HashValue(attribute.location, hash);
+		hash = HashValue(attribute.binding, hash);
+		hash = HashValue(attribute.format, hash);
+		hash = HashValue(attribute.offset, hash);
+	}
+
+	hash = HashValue(topology, hash);
+	hash = HashValue(primitiveRestart, hash);
+
+	hash = HashValue(depthClamp, hash);
+	hash = HashValue(polygonMode, hash);
+	hash = HashValue(cullMode, hash);
+	hash = HashValue(frontFace, hash);
+	hash = HashValue(depthBias, hash);
+	hash = HashValue(depthBiasConstant, hash);
+	hash = HashValue(depthBiasSlope, hash);
+	hash = HashValue(lineWidth, hash);
+
+	hash = HashValue(samples, hash);
+	hash = HashValue(alphaToCoverage, hash);
+
+	hash = HashValue(depthTest, hash);
+	hash = HashValue(depthWrite, hash);
+	hash = HashValue(depthCompare, hash);
+	hash = HashValue(stencilTest, hash);
+
+	// VkStencilOpState is all 32-bit fields, no padding to skip
+	hash = HashValue(stencilFront, hash);
+	hash = HashValue(stencilBack, hash);
+
+	// as is VkPipelineColorBlendAttachmentState
+	for (const VkPipelineColorBlendAttachmentState &attachment : colorAttachments)
+		hash = HashValue(attachment, hash);
+
+	hash = HashValue(blendConstants, hash);
+
+	for (VkDynamicState state : dynamicStates)
+		hash = HashValue(state, hash);
+
+	hash = !renderPassCompatibility.empty() ? HashValue(renderPassHash, hash) : HashValue(renderPass, hash);
+	hash = HashValue(subpass, hash);
+
+	return hash;
+}
+
+bool PipelineDesc::operator ==(const PipelineDesc &rhs) const
+{
+	if (bindPoint != rhs.bindPoint || layout != rhs.layout || stages.size() != rhs.stages.size())
+		return false;
+
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		const ShaderStageDesc &a = stages[i];
+		const ShaderStageDesc &b = rhs.stages[i];
+
+		if (a.stage != b.stage || a.entryPoint != b.entryPoint
+			|| a.specializationData != b.specializationData || a.specializationEntries.size() != b.specializationEntries.size())
+			return false;
+
+		// equal hashes are only a hint, the code itself decides
+		if (!a.code != !b.code)
+			return false;
+
+		if (a.code ? a.code != b.code && (a.moduleHash != b.moduleHash || *a.code != *b.code) : a.module != b.module)
+			return false;
+
+		for (size_t j = 0; j < a.specializationEntries.size(); j++)
+		{
+			const VkSpecializationMapEntry &entryA = a.specializationEntries[j];
+			const VkSpecializationMapEntry &entryB = b.specializationEntries[j];
+
+			if (entryA.constantID != entryB.constantID || entryA.offset != entryB.offset || entryA.size != entryB.size)
+				return false;
+		}
+	}
+
+	if (bindPoint != VK_PIPELINE_BIND_POINT_GRAPHICS)
+		return true;
+
+	if (vertexBindings.size() != rhs.vertexBindings.size()
+		|| vertexAttributes.size() != rhs.vertexAttributes.size()
+		|| colorAttachments.size() != rhs.colorAttachments.size()
+		|| dynamicStates != rhs.dynamicStates)
+		return false;
+
+	for (size_t i = 0; i < vertexBindings.size(); i++)
+	{
+		const VkVertexInputBindingDescription &a = vertexBindings[i];
+		const VkVertexInputBindingDescription &b = rhs.vertexBindings[i];
+
+		if (a.binding != b.binding || a.stride != b.stride || a.inputRate != b.inputRate)
+			return false;
+	}
+
+	for (size_t i = 0; i < vertexAttributes.size(); i++)
+	{
+		const VkVertexInputAttributeDescription &a = vertexAttributes[i];
+		const VkVertexInputAttributeDescription &b = rhs.vertexAttributes[i];
+
+		if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset)
+			return false;
+	}
+
+	if (memcmp(colorAttachments.data(), rhs.colorAttachments.data(), colorAttachments.size() * sizeof(VkPipelineColorBlendAttachmentState)) != 0
+		|| memcmp(&stencilFront, &rhs.stencilFront, sizeof(VkStencilOpState)) != 0
+		|| memcmp(&stencilBack, &rhs.stencilBack, sizeof(VkStencilOpState)) != 0
+		|| memcmp(blendConstants, rhs.blendConstants, sizeof(blendConstants)) != 0)
+		return false;
+
+	if (renderPassHash != rhs.renderPassHash || renderPassCompatibility != rhs.renderPassCompatibility
+		|| (renderPassCompatibility.empty() && renderPass != rhs.renderPass))
+		return false;
+
+	return topology == rhs.topology
+		&& primitiveRestart == rhs.primitiveRestart
+		&& depthClamp == rhs.depthClamp
+		&& polygonMode == rhs.polygonMode
+		&& cullMode == rhs.cullMode
+		&& frontFace == rhs.frontFace
+		&& depthBias == rhs.depthBias
+		&& depthBiasConstant == rhs.depthBiasConstant
+		&& depthBiasSlope == rhs.depthBiasSlope
+		&& lineWidth == rhs.lineWidth
+		&& samples == rhs.samples
+		&& alphaToCoverage == rhs.alphaToCoverage
+		&& depthTest == rhs.depthTest
+		&& depthWrite == rhs.depthWrite
+		&& depthCompare == rhs.depthCompare
+		&& stencilTest == rhs.stencilTest
+		&& subpass == rhs.subpass;
+}
+
+std::vector<uint32_t> PipelineDesc::DescribeRenderPassCompatibility(const VkRenderPassCreateInfo &createInfo)
+{
+	std::vector<uint32_t> description;
+
+	description.push_back(createInfo.flags);
+	description.push_back(createInfo.attachmentCount);
+
+	for (uint32_t i = 0; i < createInfo.attachmentCount; i++)
+	{
+		description.push_back(createInfo.pAttachments[i].flags);
+		description.push_back(createInfo.pAttachments[i].format);
+		description.push_back(createInfo.pAttachments[i].samples);
+	}
+
+	auto describeReferences = [&description](uint32_t count, const VkAttachmentReference* references)
+	{
+		description.push_back(count);
+
+		// only the attachment index matters, not the layout
+		for (uint32_t i = 0; references && i < count; i++)
+			description.push_back(references[i].attachment);
+	};
+
+	description.push_back(createInfo.subpassCount);
+
+	for (uint32_t i = 0; i < createInfo.subpassCount; i++)
+	{
+		const VkSubpassDescription &subpass = createInfo.pSubpasses[i];
+
+		description.push_back(subpass.flags);
+		description.push_back(subpass.pipelineBindPoint);
+
+		describeReferences(subpass.inputAttachmentCount, subpass.pInputAttachments);
+		describeReferences(subpass.colorAttachmentCount, subpass.pColorAttachments);
+		describeReferences(subpass.pResolveAttachments ? subpass.colorAttachmentCount : 0, subpass.pResolveAttachments);
+		describeReferences(subpass.pDepthStencilAttachment ? 1 : 0, subpass.pDepthStencilAttachment);
+
+		description.push_back(subpass.preserveAttachmentCount);
+		description.insert(description.end(), subpass.pPreserveAttachments, subpass.pPreserveAttachments + subpass.preserveAttachmentCount);
+	}
+
+	description.push_back(createInfo.dependencyCount);
+
+	// VkSubpassDependency is all 32-bit fields
+	const uint32_t* dependencies = (const uint32_t*)createInfo.pDependencies;
+	description.insert(description.end(), dependencies, dependencies + createInfo.dependencyCount * sizeof(VkSubpassDependency) / sizeof(uint32_t));
+
+	return description;
+}
+
+uint64_t PipelineDesc::HashRenderPassCompatibility(const VkRenderPassCreateInfo &createInfo)
+{
+	std::vector<uint32_t> description = DescribeRenderPassCompatibility(createInfo);
+
+	return HashBytes(description.data(), description.size() * sizeof(uint32_t));
+}
+
+VkPipeline PipelineDesc::CreateGraphics(PipelineCache &pipelineCache, uint32_t threadIndex, const VkPipelineShaderStageCreateInfo* stageInfos) const
+{
+	VkPipelineVertexInputStateCreateInfo vertexInput = {};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInput.pNext = nullptr;
+	vertexInput.flags = 0;
+	vertexInput.vertexBindingDescriptionCount = (uint32_t)vertexBindings.size();
+	vertexInput.pVertexBindingDescriptions = vertexBindings.data();
+	vertexInput.vertexAttributeDescriptionCount = (uint32_t)vertexAttributes.size();
+	vertexInput.pVertexAttributeDescriptions = vertexAttributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.pNext = nullptr;
+	inputAssembly.flags = 0;
+	inputAssembly.topology = topology;
+	inputAssembly.primitiveRestartEnable = primitiveRestart;
+
+	VkPipelineViewportStateCreateInfo viewport = {};
+	viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport.pNext = nullptr;
+	viewport.flags = 0;
+	viewport.viewportCount = 1;
+	viewport.pViewports = nullptr;
+	viewport.scissorCount = 1;
+	viewport.pScissors = nullptr;
+
+	VkPipelineRasterizationStateCreateInfo rasterization = {};
+	rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization.pNext = nullptr;
+	rasterization.flags = 0;
+	rasterization.depthClampEnable = depthClamp;
+	rasterization.rasterizerDiscardEnable = VK_FALSE;
+	rasterization.polygonMode = polygonMode;
+	rasterization.cullMode = cullMode;
+	rasterization.frontFace = frontFace;
+	rasterization.depthBiasEnable = depthBias;
+	rasterization.depthBiasConstantFactor = depthBiasConstant;
+	rasterization.depthBiasClamp = 0.0f;
+	rasterization.depthBiasSlopeFactor = depthBiasSlope;
+	rasterization.lineWidth = lineWidth;
+
+	VkPipelineMultisampleStateCreateInfo multisample = {};
+	multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.pNext = nullptr;
+	multisample.flags = 0;
+	multisample.rasterizationSamples = samples;
+	multisample.sampleShadingEnable = VK_FALSE;
+	multisample.minSampleShading = 0.0f;
+	multisample.pSampleMask = nullptr;
+	multisample.alphaToCoverageEnable = alphaToCoverage;
+	multisample.alphaToOneEnable = VK_FALSE;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.pNext = nullptr;
+	depthStencil.flags = 0;
+	depthStencil.depthTestEnable = depthTest;
+	depthStencil.depthWriteEnable = depthWrite;
+	depthStencil.depthCompareOp = depthCompare;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = stencilTest;
+	depthStencil.front = stencilFront;
+	depthStencil.back = stencilBack;
+	depthStencil.minDepthBounds = 0.0f;
+	depthStencil.maxDepthBounds = 1.0f;
+
+	VkPipelineColorBlendStateCreateInfo colorBlend = {};
+	colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlend.pNext = nullptr;
+	colorBlend.flags = 0;
+	colorBlend.logicOpEnable = VK_FALSE;
+	colorBlend.logicOp = VK_LOGIC_OP_COPY;
+	colorBlend.attachmentCount = (uint32_t)colorAttachments.size();
+	colorBlend.pAttachments = colorAttachments.data();
+	memcpy(colorBlend.blendConstants, blendConstants, sizeof(blendConstants));
+
+	std::vector<VkDynamicState> allDynamicStates = dynamicStates;
+	allDynamicStates.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+	allDynamicStates.push_back(VK_DYNAMIC_STATE_SCISSOR);
+
+	VkPipelineDynamicStateCreateInfo dynamic = {};
+	dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic.pNext = nullptr;
+	dynamic.flags = 0;
+	dynamic.dynamicStateCount = (uint32_t)allDynamicStates.size();
+	dynamic.pDynamicStates = allDynamicStates.data();
+
+	VkGraphicsPipelineCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.stageCount = (uint32_t)stages.size();
+	createInfo.pStages = stageInfos;
+	createInfo.pVertexInputState = &vertexInput;
+	createInfo.pInputAssemblyState = &inputAssembly;
+	createInfo.pTessellationState = nullptr;
+	createInfo.pViewportState = &viewport;
+	createInfo.pRasterizationState = &rasterization;
+	createInfo.pMultisampleState = &multisample;
+	createInfo.pDepthStencilState = &depthStencil;
+	createInfo.pColorBlendState = &colorBlend;
+	createInfo.pDynamicState = &dynamic;
+	createInfo.layout = layout;
+	createInfo.renderPass = renderPass;
+	createInfo.subpass = subpass;
+	createInfo.basePipelineHandle = VK_NULL_HANDLE;
+	createInfo.basePipelineIndex = -1;
+
+	return pipelineCache.CreateGraphicsPipeline(threadIndex, createInfo);
+}
\ No newline at end of file
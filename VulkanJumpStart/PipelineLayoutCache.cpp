@@ -0,0 +1,260 @@
+#include "PipelineLayoutCache.h"
+
+#include <algorithm>
+#include <string>
+#include <assert.h>
+
+#include "Hash.h"
+
+static bool BindingsEqual(const std::vector<VkDescriptorSetLayoutBinding> &a, const std::vector<VkDescriptorSetLayoutBinding> &b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].binding != b[i].binding
+			|| a[i].descriptorType != b[i].descriptorType
+			|| a[i].descriptorCount != b[i].descriptorCount
+			|| a[i].stageFlags != b[i].stageFlags)
+			return false;
+	}
+
+	return true;
+}
+
+PipelineLayoutCache::PipelineLayoutCache()
+{
+}
+
+PipelineLayoutCache::~PipelineLayoutCache()
+{
+	Destroy();
+}
+
+void PipelineLayoutCache::Destroy()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto &bucket : pipelineLayouts)
+	{
+		for (PipelineLayoutEntry &entry : bucket.second)
+			vkDestroyPipelineLayout(Vulkan.device, entry.layout.pipelineLayout, nullptr);
+	}
+
+	for (auto &bucket : setLayouts)
+	{
+		for (SetLayoutEntry &entry : bucket.second)
+			vkDestroyDescriptorSetLayout(Vulkan.device, entry.layout, nullptr);
+	}
+
+	pipelineLayouts.clear();
+	setLayouts.clear();
+	stats = Stats();
+}
+
+const PipelineLayoutCache::Layout& PipelineLayoutCache::Get(const std::vector<const ShaderReflection*> &stages, const std::vector<VkDescriptorSetLayout> &fixedSetLayouts)
+{
+	// merge the stages, the same binding seen twice has to agree on its type
+	std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets(fixedSetLayouts.size());
+	VkPushConstantRange pushConstants = {};
+	uint32_t pushEnd = 0;
+
+	for (const ShaderReflection* stage : stages)
+	{
+		for (const ReflectedBinding &reflected : stage->bindings)
+		{
+			if (reflected.set < fixedSetLayouts.size() && fixedSetLayouts[reflected.set] != VK_NULL_HANDLE)
+				continue;
+
+			if (reflected.count == 0)
+				throw std::runtime_error("Runtime sized descriptor array at set " + std::to_string(reflected.set)
+					+ " binding " + std::to_string(reflected.binding) + " needs a fixed set layout");
+
+			if (reflected.set >= sets.size())
+				sets.resize(reflected.set + 1);
+
+			std::vector<VkDescriptorSetLayoutBinding> &set = sets[reflected.set];
+
+			auto found = std::find_if(set.begin(), set.end(), [&reflected](const VkDescriptorSetLayoutBinding &binding)
+			{
+				return binding.binding == reflected.binding;
+			});
+
+			if (found == set.end())
+			{
+				VkDescriptorSetLayoutBinding binding = {};
+				binding.binding = reflected.binding;
+				binding.descriptorType = reflected.type;
+				binding.descriptorCount = reflected.count;
+				binding.stageFlags = reflected.stages;
+				binding.pImmutableSamplers = nullptr;
+
+				set.push_back(binding);
+				continue;
+			}
+
+			if (found->descriptorType != reflected.type)
+				throw std::runtime_error("Shader stages disagree on the type of set " + std::to_string(reflected.set)
+					+ " binding " + std::to_string(reflected.binding));
+
+			found->descriptorCount = std::max(found->descriptorCount, reflected.count);
+			found->stageFlags |= reflected.stages;
+		}
+
+		if (stage->pushConstants.size > 0)
+		{
+			uint32_t end = stage->pushConstants.offset + stage->pushConstants.size;
+
+			pushConstants.offset = pushConstants.stageFlags ? std::min(pushConstants.offset, stage->pushConstants.offset) : stage->pushConstants.offset;
+			pushConstants.stageFlags |= stage->pushConstants.stageFlags;
+			pushEnd = std::max(pushEnd, end);
+		}
+	}
+
+	pushConstants.size = pushEnd - pushConstants.offset;
+
+	std::vector<VkDescriptorSetLayout> layouts(sets.size());
+
+	for (size_t i = 0; i < sets.size(); i++)
+	{
+		if (i < fixedSetLayouts.size() && fixedSetLayouts[i] != VK_NULL_HANDLE)
+		{
+			layouts[i] = fixedSetLayouts[i];
+			continue;
+		}
+
+		std::sort(sets[i].begin(), sets[i].end(), [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b)
+		{
+			return a.binding < b.binding;
+		});
+
+		layouts[i] = GetSetLayout(sets[i]);
+	}
+
+	uint64_t hash = HashSeed;
+	for (VkDescriptorSetLayout layout : layouts)
+		hash = HashValue(layout, hash);
+
+	hash = HashValue(pushConstants.stageFlags, hash);
+	hash = HashValue(pushConstants.offset, hash);
+	hash = HashValue(pushConstants.size, hash);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	stats.requests++;
+
+	std::list<PipelineLayoutEntry> &bucket = pipelineLayouts[hash];
+
+	for (const PipelineLayoutEntry &entry : bucket)
+	{
+		if (entry.setLayouts == layouts
+			&& entry.pushConstants.stageFlags == pushConstants.stageFlags
+			&& entry.pushConstants.offset == pushConstants.offset
+			&& entry.pushConstants.size == pushConstants.size)
+		{
+			stats.hits++;
+			return entry.layout;
+		}
+	}
+
+	VkPipelineLayoutCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.setLayoutCount = (uint32_t)layouts.size();
+	createInfo.pSetLayouts = layouts.data();
+	createInfo.pushConstantRangeCount = pushConstants.size > 0 ? 1 : 0;
+	createInfo.pPushConstantRanges = &pushConstants;
+
+	PipelineLayoutEntry entry;
+	entry.setLayouts = layouts;
+	entry.pushConstants = pushConstants;
+	entry.layout.setLayouts = layouts;
+
+	if (vkCreatePipelineLayout(Vulkan.device, &createInfo, nullptr, &entry.layout.pipelineLayout) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create pipeline layout");
+
+	// fixed sets come with their own pools, their pool sizes stay empty
+	entry.layout.setPoolSizes.resize(sets.size());
+
+	for (size_t i = 0; i < sets.size(); i++)
+	{
+		std::vector<VkDescriptorPoolSize> &sizes = entry.layout.setPoolSizes[i];
+
+		for (const VkDescriptorSetLayoutBinding &binding : sets[i])
+		{
+			auto found = std::find_if(sizes.begin(), sizes.end(), [&binding](const VkDescriptorPoolSize &size)
+			{
+				return size.type == binding.descriptorType;
+			});
+
+			if (found == sizes.end())
+				sizes.push_back({ binding.descriptorType, binding.descriptorCount });
+			else
+				found->descriptorCount += binding.descriptorCount;
+		}
+	}
+
+	bucket.push_back(std::move(entry));
+	stats.pipelineLayouts++;
+
+	return bucket.back().layout;
+}
+
+VkDescriptorSetLayout PipelineLayoutCache::GetSetLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings)
+{
+	uint64_t hash = HashSeed;
+
+	for (const VkDescriptorSetLayoutBinding &binding : bindings)
+	{
+		hash = HashValue(binding.binding, hash);
+		hash = HashValue(binding.descriptorType, hash);
+		hash = HashValue(binding.descriptorCount, hash);
+		hash = HashValue(binding.stageFlags, hash);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::vector<SetLayoutEntry> &bucket = setLayouts[hash];
+
+	for (const SetLayoutEntry &entry : bucket)
+	{
+		if (BindingsEqual(entry.bindings, bindings))
+			return entry.layout;
+	}
+
+	VkDescriptorSetLayoutCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.bindingCount = (uint32_t)bindings.size();
+	createInfo.pBindings = bindings.data();
+
+	SetLayoutEntry entry;
+	entry.bindings = bindings;
+
+	if (vkCreateDescriptorSetLayout(Vulkan.device, &createInfo, nullptr, &entry.layout) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create descriptor set layout");
+
+	bucket.push_back(std::move(entry));
+	stats.setLayouts++;
+
+	return bucket.back().layout;
+}
+
+PipelineLayoutCache::Stats PipelineLayoutCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void PipelineLayoutCache::PrintStats(std::ostream &stream) const
+{
+	Stats current = GetStats();
+
+	stream << "pipeline layouts: " << current.pipelineLayouts << " pipeline layouts"
+		<< ", " << current.setLayouts << " set layouts"
+		<< ", requests " << current.requests
+		<< ", shared " << current.hits << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "PipelineRegistry.h"
+
+PipelineRegistry::PipelineRegistry()
+{
+}
+
+PipelineRegistry::~PipelineRegistry()
+{
+	Destroy();
+}
+
+void PipelineRegistry::Create(PipelineCompiler &compiler)
+{
+	this->compiler = &compiler;
+}
+
+void PipelineRegistry::Destroy()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto &bucket : entries)
+	{
+		for (Entry &entry : bucket.second)
+		{
+			VkPipeline pipeline = VK_NULL_HANDLE;
+
+			// a failed creation has nothing to destroy
+			try
+			{
+				pipeline = entry.future.get();
+			}
+			catch (const std::exception &)
+			{
+			}
+
+			if (pipeline != VK_NULL_HANDLE)
+				vkDestroyPipeline(Vulkan.device, pipeline, nullptr);
+		}
+	}
+
+	entries.clear();
+	stats.size = 0;
+}
+
+AsyncPipeline PipelineRegistry::Get(const PipelineDesc &desc, VkPipeline fallback)
+{
+	uint64_t hash = desc.Hash();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	stats.requests++;
+
+	std::vector<Entry> &bucket = entries[hash];
+
+	for (const Entry &entry : bucket)
+	{
+		if (entry.desc == desc)
+		{
+			stats.hits++;
+			return AsyncPipeline(entry.future, fallback);
+		}
+	}
+
+	Entry entry;
+	entry.desc = desc;
+	entry.future = compiler->Compile(desc);
+
+	bucket.push_back(std::move(entry));
+	stats.size++;
+
+	return AsyncPipeline(bucket.back().future, fallback);
+}
+
+PipelineRegistry::Stats PipelineRegistry::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void PipelineRegistry::PrintStats(std::ostream &stream) const
+{
+	Stats current = GetStats();
+
+	stream << "pipeline registry: " << current.size << " pipelines"
+		<< ", requests " << current.requests
+		<< ", deduplicated " << current.hits << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "Profiler.h"
+
+Profiler::Scope::Scope(Profiler &profiler, const char* name)
+	: profiler(profiler), name(name), start(std::chrono::high_resolution_clock::now())
+{
+}
+
+Profiler::Scope::~Scope()
+{
+	profiler.Add(name, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+Profiler::Profiler()
+{
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::Add(const char* name, double seconds)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (Section &section : sections)
+	{
+		if (section.name == name)
+		{
+			section.seconds += seconds;
+			section.count++;
+			return;
+		}
+	}
+
+	sections.push_back({ name, seconds, 1 });
+}
+
+void Profiler::Print(std::ostream &stream) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (const Section &section : sections)
+	{
+		stream << section.name << ": " << section.seconds * 1000.0 << " ms";
+
+		if (section.count > 1)
+			stream << " over " << section.count << ", " << section.seconds * 1000.0 / section.count << " ms each";
+
+		stream << std::endl;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "QueueProfiler.h"
+
+#include <algorithm>
+#include <cfloat>
+
+// total length of the union of the intervals, sorted by start
+static double MergedLength(std::vector<std::pair<double, double>> &intervals, std::vector<std::pair<double, double>> &merged)
+{
+	std::sort(intervals.begin(), intervals.end());
+
+	merged.clear();
+	double length = 0.0;
+
+	for (const std::pair<double, double> &interval : intervals)
+	{
+		if (!merged.empty() && interval.first <= merged.back().second)
+		{
+			merged.back().second = std::max(merged.back().second, interval.second);
+			continue;
+		}
+
+		merged.push_back(interval);
+	}
+
+	for (const std::pair<double, double> &interval : merged)
+		length += interval.second - interval.first;
+
+	return length;
+}
+
+QueueProfiler::QueueProfiler()
+{
+}
+
+QueueProfiler::~QueueProfiler()
+{
+	Destroy();
+}
+
+void QueueProfiler::Create(uint32_t frameCount, const std::vector<uint32_t> &queueFamilyIndices, const std::vector<std::string> &queueNames, Profiler &sink)
+{
+	this->queueNames = queueNames;
+	this->sink = &sink;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(Vulkan.physicalDevice, &properties);
+	timestampPeriod = properties.limits.timestampPeriod;
+
+	uint32_t familyCount;
+	vkGetPhysicalDeviceQueueFamilyProperties(Vulkan.physicalDevice, &familyCount, nullptr);
+
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(Vulkan.physicalDevice, &familyCount, families.data());
+
+	timestampMasks.resize(queueFamilyIndices.size());
+	for (size_t i = 0; i < queueFamilyIndices.size(); i++)
+	{
+		uint32_t validBits = families[queueFamilyIndices[i]].timestampValidBits;
+		timestampMasks[i] = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+	}
+
+	VkQueryPoolCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	createInfo.queryCount = MaxScopesPerQueue * 2;
+	createInfo.pipelineStatistics = 0;
+
+	frames.resize(frameCount);
+	for (Frame &frame : frames)
+	{
+		frame.queues.resize(queueFamilyIndices.size());
+
+		for (size_t i = 0; i < queueFamilyIndices.size(); i++)
+		{
+			if (timestampMasks[i] == 0)
+				continue;
+
+			if (vkCreateQueryPool(Vulkan.device, &createInfo, nullptr, &frame.queues[i].pool) != VK_SUCCESS)
+				throw std::runtime_error("Failed to create timestamp query pool");
+		}
+	}
+}
+
+void QueueProfiler::Destroy()
+{
+	for (Frame &frame : frames)
+	{
+		for (QueueFrame &queue : frame.queues)
+		{
+			if (queue.pool != VK_NULL_HANDLE)
+				vkDestroyQueryPool(Vulkan.device, queue.pool, nullptr);
+		}
+	}
+
+	frames.clear();
+}
+
+void QueueProfiler::BeginFrame(uint32_t frameIndex)
+{
+	this->frameIndex = frameIndex;
+	Frame &frame = frames[frameIndex];
+
+	std::vector<std::vector<std::pair<double, double>>> intervals(frame.queues.size());
+	double frameStart = DBL_MAX;
+	double frameEnd = 0.0;
+
+	for (const Scope &scope : frame.scopes)
+	{
+		uint64_t timestamps[2];
+
+		// nothing to report for a frame that never reached the GPU
+		if (vkGetQueryPoolResults(Vulkan.device, frame.queues[scope.queue].pool, scope.query, 2, sizeof(timestamps), timestamps,
+			sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+			continue;
+
+		uint64_t mask = timestampMasks[scope.queue];
+		double start = (double)(timestamps[0] & mask) * timestampPeriod * 1e-9;
+		double end = (double)(timestamps[1] & mask) * timestampPeriod * 1e-9;
+
+		sink->Add((queueNames[scope.queue] + ": " + scope.name).c_str(), end - start);
+		intervals[scope.queue].emplace_back(start, end);
+
+		frameStart = std::min(frameStart, start);
+		frameEnd = std::max(frameEnd, end);
+	}
+
+	frameSeconds = frameEnd > frameStart ? frameEnd - frameStart : 0.0;
+
+	// timestamps of one device share a timebase, so the queues' busy spans can be compared
+	std::vector<std::vector<std::pair<double, double>>> busy(frame.queues.size());
+
+	for (size_t i = 0; i < intervals.size(); i++)
+	{
+		if (!intervals[i].empty())
+			sink->Add(queueNames[i].c_str(), MergedLength(intervals[i], busy[i]));
+	}
+
+	for (size_t i = 0; i < busy.size(); i++)
+	{
+		for (size_t j = i + 1; j < busy.size(); j++)
+		{
+			if (busy[i].empty() || busy[j].empty())
+				continue;
+
+			double overlap = 0.0;
+
+			for (const std::pair<double, double> &a : busy[i])
+			{
+				for (const std::pair<double, double> &b : busy[j])
+					overlap += std::max(0.0, std::min(a.second, b.second) - std::max(a.first, b.first));
+			}
+
+			sink->Add((queueNames[i] + " and " + queueNames[j] + " overlap").c_str(), overlap);
+		}
+	}
+
+	frame.scopes.clear();
+
+	for (QueueFrame &queue : frame.queues)
+		queue.queryCount = 0;
+}
+
+uint32_t QueueProfiler::Begin(VkCommandBuffer commandBuffer, uint32_t queue, const char* name)
+{
+	Frame &frame = frames[frameIndex];
+	QueueFrame &queueFrame = frame.queues[queue];
+
+	if (queueFrame.pool == VK_NULL_HANDLE || queueFrame.queryCount + 2 > MaxScopesPerQueue * 2)
+		return InvalidScope;
+
+	// each queue resets its own pool, so no other queue has to be ordered before it
+	if (queueFrame.queryCount == 0)
+		vkCmdResetQueryPool(commandBuffer, queueFrame.pool, 0, MaxScopesPerQueue * 2);
+
+	Scope scope;
+	scope.queue = queue;
+	scope.name = name;
+	scope.query = queueFrame.queryCount;
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queueFrame.pool, scope.query);
+
+	queueFrame.queryCount += 2;
+	frame.scopes.push_back(scope);
+
+	return (uint32_t)frame.scopes.size() - 1;
+}
+
+void QueueProfiler::End(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+	if (scope == InvalidScope)
+		return;
+
+	const Scope &entry = frames[frameIndex].scopes[scope];
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[frameIndex].queues[entry.queue].pool, entry.query + 1);
+}
\ No newline at end of file
@@ -0,0 +1,1496 @@
+#include "RenderGraph.h"
+
+#include <assert.h>
+#include <algorithm>
+
+#include "Hash.h"
+
+static const VkAccessFlags WriteAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+	| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+static const VkPipelineStageFlags GraphicsShaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+static const VkPipelineStageFlags DepthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+// images accept usages with a layout, buffers usages with buffer usage flags
+const RenderGraph::UsageInfo RenderGraph::UsageInfos[UsageCount] =
+{
+	// UsageNone
+	{ 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, false },
+	// UsageColorAttachment
+	{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0, true },
+	// UsageDepthAttachment
+	{ DepthStages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, true },
+	// UsageDepthRead
+	{ DepthStages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, false },
+	// UsageSampledGraphics
+	{ GraphicsShaderStages, VK_ACCESS_SHADER_READ_BIT,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT, false },
+	// UsageSampledCompute
+	{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT, false },
+	// UsageStorageReadGraphics
+	{ GraphicsShaderStages, VK_ACCESS_SHADER_READ_BIT,
+		VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false },
+	// UsageStorageReadCompute
+	{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+		VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false },
+	// UsageStorageWriteCompute
+	{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true },
+	// UsageUniformGraphics
+	{ GraphicsShaderStages, VK_ACCESS_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false },
+	// UsageUniformCompute
+	{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false },
+	// UsageVertexBuffer
+	{ VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, false },
+	// UsageIndexBuffer
+	{ VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false },
+	// UsageIndirectBuffer
+	{ VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false },
+	// UsageTransferSrc
+	{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false },
+	// UsageTransferDst
+	{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true },
+	// UsageHostRead, readback buffers are filled by transfers
+	{ VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_TRANSFER_DST_BIT, false },
+	// UsagePresent
+	{ VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 0, false },
+};
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t FindLazyMemoryType(uint32_t typeBits)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(Vulkan.physicalDevice, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+			return i;
+	}
+
+	return UINT32_MAX;
+}
+
+void RenderGraph::BarrierBatch::Record(VkCommandBuffer commandBuffer) const
+{
+	VkMemoryBarrier memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.pNext = nullptr;
+	memoryBarrier.srcAccessMask = srcAccess;
+	memoryBarrier.dstAccessMask = dstAccess;
+
+	// buffers and images staying in their layout share one global memory barrier
+	uint32_t memoryBarrierCount = (srcAccess != 0 || dstAccess != 0) ? 1 : 0;
+
+	vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, memoryBarrierCount, &memoryBarrier,
+		(uint32_t)bufferBarriers.size(), bufferBarriers.data(), (uint32_t)imageBarriers.size(), imageBarriers.data());
+}
+
+uint64_t RenderGraph::RenderPassKey::Hash() const
+{
+	uint64_t hash = HashValue(hasDepth, HashSeed);
+
+	for (const AttachmentKey &attachment : attachments)
+	{
+		hash = HashValue(attachment.format, hash);
+		hash = HashValue(attachment.samples, hash);
+		hash = HashValue(attachment.loadOp, hash);
+		hash = HashValue(attachment.storeOp, hash);
+		hash = HashValue(attachment.layout, hash);
+	}
+
+	return hash;
+}
+
+bool RenderGraph::RenderPassKey::operator ==(const RenderPassKey &rhs) const
+{
+	if (hasDepth != rhs.hasDepth || attachments.size() != rhs.attachments.size())
+		return false;
+
+	for (size_t i = 0; i < attachments.size(); i++)
+	{
+		const AttachmentKey &a = attachments[i];
+		const AttachmentKey &b = rhs.attachments[i];
+
+		if (a.format != b.format || a.samples != b.samples || a.loadOp != b.loadOp || a.storeOp != b.storeOp || a.layout != b.layout)
+			return false;
+	}
+
+	return true;
+}
+
+RenderGraph::RenderGraph()
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+	Destroy();
+}
+
+void RenderGraph::Create(uint32_t frameCount)
+{
+	assert(frameCount > 0);
+
+	frames.resize(frameCount);
+	frameIndex = 0;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(Vulkan.physicalDevice, &properties);
+	bufferImageGranularity = properties.limits.bufferImageGranularity;
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(Vulkan.physicalDevice, &memoryProperties);
+
+	hasLazyMemory = false;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+			hasLazyMemory = true;
+	}
+}
+
+void RenderGraph::Destroy()
+{
+	for (FrameResources &frame : frames)
+	{
+		for (CachedFramebuffer &framebuffer : frame.framebuffers)
+			vkDestroyFramebuffer(Vulkan.device, framebuffer.framebuffer, nullptr);
+
+		DestroyTransients(frame);
+
+		for (VkSemaphore semaphore : frame.semaphores)
+			vkDestroySemaphore(Vulkan.device, semaphore, nullptr);
+	}
+
+	for (auto &bucket : renderPasses)
+	{
+		for (CachedRenderPass &entry : bucket.second)
+			vkDestroyRenderPass(Vulkan.device, entry.renderPass, nullptr);
+	}
+
+	frames.clear();
+	renderPasses.clear();
+	Reset();
+}
+
+void RenderGraph::Reset()
+{
+	resources.clear();
+	passes.clear();
+	segments.clear();
+	finalBarriers = BarrierBatch();
+}
+
+RenderGraph::Resource RenderGraph::CreateImage(const char* name, const ImageDesc &desc)
+{
+	ResourceEntry entry = {};
+	entry.name = name;
+	entry.isImage = true;
+	entry.imageDesc = desc;
+	entry.initialUsage = UsageNone;
+	entry.finalUsage = UsageNone;
+
+	resources.push_back(entry);
+	return (Resource)resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::CreateBuffer(const char* name, VkDeviceSize size)
+{
+	ResourceEntry entry = {};
+	entry.name = name;
+	entry.isImage = false;
+	entry.bufferSize = size;
+	entry.initialUsage = UsageNone;
+	entry.finalUsage = UsageNone;
+
+	resources.push_back(entry);
+	return (Resource)resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::ImportImage(const char* name, VkImage image, VkImageView view, const ImageDesc &desc, Usage initialUsage, Usage finalUsage)
+{
+	ResourceEntry entry = {};
+	entry.name = name;
+	entry.isImage = true;
+	entry.imported = true;
+	entry.imageDesc = desc;
+	entry.initialUsage = initialUsage;
+	entry.finalUsage = finalUsage;
+	entry.image = image;
+	entry.view = view;
+
+	resources.push_back(entry);
+	return (Resource)resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::ImportBuffer(const char* name, VkBuffer buffer, VkDeviceSize size, Usage initialUsage, Usage finalUsage)
+{
+	ResourceEntry entry = {};
+	entry.name = name;
+	entry.isImage = false;
+	entry.imported = true;
+	entry.bufferSize = size;
+	entry.initialUsage = initialUsage;
+	entry.finalUsage = finalUsage;
+	entry.buffer = buffer;
+
+	resources.push_back(entry);
+	return (Resource)resources.size() - 1;
+}
+
+void RenderGraph::MarkOutput(Resource resource)
+{
+	resources[resource].output = true;
+}
+
+RenderGraph::Pass RenderGraph::AddPass(const char* name, RecordFunc record, QueueType queue)
+{
+	PassEntry entry = {};
+	entry.name = name;
+	entry.record = std::move(record);
+	entry.queue = queue;
+
+	passes.push_back(std::move(entry));
+	return (Pass)passes.size() - 1;
+}
+
+void RenderGraph::Use(Pass pass, Resource resource, Usage usage)
+{
+	assert(pass < passes.size() && resource < resources.size() && usage < UsageCount);
+
+	const ResourceEntry &entry = resources[resource];
+	const UsageInfo &info = UsageInfos[usage];
+
+	bool valid = entry.isImage ? info.layout != VK_IMAGE_LAYOUT_UNDEFINED : info.bufferUsage != 0;
+
+	if (passes[pass].queue == QueueCompute)
+		valid = valid && (info.stages & ~(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT)) == 0;
+
+	if (usage == UsagePresent || !valid)
+		throw std::runtime_error("Invalid usage of render graph resource " + entry.name + " in " + passes[pass].name);
+
+	PassUse use = {};
+	use.resource = resource;
+	use.stages = info.stages;
+	use.access = info.access;
+	use.layout = info.layout;
+	use.write = info.write;
+	use.colorAttachment = usage == UsageColorAttachment;
+	use.depthAttachment = usage == UsageDepthAttachment || usage == UsageDepthRead;
+
+	for (PassUse &existing : passes[pass].uses)
+	{
+		if (existing.resource != resource)
+			continue;
+
+		// one image can only be in one layout during a pass
+		if (entry.isImage && existing.layout != use.layout)
+			throw std::runtime_error("Conflicting layouts for " + entry.name + " in " + passes[pass].name);
+
+		existing.stages |= use.stages;
+		existing.access |= use.access;
+		existing.write = existing.write || use.write;
+		existing.colorAttachment = existing.colorAttachment || use.colorAttachment;
+		existing.depthAttachment = existing.depthAttachment || use.depthAttachment;
+		return;
+	}
+
+	passes[pass].uses.push_back(use);
+}
+
+void RenderGraph::SetClear(Pass pass, Resource resource, const VkClearValue &value)
+{
+	passes[pass].clears.emplace_back(resource, value);
+
+	for (PassUse &use : passes[pass].uses)
+	{
+		if (use.resource == resource)
+			use.cleared = true;
+	}
+}
+
+void RenderGraph::SetSideEffects(Pass pass)
+{
+	passes[pass].sideEffects = true;
+}
+
+void RenderGraph::SetSecondaryCommandBuffers(Pass pass)
+{
+	passes[pass].secondaryCommandBuffers = true;
+}
+
+void RenderGraph::Compile(uint32_t frameIndex)
+{
+	assert(frameIndex < frames.size());
+
+	this->frameIndex = frameIndex;
+	stats = Stats();
+	stats.passes = (uint32_t)passes.size();
+
+	// clears may have been set before the use they apply to
+	for (PassEntry &pass : passes)
+	{
+		if (!HasAsyncCompute())
+			pass.queue = QueueGraphics;
+
+		for (PassUse &use : pass.uses)
+		{
+			for (const std::pair<Resource, VkClearValue> &clear : pass.clears)
+				use.cleared = use.cleared || clear.first == use.resource;
+		}
+	}
+
+	FrameResources &frame = frames[frameIndex];
+
+	for (CachedFramebuffer &framebuffer : frame.framebuffers)
+		framebuffer.used = false;
+
+	CullPasses();
+	AllocateTransients();
+	PlaceBarriers();
+	CreateRenderPasses();
+
+	// the frame's previous submission is done, framebuffers this one does not use can go
+
+	for (size_t i = 0; i < frame.framebuffers.size();)
+	{
+		if (!frame.framebuffers[i].used)
+		{
+			vkDestroyFramebuffer(Vulkan.device, frame.framebuffers[i].framebuffer, nullptr);
+			frame.framebuffers[i] = frame.framebuffers.back();
+			frame.framebuffers.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+void RenderGraph::Submit(const BeginFunc &begin, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage,
+	VkSemaphore signalSemaphore, VkFence fence, QueueProfiler* profiler)
+{
+	FrameResources &frame = frames[frameIndex];
+
+	// one semaphore per wait, signalled by the segment waited on
+	std::vector<std::vector<VkSemaphore>> signals(segments.size());
+	std::vector<std::vector<VkSemaphore>> waits(segments.size());
+	std::vector<std::vector<VkPipelineStageFlags>> waitStages(segments.size());
+	uint32_t semaphoreCount = 0;
+
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		for (const SegmentWait &wait : segments[i].waits)
+		{
+			if (semaphoreCount == frame.semaphores.size())
+			{
+				VkSemaphoreCreateInfo createInfo = {};
+				createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+				createInfo.pNext = nullptr;
+				createInfo.flags = 0;
+
+				VkSemaphore semaphore;
+				if (vkCreateSemaphore(Vulkan.device, &createInfo, nullptr, &semaphore) != VK_SUCCESS)
+					throw std::runtime_error("Failed to create render graph semaphore");
+
+				frame.semaphores.push_back(semaphore);
+			}
+
+			VkSemaphore semaphore = frame.semaphores[semaphoreCount++];
+			signals[wait.segment].push_back(semaphore);
+			waits[i].push_back(semaphore);
+			waitStages[i].push_back(wait.stages);
+		}
+	}
+
+	stats.semaphores = semaphoreCount;
+
+	bool externalWaitAdded = false;
+
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		const Segment &segment = segments[i];
+		bool last = i + 1 == segments.size();
+
+		// the leading graphics segment is often left with nothing to do
+		if (segment.passes.empty() && segment.release.IsEmpty() && signals[i].empty() && waits[i].empty() && !last)
+			continue;
+
+		VkCommandBuffer commandBuffer = begin(segment.queue);
+
+		for (Pass pass : segment.passes)
+		{
+			uint32_t scope = profiler ? profiler->Begin(commandBuffer, segment.queue, passes[pass].name.c_str()) : QueueProfiler::InvalidScope;
+
+			RecordPass(commandBuffer, passes[pass]);
+
+			if (profiler)
+				profiler->End(commandBuffer, scope);
+		}
+
+		if (!segment.release.IsEmpty())
+			segment.release.Record(commandBuffer);
+
+		if (last && !finalBarriers.IsEmpty())
+			finalBarriers.Record(commandBuffer);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to end render graph command buffer");
+
+		if (segment.queue == QueueGraphics && !externalWaitAdded && waitSemaphore != VK_NULL_HANDLE)
+		{
+			waits[i].push_back(waitSemaphore);
+			waitStages[i].push_back(waitStage);
+			externalWaitAdded = true;
+		}
+
+		if (last && signalSemaphore != VK_NULL_HANDLE)
+			signals[i].push_back(signalSemaphore);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = (uint32_t)waits[i].size();
+		submitInfo.pWaitSemaphores = waits[i].data();
+		submitInfo.pWaitDstStageMask = waitStages[i].data();
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = (uint32_t)signals[i].size();
+		submitInfo.pSignalSemaphores = signals[i].data();
+
+		VkQueue queue = segment.queue == QueueCompute ? Vulkan.computeQueue : Vulkan.graphicsQueue;
+
+		if (vkQueueSubmit(queue, 1, &submitInfo, last ? fence : VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("Failed to submit render graph segment");
+	}
+}
+
+void RenderGraph::RecordPass(VkCommandBuffer commandBuffer, const PassEntry &pass)
+{
+	if (!pass.barriers.IsEmpty())
+		pass.barriers.Record(commandBuffer);
+
+	if (pass.renderPass != VK_NULL_HANDLE)
+	{
+		VkRenderPassBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.renderPass = pass.renderPass;
+		beginInfo.framebuffer = pass.framebuffer;
+		beginInfo.renderArea.offset = { 0, 0 };
+		beginInfo.renderArea.extent = pass.extent;
+		beginInfo.clearValueCount = (uint32_t)pass.clearValues.size();
+		beginInfo.pClearValues = pass.clearValues.data();
+
+		if (pass.secondaryCommandBuffers)
+		{
+			vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		}
+		else
+		{
+			vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+			// pipelines always take viewport and scissor as dynamic state
+			VkViewport viewport = { 0.0f, 0.0f, (float)pass.extent.width, (float)pass.extent.height, 0.0f, 1.0f };
+			VkRect2D scissor = { { 0, 0 }, pass.extent };
+
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		}
+	}
+
+	if (pass.record)
+		pass.record(commandBuffer);
+
+	if (pass.renderPass != VK_NULL_HANDLE)
+		vkCmdEndRenderPass(commandBuffer);
+}
+
+VkImage RenderGraph::GetImage(Resource resource) const
+{
+	return resources[resource].image;
+}
+
+VkImageView RenderGraph::GetImageView(Resource resource) const
+{
+	return resources[resource].view;
+}
+
+VkBuffer RenderGraph::GetBuffer(Resource resource) const
+{
+	return resources[resource].buffer;
+}
+
+void RenderGraph::PrintStats(std::ostream &stream) const
+{
+	stream << "render graph: " << stats.passes << " passes, " << stats.culledPasses << " culled"
+		<< ", segments " << stats.segments
+		<< ", semaphores " << stats.semaphores
+		<< ", queue transfers " << stats.queueTransfers
+		<< ", barrier batches " << stats.barrierBatches
+		<< ", image barriers " << stats.imageBarriers
+		<< ", render passes " << stats.renderPasses
+		<< ", transient images " << stats.transientImages
+		<< ", buffers " << stats.transientBuffers
+		<< ", memory " << (stats.unaliasedMemory >> 10) << " KB unaliased"
+		<< ", " << (stats.transientMemory >> 10) << " KB aliased"
+		<< ", " << (stats.lazyMemory >> 10) << " KB lazily allocated" << std::endl;
+}
+
+void RenderGraph::CullPasses()
+{
+	// walking backwards, a pass survives when it writes something a surviving pass or the
+	// outside world reads. A write that does not read stops the search for earlier writers
+	std::vector<bool> needed(resources.size());
+
+	for (size_t i = 0; i < resources.size(); i++)
+		needed[i] = resources[i].imported || resources[i].output;
+
+	for (size_t i = passes.size(); i-- > 0;)
+	{
+		PassEntry &pass = passes[i];
+
+		pass.live = pass.sideEffects;
+
+		for (const PassUse &use : pass.uses)
+			pass.live = pass.live || (use.write && needed[use.resource]);
+
+		if (!pass.live)
+		{
+			stats.culledPasses++;
+			continue;
+		}
+
+		for (const PassUse &use : pass.uses)
+		{
+			bool reads = !use.cleared && (!use.write || (use.access & ~WriteAccessMask) != 0);
+
+			if (reads)
+				needed[use.resource] = true;
+			else if (use.write)
+				needed[use.resource] = false;
+		}
+	}
+}
+
+void RenderGraph::AllocateTransients()
+{
+	for (ResourceEntry &entry : resources)
+	{
+		entry.imageUsage = 0;
+		entry.bufferUsage = 0;
+		entry.aliases.clear();
+	}
+
+	std::vector<uint32_t> firstPass(resources.size(), UINT32_MAX);
+	std::vector<uint32_t> lastPass(resources.size(), 0);
+
+	for (uint32_t i = 0; i < passes.size(); i++)
+	{
+		const PassEntry &pass = passes[i];
+
+		if (!pass.live)
+			continue;
+
+		for (const PassUse &use : pass.uses)
+		{
+			ResourceEntry &entry = resources[use.resource];
+
+			if (firstPass[use.resource] == UINT32_MAX)
+				firstPass[use.resource] = i;
+
+			lastPass[use.resource] = i;
+
+			// the usage table is indexed by usage, find every one this use combines
+			for (uint32_t usage = UsageNone + 1; usage < UsageCount; usage++)
+			{
+				const UsageInfo &info = UsageInfos[usage];
+
+				if ((info.stages & use.stages) == info.stages && (info.access & use.access) == info.access
+					&& (!entry.isImage || info.layout == use.layout))
+				{
+					entry.imageUsage |= info.imageUsage;
+					entry.bufferUsage |= info.bufferUsage;
+				}
+			}
+		}
+	}
+
+	// the layout depends on what the transients are and when they live, nothing else
+	std::vector<Resource> transientResources;
+	uint64_t layoutHash = HashSeed;
+
+	for (Resource i = 0; i < resources.size(); i++)
+	{
+		ResourceEntry &entry = resources[i];
+
+		if (entry.imported || firstPass[i] == UINT32_MAX)
+			continue;
+
+		// outputs are read after the frame and live to its end
+		if (entry.output)
+			lastPass[i] = (uint32_t)passes.size();
+
+		transientResources.push_back(i);
+
+		layoutHash = HashValue(entry.isImage, layoutHash);
+		layoutHash = HashValue(firstPass[i], layoutHash);
+		layoutHash = HashValue(lastPass[i], layoutHash);
+
+		if (entry.isImage)
+		{
+			layoutHash = HashValue(entry.imageUsage, layoutHash);
+			layoutHash = HashValue(entry.imageDesc.format, layoutHash);
+			layoutHash = HashValue(entry.imageDesc.width, layoutHash);
+			layoutHash = HashValue(entry.imageDesc.height, layoutHash);
+			layoutHash = HashValue(entry.imageDesc.mipLevels, layoutHash);
+			layoutHash = HashValue(entry.imageDesc.arrayLayers, layoutHash);
+			layoutHash = HashValue(entry.imageDesc.samples, layoutHash);
+		}
+		else
+		{
+			layoutHash = HashValue(entry.bufferUsage, layoutHash);
+			layoutHash = HashValue(entry.bufferSize, layoutHash);
+		}
+	}
+
+	FrameResources &frame = frames[frameIndex];
+
+	if (frame.layoutHash != layoutHash || frame.transients.size() != transientResources.size())
+	{
+		// the frame's previous submission is done, nothing of its layout is in use
+		for (CachedFramebuffer &framebuffer : frame.framebuffers)
+			vkDestroyFramebuffer(Vulkan.device, framebuffer.framebuffer, nullptr);
+
+		frame.framebuffers.clear();
+		DestroyTransients(frame);
+
+		for (Resource i : transientResources)
+		{
+			Transient transient = {};
+			transient.isImage = resources[i].isImage;
+			transient.firstPass = firstPass[i];
+			transient.lastPass = lastPass[i];
+			frame.transients.push_back(transient);
+		}
+
+		CreateTransients(frame, transientResources);
+		frame.layoutHash = layoutHash;
+	}
+
+	for (size_t i = 0; i < transientResources.size(); i++)
+	{
+		const Transient &transient = frame.transients[i];
+		ResourceEntry &entry = resources[transientResources[i]];
+
+		entry.image = transient.image;
+		entry.view = transient.view;
+		entry.buffer = transient.buffer;
+
+		for (uint32_t alias : transient.aliases)
+			entry.aliases.push_back(transientResources[alias]);
+
+		if (transient.isImage)
+			stats.transientImages++;
+		else
+			stats.transientBuffers++;
+
+		stats.unaliasedMemory += transient.requirements.size;
+
+		if (transient.lazy)
+			stats.lazyMemory += transient.requirements.size;
+	}
+
+	for (const TransientHeap &heap : frame.heaps)
+		stats.transientMemory += heap.size;
+}
+
+void RenderGraph::CreateTransients(FrameResources &frame, const std::vector<Resource> &transientResources)
+{
+	const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+	for (size_t i = 0; i < transientResources.size(); i++)
+	{
+		const ResourceEntry &entry = resources[transientResources[i]];
+		Transient &transient = frame.transients[i];
+
+		if (entry.isImage)
+		{
+			// an attachment living in one pass is cleared or undefined on load and never stored
+			VkImageUsageFlags usage = entry.imageUsage;
+			bool lazyCandidate = hasLazyMemory && transient.firstPass == transient.lastPass && (usage & ~attachmentUsage) == 0;
+
+			if (lazyCandidate)
+				usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+			VkImageCreateInfo imageInfo = {};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.pNext = nullptr;
+			imageInfo.flags = 0;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = entry.imageDesc.format;
+			imageInfo.extent = { entry.imageDesc.width, entry.imageDesc.height, 1 };
+			imageInfo.mipLevels = entry.imageDesc.mipLevels;
+			imageInfo.arrayLayers = entry.imageDesc.arrayLayers;
+			imageInfo.samples = entry.imageDesc.samples;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = usage;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.queueFamilyIndexCount = 0;
+			imageInfo.pQueueFamilyIndices = nullptr;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			if (vkCreateImage(Vulkan.device, &imageInfo, nullptr, &transient.image) != VK_SUCCESS)
+				throw std::runtime_error("Failed to create render graph image " + entry.name);
+
+			vkGetImageMemoryRequirements(Vulkan.device, transient.image, &transient.requirements);
+
+			if (lazyCandidate)
+			{
+				transient.memoryType = FindLazyMemoryType(transient.requirements.memoryTypeBits);
+				transient.lazy = transient.memoryType != UINT32_MAX;
+			}
+		}
+		else
+		{
+			VkBufferCreateInfo bufferInfo = {};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.pNext = nullptr;
+			bufferInfo.flags = 0;
+			bufferInfo.size = entry.bufferSize;
+			bufferInfo.usage = entry.bufferUsage;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			bufferInfo.queueFamilyIndexCount = 0;
+			bufferInfo.pQueueFamilyIndices = nullptr;
+
+			if (vkCreateBuffer(Vulkan.device, &bufferInfo, nullptr, &transient.buffer) != VK_SUCCESS)
+				throw std::runtime_error("Failed to create render graph buffer " + entry.name);
+
+			vkGetBufferMemoryRequirements(Vulkan.device, transient.buffer, &transient.requirements);
+		}
+
+		if (!transient.lazy)
+			transient.memoryType = vkfwFindMemoryType(transient.requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+
+	// largest first, each goes to the lowest offset free of everything alive at the same time
+	std::vector<uint32_t> order;
+	for (uint32_t i = 0; i < frame.transients.size(); i++)
+	{
+		if (!frame.transients[i].lazy)
+			order.push_back(i);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&frame](uint32_t a, uint32_t b)
+	{
+		return frame.transients[a].requirements.size > frame.transients[b].requirements.size;
+	});
+
+	std::vector<uint32_t> placed;
+
+	for (uint32_t index : order)
+	{
+		Transient &transient = frame.transients[index];
+		VkDeviceSize alignment = std::max(transient.requirements.alignment, bufferImageGranularity);
+
+		std::vector<uint32_t> overlapping;
+		for (uint32_t other : placed)
+		{
+			const Transient &placedTransient = frame.transients[other];
+
+			if (placedTransient.memoryType == transient.memoryType
+				&& placedTransient.firstPass <= transient.lastPass && transient.firstPass <= placedTransient.lastPass)
+				overlapping.push_back(other);
+		}
+
+		std::sort(overlapping.begin(), overlapping.end(), [&frame](uint32_t a, uint32_t b)
+		{
+			return frame.transients[a].offset < frame.transients[b].offset;
+		});
+
+		VkDeviceSize offset = 0;
+		for (uint32_t other : overlapping)
+		{
+			const Transient &placedTransient = frame.transients[other];
+
+			if (offset + transient.requirements.size <= placedTransient.offset)
+				break;
+
+			offset = std::max(offset, AlignUp(placedTransient.offset + placedTransient.requirements.size, alignment));
+		}
+
+		transient.offset = offset;
+		placed.push_back(index);
+
+		TransientHeap* heap = nullptr;
+		for (TransientHeap &candidate : frame.heaps)
+		{
+			if (candidate.memoryType == transient.memoryType)
+				heap = &candidate;
+		}
+
+		if (!heap)
+		{
+			frame.heaps.push_back({ transient.memoryType, 0, VK_NULL_HANDLE });
+			heap = &frame.heaps.back();
+		}
+
+		heap->size = std::max(heap->size, offset + transient.requirements.size);
+	}
+
+	// transients whose memory is taken over from one that lived earlier
+	for (uint32_t i = 0; i < frame.transients.size(); i++)
+	{
+		Transient &transient = frame.transients[i];
+
+		for (uint32_t j = 0; j < frame.transients.size() && !transient.lazy; j++)
+		{
+			const Transient &other = frame.transients[j];
+
+			if (!other.lazy && other.memoryType == transient.memoryType && other.lastPass < transient.firstPass
+				&& other.offset < transient.offset + transient.requirements.size && transient.offset < other.offset + other.requirements.size)
+				transient.aliases.push_back(j);
+		}
+	}
+
+	for (TransientHeap &heap : frame.heaps)
+	{
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.pNext = nullptr;
+		allocInfo.allocationSize = heap.size;
+		allocInfo.memoryTypeIndex = heap.memoryType;
+
+		if (vkAllocateMemory(Vulkan.device, &allocInfo, nullptr, &heap.memory) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate render graph memory");
+	}
+
+	for (size_t i = 0; i < frame.transients.size(); i++)
+	{
+		const ResourceEntry &entry = resources[transientResources[i]];
+		Transient &transient = frame.transients[i];
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = transient.offset;
+
+		if (transient.lazy)
+		{
+			VkMemoryAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.pNext = nullptr;
+			allocInfo.allocationSize = transient.requirements.size;
+			allocInfo.memoryTypeIndex = transient.memoryType;
+
+			if (vkAllocateMemory(Vulkan.device, &allocInfo, nullptr, &transient.memory) != VK_SUCCESS)
+				throw std::runtime_error("Failed to allocate lazily allocated render graph memory");
+
+			memory = transient.memory;
+			offset = 0;
+		}
+		else
+		{
+			for (const TransientHeap &heap : frame.heaps)
+			{
+				if (heap.memoryType == transient.memoryType)
+					memory = heap.memory;
+			}
+		}
+
+		if (!transient.isImage)
+		{
+			if (vkBindBufferMemory(Vulkan.device, transient.buffer, memory, offset) != VK_SUCCESS)
+				throw std::runtime_error("Failed to bind render graph buffer memory");
+
+			continue;
+		}
+
+		if (vkBindImageMemory(Vulkan.device, transient.image, memory, offset) != VK_SUCCESS)
+			throw std::runtime_error("Failed to bind render graph image memory");
+
+		// combined depth stencil views cover both aspects, as attachments need
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.pNext = nullptr;
+		viewInfo.flags = 0;
+		viewInfo.image = transient.image;
+		viewInfo.viewType = entry.imageDesc.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = entry.imageDesc.format;
+		viewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+		viewInfo.subresourceRange = { GetAspectMask(entry.imageDesc.format), 0, entry.imageDesc.mipLevels, 0, entry.imageDesc.arrayLayers };
+
+		if (vkCreateImageView(Vulkan.device, &viewInfo, nullptr, &transient.view) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create render graph image view");
+	}
+}
+
+void RenderGraph::DestroyTransients(FrameResources &frame)
+{
+	for (Transient &transient : frame.transients)
+	{
+		if (transient.view != VK_NULL_HANDLE)
+			vkDestroyImageView(Vulkan.device, transient.view, nullptr);
+
+		if (transient.image != VK_NULL_HANDLE)
+			vkDestroyImage(Vulkan.device, transient.image, nullptr);
+
+		if (transient.buffer != VK_NULL_HANDLE)
+			vkDestroyBuffer(Vulkan.device, transient.buffer, nullptr);
+
+		if (transient.memory != VK_NULL_HANDLE)
+			vkFreeMemory(Vulkan.device, transient.memory, nullptr);
+	}
+
+	for (TransientHeap &heap : frame.heaps)
+	{
+		if (heap.memory != VK_NULL_HANDLE)
+			vkFreeMemory(Vulkan.device, heap.memory, nullptr);
+	}
+
+	frame.transients.clear();
+	frame.heaps.clear();
+	frame.layoutHash = 0;
+}
+
+void RenderGraph::BuildSegments()
+{
+	segments.clear();
+
+	// the frame starts and ends on the graphics queue, the first segment releases imported
+	// resources to compute and the last joins the compute work and leaves them as asked
+	Segment first = {};
+	first.queue = QueueGraphics;
+	segments.push_back(first);
+
+	for (uint32_t i = 0; i < passes.size(); i++)
+	{
+		PassEntry &pass = passes[i];
+
+		if (!pass.live)
+			continue;
+
+		if (segments.back().queue != pass.queue)
+		{
+			Segment segment = {};
+			segment.queue = pass.queue;
+			segments.push_back(segment);
+		}
+
+		segments.back().passes.push_back(i);
+		pass.segment = (uint32_t)segments.size() - 1;
+	}
+
+	if (segments.back().queue != QueueGraphics)
+	{
+		Segment last = {};
+		last.queue = QueueGraphics;
+		segments.push_back(last);
+	}
+
+	stats.segments = (uint32_t)segments.size();
+}
+
+void RenderGraph::PlaceBarriers()
+{
+	BuildSegments();
+
+	std::vector<ResourceState> states(resources.size());
+	std::vector<size_t> lastUse(resources.size(), 0);
+
+	for (size_t i = 0; i < resources.size(); i++)
+	{
+		const ResourceEntry &entry = resources[i];
+		const UsageInfo &initial = UsageInfos[entry.initialUsage];
+
+		if (!entry.imported || entry.initialUsage == UsageNone)
+			continue;
+
+		// whatever touched an imported resource before the frame is treated as one more pass
+		ResourceState &state = states[i];
+		state.layout = initial.layout;
+		state.hasContents = true;
+
+		if (initial.write)
+		{
+			state.writeStages = initial.stages;
+			state.writeAccess = initial.access & WriteAccessMask;
+		}
+		else
+		{
+			state.readStages = initial.stages;
+		}
+	}
+
+	std::vector<bool> started(resources.size());
+
+	for (size_t i = 0; i < passes.size(); i++)
+	{
+		if (!passes[i].live)
+			continue;
+
+		for (const PassUse &use : passes[i].uses)
+			lastUse[use.resource] = i;
+	}
+
+	for (size_t i = 0; i < passes.size(); i++)
+	{
+		PassEntry &pass = passes[i];
+
+		if (!pass.live)
+			continue;
+
+		for (PassUse &use : pass.uses)
+		{
+			const ResourceEntry &entry = resources[use.resource];
+
+			// a transient belongs to the queue using it first, and memory taken over from
+			// earlier transients is only reused once they are done with it
+			if (!started[use.resource] && !entry.imported)
+			{
+				ResourceState &state = states[use.resource];
+				state.queue = pass.queue;
+
+				for (Resource alias : entry.aliases)
+				{
+					const ResourceState &aliasState = states[alias];
+
+					if (aliasState.queue == pass.queue)
+					{
+						state.readStages |= aliasState.writeStages | aliasState.readStages;
+						state.writeAccess |= aliasState.writeAccess;
+					}
+					else if (aliasState.lastSegment >= 0)
+					{
+						AddWait(pass.segment, aliasState.lastSegment, use.stages);
+					}
+				}
+			}
+
+			started[use.resource] = true;
+
+			use.hadContents = states[use.resource].hasContents;
+			use.usedLater = entry.imported || entry.output || lastUse[use.resource] > i;
+
+			AddBarrier(pass.barriers, use.resource, states[use.resource], use, pass.segment);
+		}
+
+		if (!pass.barriers.IsEmpty())
+			stats.barrierBatches++;
+	}
+
+	uint32_t lastSegment = (uint32_t)segments.size() - 1;
+
+	// leave imported resources the way their owner expects them, owned by graphics again
+	for (size_t i = 0; i < resources.size(); i++)
+	{
+		const ResourceEntry &entry = resources[i];
+		ResourceState &state = states[i];
+
+		if (!entry.imported || (entry.finalUsage == UsageNone && state.queue == QueueGraphics))
+			continue;
+
+		PassUse use = {};
+		use.resource = (Resource)i;
+
+		if (entry.finalUsage != UsageNone)
+		{
+			const UsageInfo &info = UsageInfos[entry.finalUsage];
+
+			use.stages = info.stages;
+			use.access = info.access;
+			use.layout = info.layout;
+			use.write = info.write;
+		}
+		else
+		{
+			use.stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			use.access = 0;
+			use.layout = state.layout;
+			use.write = false;
+		}
+
+		AddBarrier(finalBarriers, (Resource)i, state, use, lastSegment);
+	}
+
+	if (!finalBarriers.IsEmpty())
+		stats.barrierBatches++;
+
+	// the fence goes with the last graphics submission, which has to come after all compute work
+	for (uint32_t i = lastSegment; i-- > 0;)
+	{
+		if (segments[i].queue != QueueCompute)
+			continue;
+
+		bool joined = false;
+		for (const Segment &segment : segments)
+		{
+			for (const SegmentWait &wait : segment.waits)
+				joined = joined || wait.segment == i;
+		}
+
+		if (!joined)
+			AddWait(lastSegment, i, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		break;
+	}
+}
+
+void RenderGraph::AddBarrier(BarrierBatch &batch, Resource resource, ResourceState &state, const PassUse &use, uint32_t segment)
+{
+	const ResourceEntry &entry = resources[resource];
+	QueueType queue = segments[segment].queue;
+
+	VkPipelineStageFlags priorStages = state.writeStages | state.readStages;
+	VkImageLayout oldLayout = state.hasContents ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+	auto addResourceBarrier = [&](BarrierBatch &target, VkAccessFlags srcAccess, VkAccessFlags dstAccess, uint32_t srcFamily, uint32_t dstFamily)
+	{
+		if (entry.isImage)
+		{
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.pNext = nullptr;
+			barrier.srcAccessMask = srcAccess;
+			barrier.dstAccessMask = dstAccess;
+			barrier.oldLayout = oldLayout;
+			barrier.newLayout = use.layout;
+			barrier.srcQueueFamilyIndex = srcFamily;
+			barrier.dstQueueFamilyIndex = dstFamily;
+			barrier.image = entry.image;
+			barrier.subresourceRange = { GetAspectMask(entry.imageDesc.format), 0, entry.imageDesc.mipLevels, 0, entry.imageDesc.arrayLayers };
+
+			target.imageBarriers.push_back(barrier);
+			stats.imageBarriers++;
+		}
+		else
+		{
+			VkBufferMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.pNext = nullptr;
+			barrier.srcAccessMask = srcAccess;
+			barrier.dstAccessMask = dstAccess;
+			barrier.srcQueueFamilyIndex = srcFamily;
+			barrier.dstQueueFamilyIndex = dstFamily;
+			barrier.buffer = entry.buffer;
+			barrier.offset = 0;
+			barrier.size = VK_WHOLE_SIZE;
+
+			target.bufferBarriers.push_back(barrier);
+		}
+	};
+
+	if (state.queue != queue)
+	{
+		// resources owned by graphics from before the frame are released by the first segment
+		uint32_t ownerSegment = state.lastSegment >= 0 ? (uint32_t)state.lastSegment : 0;
+
+		if (state.lastSegment >= 0 || state.hasContents)
+			AddWait(segment, ownerSegment, use.stages);
+
+		if (state.hasContents)
+		{
+			// contents change queue family with a release on the owning queue and a matching
+			// acquire here, the semaphore in between carries the memory dependency
+			uint32_t srcFamily = state.queue == QueueCompute ? Vulkan.computeQueueFamilyIndex : Vulkan.graphicsQueueFamilyIndex;
+			uint32_t dstFamily = queue == QueueCompute ? Vulkan.computeQueueFamilyIndex : Vulkan.graphicsQueueFamilyIndex;
+
+			BarrierBatch &release = segments[ownerSegment].release;
+			release.srcStages |= priorStages != 0 ? priorStages : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			release.dstStages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			addResourceBarrier(release, state.writeAccess, 0, srcFamily, dstFamily);
+
+			batch.srcStages |= use.stages;
+			batch.dstStages |= use.stages;
+			addResourceBarrier(batch, 0, use.access, srcFamily, dstFamily);
+
+			stats.queueTransfers++;
+		}
+		else if (entry.isImage && oldLayout != use.layout)
+		{
+			batch.srcStages |= use.stages;
+			batch.dstStages |= use.stages;
+			addResourceBarrier(batch, 0, use.access, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+		}
+
+		state.queue = queue;
+	}
+	else if (entry.isImage && state.layout != use.layout)
+	{
+		// with nothing before it the transition waits on the stages using the image, which
+		// chains it after a semaphore wait at those stages, e.g. on an acquired swapchain image
+		batch.srcStages |= priorStages != 0 ? priorStages : use.stages;
+		batch.dstStages |= use.stages;
+		addResourceBarrier(batch, state.writeAccess, use.access, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+	}
+	else if (use.write)
+	{
+		// write after write and write after read, reads need no memory dependency
+		if (priorStages != 0)
+		{
+			batch.srcStages |= priorStages;
+			batch.dstStages |= use.stages;
+			batch.srcAccess |= state.writeAccess;
+			batch.dstAccess |= use.access;
+		}
+
+		state.lastSegment = (int32_t)segment;
+		state.writeStages = use.stages;
+		state.writeAccess = use.access & WriteAccessMask;
+		state.readStages = 0;
+		state.visibleStages = 0;
+		state.visibleAccess = 0;
+		state.hasContents = true;
+		return;
+	}
+	else
+	{
+		// read after write, skipped when an earlier barrier already covered these stages
+		if (state.writeStages != 0 && ((use.stages & ~state.visibleStages) != 0 || (use.access & ~state.visibleAccess) != 0))
+		{
+			batch.srcStages |= state.writeStages;
+			batch.dstStages |= use.stages;
+			batch.srcAccess |= state.writeAccess;
+			batch.dstAccess |= use.access;
+		}
+
+		state.lastSegment = (int32_t)segment;
+		state.readStages |= use.stages;
+		state.visibleStages |= use.stages;
+		state.visibleAccess |= use.access;
+		return;
+	}
+
+	// a transition or a queue change counts as a write the next differing access has to wait for
+	state.lastSegment = (int32_t)segment;
+	state.layout = use.layout;
+	state.writeStages = use.stages;
+	state.writeAccess = use.write ? use.access & WriteAccessMask : 0;
+	state.readStages = use.write ? 0 : use.stages;
+	state.visibleStages = use.write ? 0 : use.stages;
+	state.visibleAccess = use.write ? 0 : use.access;
+	state.hasContents = state.hasContents || use.write;
+}
+
+void RenderGraph::AddWait(uint32_t segment, uint32_t waitSegment, VkPipelineStageFlags stages)
+{
+	// a queue is ordered with itself by barriers
+	if (segments[segment].queue == segments[waitSegment].queue)
+		return;
+
+	for (SegmentWait &wait : segments[segment].waits)
+	{
+		if (wait.segment == waitSegment)
+		{
+			wait.stages |= stages;
+			return;
+		}
+	}
+
+	segments[segment].waits.push_back({ waitSegment, stages });
+}
+
+void RenderGraph::CreateRenderPasses()
+{
+	for (PassEntry &pass : passes)
+	{
+		pass.renderPass = VK_NULL_HANDLE;
+		pass.framebuffer = VK_NULL_HANDLE;
+		pass.clearValues.clear();
+
+		if (!pass.live)
+			continue;
+
+		RenderPassKey key;
+		key.hasDepth = false;
+
+		std::vector<VkImageView> views;
+		const PassUse* depthUse = nullptr;
+
+		// colors in the order they were declared, the depth attachment goes last
+		for (int depthPass = 0; depthPass < 2; depthPass++)
+		{
+			for (const PassUse &use : pass.uses)
+			{
+				if (depthPass ? !use.depthAttachment : !use.colorAttachment)
+					continue;
+
+				if (depthPass && depthUse)
+					throw std::runtime_error("More than one depth attachment in " + pass.name);
+
+				if (depthPass)
+					depthUse = &use;
+
+				const ResourceEntry &entry = resources[use.resource];
+
+				if (views.empty())
+					pass.extent = { entry.imageDesc.width, entry.imageDesc.height };
+				else if (pass.extent.width != entry.imageDesc.width || pass.extent.height != entry.imageDesc.height)
+					throw std::runtime_error("Attachments of different sizes in " + pass.name);
+
+				AttachmentKey attachment;
+				attachment.format = entry.imageDesc.format;
+				attachment.samples = entry.imageDesc.samples;
+				attachment.layout = use.layout;
+				attachment.loadOp = use.cleared ? VK_ATTACHMENT_LOAD_OP_CLEAR
+					: use.hadContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.storeOp = use.usedLater ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+				VkClearValue clearValue = {};
+				for (const std::pair<Resource, VkClearValue> &clear : pass.clears)
+				{
+					if (clear.first == use.resource)
+						clearValue = clear.second;
+				}
+
+				key.attachments.push_back(attachment);
+				views.push_back(entry.view);
+				pass.clearValues.push_back(clearValue);
+			}
+		}
+
+		if (views.empty())
+			continue;
+
+		key.hasDepth = depthUse != nullptr;
+
+		pass.renderPass = GetRenderPass(key);
+		pass.framebuffer = GetFramebuffer(pass.renderPass, views, pass.extent);
+		stats.renderPasses++;
+	}
+}
+
+VkRenderPass RenderGraph::GetRenderPass(const RenderPassKey &key)
+{
+	std::vector<CachedRenderPass> &bucket = renderPasses[key.Hash()];
+
+	for (const CachedRenderPass &entry : bucket)
+	{
+		if (entry.key == key)
+			return entry.renderPass;
+	}
+
+	std::vector<VkAttachmentDescription> attachments(key.attachments.size());
+	std::vector<VkAttachmentReference> colorReferences;
+	VkAttachmentReference depthReference = {};
+
+	for (uint32_t i = 0; i < key.attachments.size(); i++)
+	{
+		const AttachmentKey &attachment = key.attachments[i];
+		bool isDepth = key.hasDepth && i + 1 == key.attachments.size();
+
+		// barriers outside the render pass do every transition, layouts stay put inside
+		VkAttachmentDescription &description = attachments[i];
+		description.flags = 0;
+		description.format = attachment.format;
+		description.samples = attachment.samples;
+		description.loadOp = attachment.loadOp;
+		description.storeOp = attachment.storeOp;
+		description.stencilLoadOp = isDepth ? attachment.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		description.stencilStoreOp = isDepth ? attachment.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		description.initialLayout = attachment.layout;
+		description.finalLayout = attachment.layout;
+
+		if (isDepth)
+			depthReference = { i, attachment.layout };
+		else
+			colorReferences.push_back({ i, attachment.layout });
+	}
+
+	VkSubpassDescription subpass = {};
+	subpass.flags = 0;
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.inputAttachmentCount = 0;
+	subpass.pInputAttachments = nullptr;
+	subpass.colorAttachmentCount = (uint32_t)colorReferences.size();
+	subpass.pColorAttachments = colorReferences.data();
+	subpass.pResolveAttachments = nullptr;
+	subpass.pDepthStencilAttachment = key.hasDepth ? &depthReference : nullptr;
+	subpass.preserveAttachmentCount = 0;
+	subpass.pPreserveAttachments = nullptr;
+
+	VkRenderPassCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.attachmentCount = (uint32_t)attachments.size();
+	createInfo.pAttachments = attachments.data();
+	createInfo.subpassCount = 1;
+	createInfo.pSubpasses = &subpass;
+	createInfo.dependencyCount = 0;
+	createInfo.pDependencies = nullptr;
+
+	CachedRenderPass entry;
+	entry.key = key;
+
+	if (vkCreateRenderPass(Vulkan.device, &createInfo, nullptr, &entry.renderPass) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create render graph render pass");
+
+	bucket.push_back(entry);
+	return entry.renderPass;
+}
+
+VkFramebuffer RenderGraph::GetFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView> &views, VkExtent2D extent)
+{
+	FrameResources &frame = frames[frameIndex];
+
+	for (CachedFramebuffer &entry : frame.framebuffers)
+	{
+		if (entry.renderPass == renderPass && entry.views == views && entry.extent.width == extent.width && entry.extent.height == extent.height)
+		{
+			entry.used = true;
+			return entry.framebuffer;
+		}
+	}
+
+	VkFramebufferCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.renderPass = renderPass;
+	createInfo.attachmentCount = (uint32_t)views.size();
+	createInfo.pAttachments = views.data();
+	createInfo.width = extent.width;
+	createInfo.height = extent.height;
+	createInfo.layers = 1;
+
+	CachedFramebuffer entry;
+	entry.renderPass = renderPass;
+	entry.views = views;
+	entry.extent = extent;
+	entry.used = true;
+
+	if (vkCreateFramebuffer(Vulkan.device, &createInfo, nullptr, &entry.framebuffer) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create render graph framebuffer");
+
+	frame.framebuffers.push_back(entry);
+	return entry.framebuffer;
+}
+
+VkImageAspectFlags RenderGraph::GetAspectMask(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	case VK_FORMAT_S8_UINT:
+		return VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
\ No newline at end of file
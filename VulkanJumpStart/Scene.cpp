@@ -0,0 +1,146 @@
+#include "Scene.h"
+
+#include <string.h>
+#include <math.h>
+
+static const uint32_t CubeVertexCount = 8;
+static const uint32_t CubeIndexCount = 36;
+
+static const float CubeVertices[CubeVertexCount][3] = {
+	{ -1, -1, -1 }, { 1, -1, -1 }, { 1, 1, -1 }, { -1, 1, -1 },
+	{ -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 }
+};
+
+static const uint16_t CubeIndices[CubeIndexCount] = {
+	0, 2, 1, 0, 3, 2,
+	4, 5, 6, 4, 6, 7,
+	0, 1, 5, 0, 5, 4,
+	3, 6, 2, 3, 7, 6,
+	0, 4, 7, 0, 7, 3,
+	1, 2, 6, 1, 6, 5
+};
+
+Scene::Scene()
+{
+}
+
+Scene::~Scene()
+{
+	Destroy();
+}
+
+void Scene::Create(uint32_t objectCount, uint32_t gpuInstanceCount)
+{
+	const VkDeviceSize vertexSize = sizeof(CubeVertices);
+	const VkDeviceSize indexSize = sizeof(CubeIndices);
+
+	mesh.Create(vertexSize + indexSize,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	memcpy(mesh.GetMapped(), CubeVertices, (size_t)vertexSize);
+	memcpy((uint8_t*)mesh.GetMapped() + vertexSize, CubeIndices, (size_t)indexSize);
+
+	meshDraw.pipeline = VK_NULL_HANDLE;
+	meshDraw.pipelineLayout = VK_NULL_HANDLE;
+	meshDraw.materialSet = VK_NULL_HANDLE;
+	meshDraw.vertexBuffer = mesh.GetBuffer();
+	meshDraw.vertexBufferOffset = 0;
+	meshDraw.indexBuffer = mesh.GetBuffer();
+	meshDraw.indexBufferOffset = vertexSize;
+	meshDraw.indexType = VK_INDEX_TYPE_UINT16;
+	meshDraw.indexCount = CubeIndexCount;
+	meshDraw.instanceCount = 1;
+	meshDraw.firstIndex = 0;
+	meshDraw.vertexOffset = 0;
+	meshDraw.firstInstance = 0;
+
+	objects.resize(objectCount);
+
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		Object &object = objects[i];
+		PlaceOnGrid(i, objectCount, 0.25f, object.sphere);
+
+		// the cube's corners touch the sphere
+		float scale = object.sphere[3] / sqrtf(3.0f);
+
+		memset(object.transform, 0, sizeof(object.transform));
+		object.transform[0] = scale;
+		object.transform[5] = scale;
+		object.transform[10] = scale;
+		object.transform[12] = object.sphere[0];
+		object.transform[13] = object.sphere[1];
+		object.transform[14] = object.sphere[2];
+		object.transform[15] = 1.0f;
+	}
+
+	gpuInstances.resize(gpuInstanceCount);
+
+	for (uint32_t i = 0; i < gpuInstanceCount; i++)
+	{
+		GpuCulling::Instance &instance = gpuInstances[i];
+		PlaceOnGrid(i, gpuInstanceCount, 0.75f, instance.sphere);
+
+		instance.indexCount = CubeIndexCount;
+		instance.firstIndex = 0;
+		instance.vertexOffset = 0;
+		instance.instanceId = i;
+	}
+}
+
+void Scene::Destroy()
+{
+	mesh.Destroy();
+	meshDraw = {};
+
+	objects.clear();
+	gpuInstances.clear();
+}
+
+void Scene::SetMeshPipeline(VkPipeline pipeline, VkPipelineLayout pipelineLayout)
+{
+	meshDraw.pipeline = pipeline;
+	meshDraw.pipelineLayout = pipelineLayout;
+}
+
+void Scene::Cull(DrawList &drawList, const float planes[6][4], uint32_t begin, uint32_t end) const
+{
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const Object &object = objects[i];
+		const float* center = object.sphere;
+
+		float distances[6];
+		bool visible = true;
+
+		for (int plane = 0; plane < 6 && visible; plane++)
+		{
+			distances[plane] = planes[plane][0] * center[0] + planes[plane][1] * center[1] + planes[plane][2] * center[2] + planes[plane][3];
+			visible = distances[plane] >= -object.sphere[3];
+		}
+
+		if (!visible)
+			continue;
+
+		// where the center sits between the near and far planes, whatever the projection
+		float range = distances[4] + distances[5];
+		uint32_t depth = DrawList::QuantizeDepth(range > 0.0f ? distances[4] / range : 0.0f, 0.0f, 1.0f);
+
+		drawList.Add(DrawList::MakeOpaqueKey(0, 0, 0, 0, depth), meshDraw, object.transform);
+	}
+}
+
+void Scene::PlaceOnGrid(uint32_t index, uint32_t count, float depth, float sphere[4])
+{
+	// a square grid over [-1.25, 1.25], the outer ring lies outside the clip volume
+	const float extent = 1.25f;
+
+	uint32_t side = (uint32_t)ceilf(sqrtf((float)count));
+	float spacing = 2.0f * extent / (float)side;
+
+	sphere[0] = -extent + spacing * ((float)(index % side) + 0.5f);
+	sphere[1] = -extent + spacing * ((float)(index / side) + 0.5f);
+	sphere[2] = depth;
+	sphere[3] = 0.5f * spacing;
+}
\ No newline at end of file
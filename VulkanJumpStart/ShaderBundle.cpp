@@ -0,0 +1,351 @@
+#include "ShaderBundle.h"
+
+#include <fstream>
+#include <algorithm>
+#include <string.h>
+
+#include "Hash.h"
+
+// reflection records are plain words: stage, binding count, vertex input count, the push
+// constant range, then five words per binding and two per vertex input
+static const uint32_t ReflectionHeaderWords = 6;
+static const uint32_t ReflectionBindingWords = 5;
+static const uint32_t ReflectionVertexInputWords = 2;
+
+static uint64_t HashName(const char* name, size_t length)
+{
+	return HashBytes(name, length);
+}
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static std::vector<uint32_t> SerializeReflection(const ShaderReflection &reflection)
+{
+	std::vector<uint32_t> words;
+
+	words.push_back((uint32_t)reflection.stage);
+	words.push_back((uint32_t)reflection.bindings.size());
+	words.push_back((uint32_t)reflection.vertexInputs.size());
+	words.push_back(reflection.pushConstants.stageFlags);
+	words.push_back(reflection.pushConstants.offset);
+	words.push_back(reflection.pushConstants.size);
+
+	for (const ReflectedBinding &binding : reflection.bindings)
+	{
+		words.push_back(binding.set);
+		words.push_back(binding.binding);
+		words.push_back((uint32_t)binding.type);
+		words.push_back(binding.count);
+		words.push_back(binding.stages);
+	}
+
+	for (const ReflectedVertexInput &input : reflection.vertexInputs)
+	{
+		words.push_back(input.location);
+		words.push_back((uint32_t)input.format);
+	}
+
+	return words;
+}
+
+ShaderBundle::ShaderBundle()
+{
+}
+
+ShaderBundle::~ShaderBundle()
+{
+	Close();
+}
+
+bool ShaderBundle::Open(const char* path, const char* looseDirectory)
+{
+	Close();
+
+	this->looseDirectory = looseDirectory;
+
+	if (!OSMapFile(path, &file))
+	{
+		file = {};
+		return false;
+	}
+
+	header = (const Header*)file.data;
+	slots = (const Slot*)(header + 1);
+	entries = (const Entry*)(slots + (file.size >= sizeof(Header) ? header->slotCount : 0));
+
+	// everything else is bounds checked once here so lookups can trust the offsets
+	bool valid = file.size >= sizeof(Header)
+		&& header->magic == Magic
+		&& header->version == Version
+		&& header->fileSize == file.size
+		&& header->slotCount > header->shaderCount
+		&& (header->slotCount & (header->slotCount - 1)) == 0
+		&& sizeof(Header) + (uint64_t)header->slotCount * sizeof(Slot) + (uint64_t)header->shaderCount * sizeof(Entry) <= file.size;
+
+	// lookups stop at the first empty slot, a table without one is rejected
+	uint32_t emptySlots = 0;
+
+	for (uint32_t i = 0; valid && i < header->slotCount; i++)
+	{
+		valid = slots[i].entry == EmptySlot || slots[i].entry < header->shaderCount;
+		emptySlots += slots[i].entry == EmptySlot;
+	}
+
+	valid = valid && emptySlots > 0;
+
+	for (uint32_t i = 0; valid && i < header->shaderCount; i++)
+	{
+		const Entry &entry = entries[i];
+
+		valid = (uint64_t)entry.nameOffset + entry.nameLength <= file.size
+			&& (uint64_t)entry.codeOffset + entry.codeSize <= file.size
+			&& (uint64_t)entry.reflectionOffset + entry.reflectionSize <= file.size
+			&& entry.codeOffset % BlobAlignment == 0
+			&& entry.codeSize % sizeof(uint32_t) == 0
+			&& entry.reflectionOffset % sizeof(uint32_t) == 0;
+	}
+
+	if (!valid)
+	{
+		Close();
+		throw std::runtime_error(std::string("Invalid shader bundle ") + path);
+	}
+
+	return true;
+}
+
+void ShaderBundle::Close()
+{
+	if (file.data)
+		OSUnmapFile(&file);
+
+	file = {};
+	header = nullptr;
+	slots = nullptr;
+	entries = nullptr;
+}
+
+const ShaderBundle::Entry* ShaderBundle::Find(const char* name) const
+{
+	if (!IsOpen())
+		return nullptr;
+
+	size_t length = strlen(name);
+	uint64_t hash = HashName(name, length);
+	uint32_t mask = header->slotCount - 1;
+
+	// Open made sure an empty slot ends the probe, the bound only guards against a bad table
+	uint32_t slot = (uint32_t)hash & mask;
+
+	for (uint32_t probe = 0; probe < header->slotCount; probe++, slot = (slot + 1) & mask)
+	{
+		if (slots[slot].entry == EmptySlot)
+			return nullptr;
+
+		if (slots[slot].nameHash != hash)
+			continue;
+
+		const Entry &entry = entries[slots[slot].entry];
+		const char* entryName = (const char*)file.data + entry.nameOffset;
+
+		if (entry.nameLength == length && memcmp(entryName, name, length) == 0)
+			return &entry;
+	}
+
+	return nullptr;
+}
+
+const uint32_t* ShaderBundle::FindCode(const char* name, size_t* codeSize) const
+{
+	const Entry* entry = Find(name);
+	if (!entry)
+		return nullptr;
+
+	*codeSize = entry->codeSize;
+	return (const uint32_t*)((const char*)file.data + entry->codeOffset);
+}
+
+VkShaderModule ShaderBundle::CreateShaderModule(const char* name, uint64_t* codeHash) const
+{
+	size_t codeSize;
+	const uint32_t* code = FindCode(name, &codeSize);
+
+	if (code)
+		return vkfwCreateShaderModule(code, codeSize, codeHash);
+
+	std::string path = looseDirectory + "/" + name + ".spv";
+	return vkfwLoadShaderModule(path.c_str(), codeHash);
+}
+
+bool ShaderBundle::GetReflection(const char* name, ShaderReflection &reflection) const
+{
+	const Entry* entry = Find(name);
+	if (!entry || entry->reflectionSize < ReflectionHeaderWords * sizeof(uint32_t))
+		return false;
+
+	const uint32_t* words = (const uint32_t*)((const char*)file.data + entry->reflectionOffset);
+
+	uint32_t bindingCount = words[1];
+	uint32_t vertexInputCount = words[2];
+
+	// in 64 bits, counts from a damaged file must not wrap around to the stored size
+	uint64_t size = ((uint64_t)ReflectionHeaderWords + (uint64_t)bindingCount * ReflectionBindingWords
+		+ (uint64_t)vertexInputCount * ReflectionVertexInputWords) * sizeof(uint32_t);
+
+	if (size != entry->reflectionSize || (uint64_t)entry->reflectionOffset + size > file.size)
+		throw std::runtime_error(std::string("Invalid reflection data in shader bundle for ") + name);
+
+	reflection.stage = (VkShaderStageFlagBits)words[0];
+	reflection.pushConstants.stageFlags = words[3];
+	reflection.pushConstants.offset = words[4];
+	reflection.pushConstants.size = words[5];
+
+	reflection.bindings.resize(bindingCount);
+	reflection.vertexInputs.resize(vertexInputCount);
+
+	words += ReflectionHeaderWords;
+
+	for (ReflectedBinding &binding : reflection.bindings)
+	{
+		binding.set = words[0];
+		binding.binding = words[1];
+		binding.type = (VkDescriptorType)words[2];
+		binding.count = words[3];
+		binding.stages = words[4];
+		words += ReflectionBindingWords;
+	}
+
+	for (ReflectedVertexInput &input : reflection.vertexInputs)
+	{
+		input.location = words[0];
+		input.format = (VkFormat)words[1];
+		words += ReflectionVertexInputWords;
+	}
+
+	return true;
+}
+
+uint32_t ShaderBundle::GetShaderCount() const
+{
+	return IsOpen() ? header->shaderCount : 0;
+}
+
+void ShaderBundle::Pack(const char* directory, const char* outputPath, bool includeReflection, std::ostream &stream)
+{
+	std::vector<std::string> fileNames;
+	if (!OSListDirectory(directory, fileNames))
+		throw std::runtime_error(std::string("Failed to list shader directory ") + directory);
+
+	// sorted so the same shaders always produce the same bundle
+	std::sort(fileNames.begin(), fileNames.end());
+
+	std::vector<std::string> names;
+	std::vector<std::vector<uint32_t>> codes;
+	std::vector<std::vector<uint32_t>> reflections;
+
+	for (const std::string &fileName : fileNames)
+	{
+		if (fileName.size() <= 4 || fileName.compare(fileName.size() - 4, 4, ".spv") != 0)
+			continue;
+
+		std::string path = std::string(directory) + "/" + fileName;
+
+		names.push_back(fileName.substr(0, fileName.size() - 4));
+		codes.push_back(vkfwReadShaderCode(path.c_str()));
+		reflections.emplace_back();
+
+		if (includeReflection)
+		{
+			ShaderReflection reflection;
+			reflection.Parse(codes.back());
+			reflections.back() = SerializeReflection(reflection);
+		}
+	}
+
+	uint32_t shaderCount = (uint32_t)names.size();
+
+	// at most half full keeps probes short
+	uint32_t slotCount = 1;
+	while (slotCount < shaderCount * 2)
+		slotCount *= 2;
+
+	std::vector<Slot> slots(slotCount, { 0, EmptySlot, 0 });
+	std::vector<Entry> entries(shaderCount);
+
+	size_t offset = sizeof(Header) + slotCount * sizeof(Slot) + shaderCount * sizeof(Entry);
+
+	for (uint32_t i = 0; i < shaderCount; i++)
+	{
+		entries[i].nameOffset = (uint32_t)offset;
+		entries[i].nameLength = (uint32_t)names[i].size();
+		offset += names[i].size();
+	}
+
+	for (uint32_t i = 0; i < shaderCount; i++)
+	{
+		offset = AlignUp(offset, BlobAlignment);
+		entries[i].codeOffset = (uint32_t)offset;
+		entries[i].codeSize = (uint32_t)(codes[i].size() * sizeof(uint32_t));
+		offset += entries[i].codeSize;
+
+		entries[i].reflectionOffset = (uint32_t)offset;
+		entries[i].reflectionSize = (uint32_t)(reflections[i].size() * sizeof(uint32_t));
+		offset += entries[i].reflectionSize;
+
+		uint64_t hash = HashName(names[i].data(), names[i].size());
+		uint32_t slot = (uint32_t)hash & (slotCount - 1);
+
+		while (slots[slot].entry != EmptySlot)
+		{
+			const std::string &other = names[slots[slot].entry];
+			if (other == names[i])
+				throw std::runtime_error("Failed to pack shaders, duplicate name " + names[i]);
+
+			slot = (slot + 1) & (slotCount - 1);
+		}
+
+		slots[slot].nameHash = hash;
+		slots[slot].entry = i;
+	}
+
+	if (offset > 0xFFFFFFFF)
+		throw std::runtime_error("Failed to pack shaders, bundle exceeds 4 GB");
+
+	Header header = {};
+	header.magic = Magic;
+	header.version = Version;
+	header.shaderCount = shaderCount;
+	header.slotCount = slotCount;
+	header.fileSize = offset;
+
+	std::vector<char> data(offset, 0);
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(Header), slots.data(), slots.size() * sizeof(Slot));
+	memcpy(data.data() + sizeof(Header) + slots.size() * sizeof(Slot), entries.data(), entries.size() * sizeof(Entry));
+
+	for (uint32_t i = 0; i < shaderCount; i++)
+	{
+		memcpy(data.data() + entries[i].nameOffset, names[i].data(), names[i].size());
+		memcpy(data.data() + entries[i].codeOffset, codes[i].data(), entries[i].codeSize);
+
+		if (entries[i].reflectionSize > 0)
+			memcpy(data.data() + entries[i].reflectionOffset, reflections[i].data(), entries[i].reflectionSize);
+	}
+
+	// written next to the target and moved over it, so a failed pack leaves the old bundle intact
+	std::string temporaryPath = std::string(outputPath) + ".tmp";
+
+	{
+		std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!output.write(data.data(), data.size()))
+			throw std::runtime_error(std::string("Failed to write shader bundle ") + temporaryPath);
+	}
+
+	if (!OSReplaceFile(temporaryPath.c_str(), outputPath))
+		throw std::runtime_error(std::string("Failed to replace shader bundle ") + outputPath);
+
+	stream << "packed " << shaderCount << " shaders into " << outputPath << ", " << data.size() << " bytes" << std::endl;
+}
\ No newline at end of file
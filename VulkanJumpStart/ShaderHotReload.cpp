@@ -0,0 +1,327 @@
+#include "ShaderHotReload.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+
+static const char* StageExtensions[] = { "vert", "frag", "comp", "geom", "tesc", "tese" };
+
+static bool EndsWith(const std::string &text, const char* suffix)
+{
+	size_t length = strlen(suffix);
+	return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+static std::string FileNameOf(const std::string &path)
+{
+	size_t separator = path.find_last_of("/\\");
+	return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+// the glslangValidator stage name of a source file, empty for anything that is not a stage
+static std::string StageOf(const std::string &fileName, bool* hlsl)
+{
+	*hlsl = EndsWith(fileName, ".hlsl");
+
+	std::string name = *hlsl ? fileName.substr(0, fileName.size() - 5) : fileName;
+
+	for (const char* extension : StageExtensions)
+	{
+		if (EndsWith(name, (std::string(".") + extension).c_str()))
+			return extension;
+	}
+
+	return std::string();
+}
+
+static bool IsInclude(const std::string &fileName)
+{
+	return EndsWith(fileName, ".glsl") || EndsWith(fileName, ".hlsli");
+}
+
+ShaderHotReload::ShaderHotReload()
+	: stopping(false)
+{
+}
+
+ShaderHotReload::~ShaderHotReload()
+{
+	Destroy();
+}
+
+void ShaderHotReload::Create(const char* shaderDirectory, PipelineCompiler &compiler, FrameRing &frameRing, const char* compilerPath)
+{
+	this->directory = shaderDirectory;
+	this->compilerPath = compilerPath;
+	this->compiler = &compiler;
+	this->frameRing = &frameRing;
+	this->stopping = false;
+
+	// a missing watcher only costs the reloads, the application runs as before
+	watch = OSCreateDirectoryWatch(shaderDirectory);
+	if (!watch)
+	{
+		std::cerr << "Shader hot reload disabled, cannot watch " << shaderDirectory << std::endl;
+		return;
+	}
+
+	thread = std::thread(&ShaderHotReload::ThreadMain, this);
+}
+
+void ShaderHotReload::Destroy()
+{
+	stopping = true;
+
+	if (thread.joinable())
+		thread.join();
+
+	if (watch)
+	{
+		OSDestroyDirectoryWatch(watch);
+		watch = nullptr;
+	}
+
+	for (Rebuild &rebuild : rebuilds)
+	{
+		VkPipeline pipeline = VK_NULL_HANDLE;
+
+		try
+		{
+			pipeline = rebuild.future.get();
+		}
+		catch (const std::exception&)
+		{
+		}
+
+		if (pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(Vulkan.device, pipeline, nullptr);
+
+		for (VkShaderModule module : rebuild.modules)
+			vkDestroyShaderModule(Vulkan.device, module, nullptr);
+	}
+
+	for (Watched &entry : watched)
+	{
+		if (entry.owned != VK_NULL_HANDLE)
+			vkDestroyPipeline(Vulkan.device, entry.owned, nullptr);
+	}
+
+	rebuilds.clear();
+	watched.clear();
+}
+
+void ShaderHotReload::Watch(AsyncPipeline* target, const PipelineDesc &desc, const std::vector<std::string> &stageSources)
+{
+	if (stageSources.size() != desc.stages.size())
+		throw std::runtime_error("Failed to watch pipeline, one source per stage is required");
+
+	Watched entry;
+	entry.target = target;
+	entry.desc = desc;
+
+	for (const std::string &source : stageSources)
+		entry.stageSources.push_back(FileNameOf(source));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	watched.push_back(std::move(entry));
+}
+
+void ShaderHotReload::Update()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (size_t i = 0; i < rebuilds.size();)
+	{
+		Rebuild &rebuild = rebuilds[i];
+
+		if (rebuild.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			i++;
+			continue;
+		}
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+
+		try
+		{
+			pipeline = rebuild.future.get();
+		}
+		catch (const std::exception &e)
+		{
+			// a shader that compiles but fails pipeline creation keeps the previous pipeline
+			std::cerr << "Shader reload failed: " << e.what() << std::endl;
+		}
+
+		// pipelines do not reference their modules once created
+		for (VkShaderModule module : rebuild.modules)
+			vkDestroyShaderModule(Vulkan.device, module, nullptr);
+
+		if (pipeline != VK_NULL_HANDLE)
+		{
+			Watched &entry = watched[rebuild.watchedIndex];
+			entry.target->Replace(pipeline);
+
+			// frames in flight may still be using the pipeline being replaced
+			if (entry.owned != VK_NULL_HANDLE)
+			{
+				VkPipeline retired = entry.owned;
+				frameRing->Defer([retired]() { vkDestroyPipeline(Vulkan.device, retired, nullptr); });
+			}
+
+			entry.owned = pipeline;
+		}
+
+		rebuilds.erase(rebuilds.begin() + i);
+	}
+}
+
+void ShaderHotReload::ThreadMain()
+{
+	std::vector<std::string> fileNames;
+
+	while (!stopping)
+	{
+		fileNames.clear();
+		OSReadDirectoryChanges(watch, 100, fileNames);
+
+		if (fileNames.empty())
+			continue;
+
+		// editors save in several steps, let the burst settle before compiling
+		size_t count;
+		do
+		{
+			count = fileNames.size();
+			OSReadDirectoryChanges(watch, 50, fileNames);
+		} while (fileNames.size() != count && !stopping);
+
+		std::sort(fileNames.begin(), fileNames.end());
+		fileNames.erase(std::unique(fileNames.begin(), fileNames.end()), fileNames.end());
+
+		std::vector<std::string> sources;
+		bool includeChanged = false;
+
+		for (const std::string &fileName : fileNames)
+		{
+			bool hlsl;
+
+			// our own output shows up here as well
+			if (EndsWith(fileName, ".spv"))
+				continue;
+
+			if (IsInclude(fileName))
+				includeChanged = true;
+			else if (!StageOf(fileName, &hlsl).empty())
+				sources.push_back(fileName);
+		}
+
+		// without dependency tracking every watched source may use the include
+		if (includeChanged)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			for (const Watched &entry : watched)
+				sources.insert(sources.end(), entry.stageSources.begin(), entry.stageSources.end());
+
+			std::sort(sources.begin(), sources.end());
+			sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+		}
+
+		std::vector<std::string> compiled;
+
+		for (const std::string &source : sources)
+		{
+			if (CompileSource(source))
+				compiled.push_back(source);
+		}
+
+		if (!compiled.empty())
+			RebuildPipelines(compiled);
+	}
+}
+
+bool ShaderHotReload::CompileSource(const std::string &fileName) const
+{
+	bool hlsl;
+	std::string stage = StageOf(fileName, &hlsl);
+	std::string path = directory + "/" + fileName;
+
+	// file names come straight from the directory, they are passed as arguments and never
+	// go through a shell
+	std::vector<std::string> arguments = { compilerPath, "-V" };
+	if (hlsl)
+		arguments.insert(arguments.end(), { "-D", "-e", "main", "-S", stage });
+
+	arguments.insert(arguments.end(), { path, "-o", path + ".spv" });
+
+	// the compiler prints its own diagnostics
+	if (OSRunProcess(arguments) != 0)
+	{
+		std::cerr << "Shader reload, failed to compile " << path << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void ShaderHotReload::RebuildPipelines(const std::vector<std::string> &compiledNames)
+{
+	std::vector<std::pair<size_t, Watched>> affected;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (size_t i = 0; i < watched.size(); i++)
+		{
+			for (const std::string &source : watched[i].stageSources)
+			{
+				if (std::find(compiledNames.begin(), compiledNames.end(), source) != compiledNames.end())
+				{
+					affected.emplace_back(i, watched[i]);
+					break;
+				}
+			}
+		}
+	}
+
+	for (std::pair<size_t, Watched> &entry : affected)
+	{
+		Rebuild rebuild;
+		rebuild.watchedIndex = entry.first;
+
+		PipelineDesc &desc = entry.second.desc;
+
+		try
+		{
+			// every stage gets a fresh module, the ones in the original description may be gone
+			for (size_t stage = 0; stage < desc.stages.size(); stage++)
+			{
+				std::string path = directory + "/" + entry.second.stageSources[stage] + ".spv";
+
+				auto code = std::make_shared<const std::vector<uint32_t>>(vkfwReadShaderCode(path.c_str()));
+
+				uint64_t codeHash;
+				VkShaderModule module = vkfwCreateShaderModule(*code, &codeHash);
+				rebuild.modules.push_back(module);
+
+				desc.stages[stage].module = module;
+				desc.stages[stage].code = std::move(code);
+				desc.stages[stage].moduleHash = codeHash;
+			}
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << "Shader reload failed: " << e.what() << std::endl;
+
+			for (VkShaderModule module : rebuild.modules)
+				vkDestroyShaderModule(Vulkan.device, module, nullptr);
+
+			continue;
+		}
+
+		rebuild.future = compiler->Compile(desc);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		rebuilds.push_back(std::move(rebuild));
+	}
+}
\ No newline at end of file
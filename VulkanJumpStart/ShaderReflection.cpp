@@ -0,0 +1,447 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+#include <assert.h>
+
+static const uint32_t SpirvMagic = 0x07230203;
+static const uint32_t HeaderWords = 5;
+static const uint32_t Unset = ~0u;
+
+// the subset of the SPIR-V grammar reflection needs
+enum SpirvOp
+{
+	OpEntryPoint = 15,
+	OpTypeBool = 20,
+	OpTypeInt = 21,
+	OpTypeFloat = 22,
+	OpTypeVector = 23,
+	OpTypeMatrix = 24,
+	OpTypeImage = 25,
+	OpTypeSampler = 26,
+	OpTypeSampledImage = 27,
+	OpTypeArray = 28,
+	OpTypeRuntimeArray = 29,
+	OpTypeStruct = 30,
+	OpTypePointer = 32,
+	OpConstant = 43,
+	OpSpecConstant = 50,
+	OpVariable = 59,
+	OpDecorate = 71,
+	OpMemberDecorate = 72
+};
+
+enum SpirvDecoration
+{
+	DecorationBlock = 2,
+	DecorationBufferBlock = 3,
+	DecorationArrayStride = 6,
+	DecorationMatrixStride = 7,
+	DecorationBuiltIn = 11,
+	DecorationLocation = 30,
+	DecorationBinding = 33,
+	DecorationDescriptorSet = 34,
+	DecorationOffset = 35
+};
+
+enum SpirvStorageClass
+{
+	StorageClassUniformConstant = 0,
+	StorageClassInput = 1,
+	StorageClassUniform = 2,
+	StorageClassPushConstant = 9,
+	StorageClassStorageBuffer = 12
+};
+
+enum SpirvDim
+{
+	DimBuffer = 5,
+	DimSubpassData = 6
+};
+
+struct SpirvMember
+{
+	uint32_t offset = 0;
+	uint32_t matrixStride = 0;
+};
+
+struct SpirvId
+{
+	uint32_t opcode = 0;
+	// first word of the defining instruction and its length
+	uint32_t word = 0;
+	uint32_t wordCount = 0;
+
+	uint32_t set = Unset;
+	uint32_t binding = Unset;
+	uint32_t location = Unset;
+	uint32_t arrayStride = 0;
+	uint32_t constant = 0;
+	bool builtIn = false;
+	bool block = false;
+	bool bufferBlock = false;
+
+	std::vector<SpirvMember> members;
+};
+
+class SpirvModule
+{
+public:
+	SpirvModule(const std::vector<uint32_t> &code) : code(code)
+	{
+	}
+
+	const std::vector<uint32_t> &code;
+	std::vector<SpirvId> ids;
+
+	const SpirvId& Get(uint32_t id) const
+	{
+		if (id >= ids.size() || ids[id].opcode == 0)
+			throw std::runtime_error("Invalid SPIR-V, undefined id");
+
+		return ids[id];
+	}
+
+	uint32_t Operand(const SpirvId &id, uint32_t index) const
+	{
+		if (index >= id.wordCount)
+			throw std::runtime_error("Invalid SPIR-V, truncated instruction");
+
+		return code[id.word + index];
+	}
+
+	uint32_t SizeOf(uint32_t typeId, uint32_t matrixStride) const
+	{
+		const SpirvId &type = Get(typeId);
+
+		switch (type.opcode)
+		{
+		case OpTypeBool:
+			return 4;
+		case OpTypeInt:
+		case OpTypeFloat:
+			return Operand(type, 2) / 8;
+		case OpTypeVector:
+			return Operand(type, 3) * SizeOf(Operand(type, 2), 0);
+		case OpTypeMatrix:
+			return Operand(type, 3) * (matrixStride ? matrixStride : SizeOf(Operand(type, 2), 0));
+		case OpTypeArray:
+			return Get(Operand(type, 3)).constant * (type.arrayStride ? type.arrayStride : SizeOf(Operand(type, 2), matrixStride));
+		case OpTypeStruct:
+		{
+			uint32_t size = 0;
+
+			for (uint32_t i = 0; i + 2 < type.wordCount; i++)
+			{
+				SpirvMember member = i < type.members.size() ? type.members[i] : SpirvMember();
+				size = std::max(size, member.offset + SizeOf(Operand(type, i + 2), member.matrixStride));
+			}
+
+			return size;
+		}
+		default:
+			// runtime arrays and opaque types take no space in a block
+			return 0;
+		}
+	}
+};
+
+static VkShaderStageFlagBits StageFromExecutionModel(uint32_t model)
+{
+	switch (model)
+	{
+	case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+	case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+	case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+	case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+	case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+	case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+	default: throw std::runtime_error("Unsupported shader execution model");
+	}
+}
+
+static VkFormat VertexFormat(uint32_t componentOpcode, uint32_t signedness, uint32_t width, uint32_t componentCount)
+{
+	static const VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+	static const VkFormat intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+	static const VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+	if (width != 32 || componentCount < 1 || componentCount > 4)
+		return VK_FORMAT_UNDEFINED;
+
+	if (componentOpcode == OpTypeFloat)
+		return floatFormats[componentCount - 1];
+
+	return signedness ? intFormats[componentCount - 1] : uintFormats[componentCount - 1];
+}
+
+ShaderReflection::ShaderReflection()
+{
+	stage = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstants = {};
+}
+
+void ShaderReflection::Parse(const std::vector<uint32_t> &code)
+{
+	if (code.size() < HeaderWords || code[0] != SpirvMagic)
+		throw std::runtime_error("Invalid SPIR-V, bad header");
+
+	SpirvModule module(code);
+	module.ids.resize(code[3]);
+
+	bindings.clear();
+	vertexInputs.clear();
+	pushConstants = {};
+
+	bool hasEntryPoint = false;
+	std::vector<uint32_t> variables;
+
+	auto define = [&module](uint32_t id, uint32_t opcode, uint32_t word, uint32_t wordCount) -> SpirvId&
+	{
+		if (id >= module.ids.size())
+			throw std::runtime_error("Invalid SPIR-V, id out of bounds");
+
+		SpirvId &entry = module.ids[id];
+		entry.opcode = opcode;
+		entry.word = word;
+		entry.wordCount = wordCount;
+		return entry;
+	};
+
+	auto decorated = [&module](uint32_t id) -> SpirvId&
+	{
+		if (id >= module.ids.size())
+			throw std::runtime_error("Invalid SPIR-V, id out of bounds");
+
+		return module.ids[id];
+	};
+
+	for (uint32_t word = HeaderWords; word < code.size();)
+	{
+		uint32_t opcode = code[word] & 0xFFFF;
+		uint32_t wordCount = code[word] >> 16;
+
+		if (wordCount == 0 || word + wordCount > code.size())
+			throw std::runtime_error("Invalid SPIR-V, bad instruction length");
+
+		const uint32_t* operands = &code[word + 1];
+
+		switch (opcode)
+		{
+		case OpEntryPoint:
+			// execution model, entry point id and at least one word of name
+			if (wordCount < 4)
+				throw std::runtime_error("Invalid SPIR-V, truncated instruction");
+
+			if (!hasEntryPoint)
+			{
+				stage = StageFromExecutionModel(operands[0]);
+				hasEntryPoint = true;
+			}
+			break;
+
+		case OpDecorate:
+		{
+			if (wordCount < 3)
+				throw std::runtime_error("Invalid SPIR-V, truncated instruction");
+
+			SpirvId &target = decorated(operands[0]);
+			uint32_t value = wordCount > 3 ? operands[2] : 0;
+
+			switch (operands[1])
+			{
+			case DecorationBlock: target.block = true; break;
+			case DecorationBufferBlock: target.bufferBlock = true; break;
+			case DecorationArrayStride: target.arrayStride = value; break;
+			case DecorationBuiltIn: target.builtIn = true; break;
+			case DecorationLocation: target.location = value; break;
+			case DecorationBinding: target.binding = value; break;
+			case DecorationDescriptorSet: target.set = value; break;
+			}
+			break;
+		}
+
+		case OpMemberDecorate:
+		{
+			if (wordCount < 4)
+				throw std::runtime_error("Invalid SPIR-V, truncated instruction");
+
+			SpirvId &target = decorated(operands[0]);
+			uint32_t value = wordCount > 4 ? operands[3] : 0;
+
+			if (target.members.size() <= operands[1])
+				target.members.resize(operands[1] + 1);
+
+			if (operands[2] == DecorationOffset)
+				target.members[operands[1]].offset = value;
+			else if (operands[2] == DecorationMatrixStride)
+				target.members[operands[1]].matrixStride = value;
+			break;
+		}
+
+		case OpTypeBool:
+		case OpTypeInt:
+		case OpTypeFloat:
+		case OpTypeVector:
+		case OpTypeMatrix:
+		case OpTypeImage:
+		case OpTypeSampler:
+		case OpTypeSampledImage:
+		case OpTypeArray:
+		case OpTypeRuntimeArray:
+		case OpTypeStruct:
+		case OpTypePointer:
+			// the operands past the result id are read through SpirvModule::Operand, which checks them
+			if (wordCount < 2)
+				throw std::runtime_error("Invalid SPIR-V, truncated instruction");
+
+			define(operands[0], opcode, word, wordCount);
+			break;
+
+		case OpConstant:
+		case OpSpecConstant:
+			if (wordCount < 4)
+				throw std::runtime_error("Invalid SPIR-V, truncated instruction");
+
+			// array lengths only need the low word, spec constants count with their default
+			define(operands[1], opcode, word, wordCount).constant = operands[2];
+			break;
+
+		case OpVariable:
+			// result type, result id and storage class
+			if (wordCount < 4)
+				throw std::runtime_error("Invalid SPIR-V, truncated instruction");
+
+			define(operands[1], opcode, word, wordCount);
+			variables.push_back(operands[1]);
+			break;
+		}
+
+		word += wordCount;
+	}
+
+	if (!hasEntryPoint)
+		throw std::runtime_error("Invalid SPIR-V, no entry point");
+
+	for (uint32_t variableId : variables)
+	{
+		const SpirvId &variable = module.Get(variableId);
+		const SpirvId &pointer = module.Get(module.Operand(variable, 1));
+
+		if (pointer.opcode != OpTypePointer)
+			throw std::runtime_error("Invalid SPIR-V, variable is not a pointer");
+
+		uint32_t storageClass = module.Operand(variable, 3);
+		uint32_t typeId = module.Operand(pointer, 3);
+
+		if (storageClass == StorageClassPushConstant)
+		{
+			const SpirvId &type = module.Get(typeId);
+
+			uint32_t offset = Unset;
+			for (const SpirvMember &member : type.members)
+				offset = std::min(offset, member.offset);
+
+			pushConstants.stageFlags = stage;
+			pushConstants.offset = offset == Unset ? 0 : offset;
+			pushConstants.size = module.SizeOf(typeId, 0) - pushConstants.offset;
+			continue;
+		}
+
+		if (storageClass == StorageClassInput && stage == VK_SHADER_STAGE_VERTEX_BIT)
+		{
+			if (variable.builtIn || variable.location == Unset)
+				continue;
+
+			const SpirvId* type = &module.Get(typeId);
+			uint32_t locations = 1;
+
+			if (type->opcode == OpTypeMatrix)
+			{
+				locations = module.Operand(*type, 3);
+				type = &module.Get(module.Operand(*type, 2));
+			}
+
+			VkFormat format = VK_FORMAT_UNDEFINED;
+
+			if (type->opcode == OpTypeVector || type->opcode == OpTypeInt || type->opcode == OpTypeFloat)
+			{
+				uint32_t componentCount = type->opcode == OpTypeVector ? module.Operand(*type, 3) : 1;
+				const SpirvId &component = type->opcode == OpTypeVector ? module.Get(module.Operand(*type, 2)) : *type;
+
+				if (component.opcode == OpTypeInt || component.opcode == OpTypeFloat)
+				{
+					uint32_t signedness = component.opcode == OpTypeInt ? module.Operand(component, 3) : 1;
+					format = VertexFormat(component.opcode, signedness, module.Operand(component, 2), componentCount);
+				}
+			}
+
+			for (uint32_t i = 0; i < locations; i++)
+				vertexInputs.push_back({ variable.location + i, format });
+
+			continue;
+		}
+
+		if (storageClass != StorageClassUniformConstant && storageClass != StorageClassUniform && storageClass != StorageClassStorageBuffer)
+			continue;
+
+		if (variable.set == Unset || variable.binding == Unset)
+			continue;
+
+		ReflectedBinding binding;
+		binding.set = variable.set;
+		binding.binding = variable.binding;
+		binding.count = 1;
+		binding.stages = stage;
+
+		const SpirvId* type = &module.Get(typeId);
+
+		while (type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray)
+		{
+			binding.count = type->opcode == OpTypeArray ? binding.count * module.Get(module.Operand(*type, 3)).constant : 0;
+			type = &module.Get(module.Operand(*type, 2));
+		}
+
+		switch (type->opcode)
+		{
+		case OpTypeSampler:
+			binding.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+			break;
+		case OpTypeSampledImage:
+			binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			break;
+		case OpTypeImage:
+		{
+			uint32_t dim = module.Operand(*type, 3);
+			uint32_t sampled = module.Operand(*type, 7);
+
+			if (dim == DimBuffer)
+				binding.type = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			else if (dim == DimSubpassData)
+				binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			else
+				binding.type = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			break;
+		}
+		case OpTypeStruct:
+			// BufferBlock is how SPIR-V 1.0 spells a storage buffer in the Uniform class
+			binding.type = storageClass == StorageClassStorageBuffer || type->bufferBlock
+				? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+				: VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			break;
+		default:
+			throw std::runtime_error("Unsupported descriptor type in SPIR-V");
+		}
+
+		bindings.push_back(binding);
+	}
+
+	std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding &a, const ReflectedBinding &b)
+	{
+		return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+	});
+
+	std::sort(vertexInputs.begin(), vertexInputs.end(), [](const ReflectedVertexInput &a, const ReflectedVertexInput &b)
+	{
+		return a.location < b.location;
+	});
+}
\ No newline at end of file
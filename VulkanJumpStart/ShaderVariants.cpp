@@ -0,0 +1,182 @@
+#include "ShaderVariants.h"
+
+#include <assert.h>
+
+ShaderVariants::ShaderVariants()
+{
+}
+
+ShaderVariants::~ShaderVariants()
+{
+	Destroy();
+}
+
+void ShaderVariants::Create(PipelineRegistry &registry, const PipelineDesc &baseDesc, const char* name)
+{
+	this->registry = &registry;
+	this->baseDesc = baseDesc;
+	this->name = name;
+	this->keyBits = 0;
+	this->defaultKey = 0;
+}
+
+void ShaderVariants::Destroy()
+{
+	// the registry owns the pipelines
+	std::lock_guard<std::mutex> lock(mutex);
+
+	pipelines.clear();
+	options.clear();
+}
+
+uint32_t ShaderVariants::AddToggle(const char* name, uint32_t constantId, VkShaderStageFlags stages, bool defaultValue)
+{
+	// VkBool32, which is what a GLSL bool specialization constant reads
+	return AddValues(name, constantId, stages, { VK_FALSE, VK_TRUE }, defaultValue ? 1 : 0);
+}
+
+uint32_t ShaderVariants::AddLevels(const char* name, uint32_t constantId, VkShaderStageFlags stages, uint32_t levelCount, uint32_t defaultLevel)
+{
+	std::vector<uint32_t> values(levelCount);
+	for (uint32_t level = 0; level < levelCount; level++)
+		values[level] = level;
+
+	return AddValues(name, constantId, stages, values, defaultLevel);
+}
+
+uint32_t ShaderVariants::AddValues(const char* name, uint32_t constantId, VkShaderStageFlags stages, const std::vector<uint32_t> &values, uint32_t defaultIndex)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	assert(pipelines.empty());
+
+	if (values.empty() || defaultIndex >= values.size())
+		throw std::runtime_error(std::string("Invalid shader variant option ") + name);
+
+	for (const Option &option : options)
+	{
+		if (option.constantId == constantId && (option.stages & stages))
+			throw std::runtime_error(std::string("Shader variant option ") + name + " reuses constant of " + option.name);
+	}
+
+	Option option;
+	option.name = name;
+	option.constantId = constantId;
+	option.stages = stages;
+	option.values = values;
+	option.bitOffset = keyBits;
+	option.bitCount = 0;
+
+	while ((1ull << option.bitCount) < values.size())
+		option.bitCount++;
+
+	if (keyBits + option.bitCount > sizeof(Key) * 8)
+		throw std::runtime_error("Too many shader variant options for " + this->name);
+
+	keyBits += option.bitCount;
+	defaultKey |= (Key)defaultIndex << option.bitOffset;
+
+	options.push_back(std::move(option));
+	return (uint32_t)options.size() - 1;
+}
+
+uint32_t ShaderVariants::FindOption(const char* name) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (uint32_t i = 0; i < options.size(); i++)
+	{
+		if (options[i].name == name)
+			return i;
+	}
+
+	throw std::runtime_error("Unknown shader variant option " + std::string(name) + " of " + this->name);
+}
+
+ShaderVariants::Key ShaderVariants::Set(Key key, uint32_t option, uint32_t valueIndex) const
+{
+	assert(option < options.size() && valueIndex < options[option].values.size());
+
+	const Option &entry = options[option];
+	Key mask = ((1ull << entry.bitCount) - 1) << entry.bitOffset;
+
+	return (key & ~mask) | ((Key)valueIndex << entry.bitOffset);
+}
+
+uint32_t ShaderVariants::GetValueIndex(Key key, uint32_t option) const
+{
+	assert(option < options.size());
+
+	const Option &entry = options[option];
+	return (uint32_t)((key >> entry.bitOffset) & ((1ull << entry.bitCount) - 1));
+}
+
+const AsyncPipeline& ShaderVariants::Get(Key key, VkPipeline fallback)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = pipelines.find(key);
+	if (it != pipelines.end())
+	{
+		if (fallback != VK_NULL_HANDLE && !it->second.IsReady())
+			it->second.SetFallback(fallback);
+
+		return it->second;
+	}
+
+	// identical variants of other sets still meet in the registry
+	AsyncPipeline pipeline = registry->Get(Specialize(key), fallback);
+
+	return pipelines.emplace(key, pipeline).first->second;
+}
+
+void ShaderVariants::Update()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto &entry : pipelines)
+		entry.second.Update();
+}
+
+uint64_t ShaderVariants::GetVariantCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint64_t count = 1;
+	for (const Option &option : options)
+		count *= option.values.size();
+
+	return count;
+}
+
+void ShaderVariants::PrintStats(std::ostream &stream) const
+{
+	uint64_t variantCount = GetVariantCount();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint32_t ready = 0;
+	for (const auto &entry : pipelines)
+		ready += entry.second.IsReady() ? 1 : 0;
+
+	stream << "shader variants " << name << ": " << pipelines.size() << " of " << variantCount << " requested"
+		<< ", " << ready << " ready" << std::endl;
+}
+
+PipelineDesc ShaderVariants::Specialize(Key key) const
+{
+	PipelineDesc desc = baseDesc;
+
+	for (uint32_t i = 0; i < options.size(); i++)
+	{
+		const Option &option = options[i];
+		uint32_t valueIndex = GetValueIndex(key, i);
+
+		if (valueIndex >= option.values.size())
+			throw std::runtime_error("Invalid shader variant key for " + name);
+
+		desc.SetSpecialization(option.stages, option.constantId, &option.values[valueIndex], sizeof(uint32_t));
+	}
+
+	return desc;
+}
\ No newline at end of file
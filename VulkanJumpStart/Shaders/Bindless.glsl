@@ -0,0 +1,27 @@
+#ifndef BINDLESS_GLSL
+#define BINDLESS_GLSL
+
+// Shader side of BindlessHeap, include after picking the set it is bound to:
+//   #define BINDLESS_SET 0
+//   #include "Bindless.glsl"
+// Indices come from BindlessHeap::AddTexture/AddBuffer, usually through push constants
+// or a per-draw storage buffer. Indices that differ within a draw must be nonuniform.
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+#ifndef BINDLESS_SET
+#define BINDLESS_SET 0
+#endif
+
+// must match BindlessHeap::TextureBinding and BindlessHeap::BufferBinding
+layout(set = BINDLESS_SET, binding = 0) uniform sampler2D bindlessTextures[];
+
+#define BINDLESS_TEXTURE(index) bindlessTextures[nonuniformEXT(index)]
+
+// storage buffers are declared per element type, one alias of binding 1 each
+#define BINDLESS_BUFFER(Name, Type) \
+	layout(set = BINDLESS_SET, binding = 1) readonly buffer Name##Block { Type items[]; } Name[]
+
+#define BINDLESS_LOAD(Name, index, element) Name[nonuniformEXT(index)].items[element]
+
+#endif // !BINDLESS_GLSL
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 450
+
+// Scene objects, drawn through the draw list with their column-major world matrix as
+// per-instance data. The scene is laid out in clip space, see Scene.
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in mat4 transform;
+
+layout(location = 0) out vec3 color;
+
+void main()
+{
+	gl_Position = transform * vec4(position, 1.0);
+	color = position * 0.5 + 0.5;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 450
+
+// GPU culled instances. The instance buffer is bound per instance and firstInstance is the
+// instance's own index, so the sphere read here is the one the culling pass tested.
+
+layout(location = 0) in vec3 position;
+
+// GpuCulling::Instance::sphere, the cube's corners touch the sphere
+layout(location = 1) in vec4 sphere;
+
+layout(location = 0) out vec3 color;
+
+void main()
+{
+	gl_Position = vec4(sphere.xyz + position * (sphere.w / sqrt(3.0)), 1.0);
+	color = position * 0.25 + 0.75;
+}
\ No newline at end of file
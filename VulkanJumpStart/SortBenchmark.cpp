@@ -0,0 +1,98 @@
+#include "Benchmarks.h"
+
+#include <chrono>
+#include <algorithm>
+
+#include "DrawList.h"
+
+static uint64_t NextRandom(uint64_t &state)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+// Keys spread like a real frame: few layers and passes, a few hundred pipelines and
+// a few thousand materials, random depth. std::stable_sort is the reference.
+static void RunSortBenchmark(std::ostream &stream, JobSystem &jobSystem, uint32_t drawCount)
+{
+	const uint32_t runs = 10;
+
+	DrawList drawList;
+	drawList.Reserve(drawCount);
+
+	std::vector<uint64_t> keys(drawCount);
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+
+	for (uint64_t &key : keys)
+	{
+		uint64_t random = NextRandom(state);
+
+		key = DrawList::MakeOpaqueKey(
+			(uint32_t)(random & 1),
+			(uint32_t)((random >> 1) & 3),
+			(uint32_t)((random >> 8) % 300),
+			(uint32_t)((random >> 24) % 5000),
+			(uint32_t)((random >> 40) & DrawList::MaxDepth));
+	}
+
+	DrawList::Draw draw = {};
+	double radixSeconds = 0.0;
+	bool sorted = true;
+
+	for (uint32_t run = 0; run < runs; run++)
+	{
+		drawList.Clear();
+		for (uint64_t key : keys)
+			drawList.Add(key, draw);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		drawList.Sort(jobSystem);
+		radixSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		const DrawList::SortItem* items = drawList.GetSortedItems();
+		for (uint32_t i = 1; i < drawCount && sorted; i++)
+			sorted = items[i - 1].key <= items[i].key;
+	}
+
+	std::vector<DrawList::SortItem> reference(drawCount);
+	double referenceSeconds = 0.0;
+
+	for (uint32_t run = 0; run < runs; run++)
+	{
+		for (uint32_t i = 0; i < drawCount; i++)
+			reference[i] = { keys[i], i };
+
+		auto start = std::chrono::high_resolution_clock::now();
+		std::stable_sort(reference.begin(), reference.end(), [](const DrawList::SortItem &a, const DrawList::SortItem &b)
+		{
+			return a.key < b.key;
+		});
+		referenceSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	stream << drawCount << " draws: radix "
+		<< 1000.0 * radixSeconds / runs << " ms, "
+		<< (double)drawCount * runs / radixSeconds / 1e6 << " Mkeys/s"
+		<< ", std::stable_sort " << 1000.0 * referenceSeconds / runs << " ms"
+		<< (sorted ? "" : ", NOT SORTED") << std::endl;
+}
+
+void RunSortBenchmark(std::ostream &stream)
+{
+	uint32_t workerCount = std::thread::hardware_concurrency();
+	if (workerCount == 0)
+		workerCount = 1;
+
+	JobSystem jobSystem;
+	jobSystem.Create(workerCount, true);
+
+	stream << "draw sort: " << workerCount << " workers" << std::endl;
+
+	const uint32_t drawCounts[] = { 100000, 250000, 500000, 1000000 };
+	for (uint32_t drawCount : drawCounts)
+		RunSortBenchmark(stream, jobSystem, drawCount);
+
+	jobSystem.Destroy();
+}
\ No newline at end of file
@@ -0,0 +1,348 @@
+#include "Swapchain.h"
+
+#include <algorithm>
+
+static const char* PresentModeName(VkPresentModeKHR presentMode)
+{
+	switch (presentMode)
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:
+		return "immediate";
+	case VK_PRESENT_MODE_MAILBOX_KHR:
+		return "mailbox";
+	case VK_PRESENT_MODE_FIFO_KHR:
+		return "fifo";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+		return "fifo relaxed";
+	default:
+		return "unknown";
+	}
+}
+
+Swapchain::Swapchain()
+{
+}
+
+Swapchain::~Swapchain()
+{
+	Destroy();
+}
+
+void Swapchain::Create(Window &window, FrameRing &frameRing, FramePacer &framePacer, VkPresentModeKHR presentMode, uint32_t imageCount)
+{
+	if (!vkfwIsDeviceExtensionEnabled(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+		throw std::runtime_error("Failed to create swapchain, VK_KHR_swapchain is not supported");
+
+	this->window = &window;
+	this->frameRing = &frameRing;
+	this->framePacer = &framePacer;
+	requestedPresentMode = presentMode;
+	requestedImageCount = imageCount;
+
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	VkWin32SurfaceCreateInfoKHR surfaceInfo = {};
+	surfaceInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+	surfaceInfo.pNext = nullptr;
+	surfaceInfo.flags = 0;
+	surfaceInfo.hinstance = window.GetInstance();
+	surfaceInfo.hwnd = window.GetHandle();
+
+	if (vkCreateWin32SurfaceKHR(Vulkan.instance, &surfaceInfo, nullptr, &surface) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create window surface");
+#else
+	throw std::runtime_error("Failed to create window surface, no surface support for this platform");
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+	// the graphics queue presents, a separate present queue is not worth the ownership transfers
+	VkBool32 supported = VK_FALSE;
+	vkGetPhysicalDeviceSurfaceSupportKHR(Vulkan.physicalDevice, Vulkan.graphicsQueueFamilyIndex, surface, &supported);
+
+	if (!supported)
+		throw std::runtime_error("Failed to create swapchain, the graphics queue cannot present to the window");
+
+	uint32_t formatCount;
+	vkGetPhysicalDeviceSurfaceFormatsKHR(Vulkan.physicalDevice, surface, &formatCount, nullptr);
+
+	std::vector<VkSurfaceFormatKHR> formats(formatCount);
+	vkGetPhysicalDeviceSurfaceFormatsKHR(Vulkan.physicalDevice, surface, &formatCount, formats.data());
+
+	if (formats.empty())
+		throw std::runtime_error("Failed to create swapchain, the surface has no formats");
+
+	// a lone undefined format leaves the choice to us
+	format = formats[0];
+
+	if (formats.size() == 1 && formats[0].format == VK_FORMAT_UNDEFINED)
+		format.format = VK_FORMAT_B8G8R8A8_UNORM;
+
+	for (const VkSurfaceFormatKHR &candidate : formats)
+	{
+		if (candidate.format == VK_FORMAT_B8G8R8A8_UNORM && candidate.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+			format = candidate;
+	}
+
+	Recreate();
+}
+
+void Swapchain::Destroy()
+{
+	for (VkImageView view : views)
+		vkDestroyImageView(Vulkan.device, view, nullptr);
+
+	views.clear();
+	images.clear();
+
+	if (swapchain != VK_NULL_HANDLE)
+	{
+		vkDestroySwapchainKHR(Vulkan.device, swapchain, nullptr);
+		swapchain = VK_NULL_HANDLE;
+	}
+
+	if (surface != VK_NULL_HANDLE)
+	{
+		vkDestroySurfaceKHR(Vulkan.instance, surface, nullptr);
+		surface = VK_NULL_HANDLE;
+	}
+}
+
+bool Swapchain::Recreate()
+{
+	VkSurfaceCapabilitiesKHR capabilities;
+	if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(Vulkan.physicalDevice, surface, &capabilities) != VK_SUCCESS)
+		throw std::runtime_error("Failed to get surface capabilities");
+
+	// the surface either dictates the extent or takes the window's
+	VkExtent2D newExtent = capabilities.currentExtent;
+
+	if (newExtent.width == UINT32_MAX)
+	{
+		newExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, window->GetWidth()));
+		newExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, window->GetHeight()));
+	}
+
+	// minimized, the old swapchain is kept for when the window comes back
+	if (newExtent.width == 0 || newExtent.height == 0)
+		return false;
+
+	uint32_t modeCount;
+	vkGetPhysicalDeviceSurfacePresentModesKHR(Vulkan.physicalDevice, surface, &modeCount, nullptr);
+
+	std::vector<VkPresentModeKHR> modes(modeCount);
+	vkGetPhysicalDeviceSurfacePresentModesKHR(Vulkan.physicalDevice, surface, &modeCount, modes.data());
+
+	// immediate falls back to mailbox, which never waits for the display either, and
+	// everything ends up at FIFO
+	VkPresentModeKHR candidates[] = { requestedPresentMode, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+	uint32_t firstFallback = requestedPresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR ? 1 : 2;
+
+	presentMode = VK_PRESENT_MODE_FIFO_KHR;
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (i > 0 && i < firstFallback)
+			continue;
+
+		if (std::find(modes.begin(), modes.end(), candidates[i]) != modes.end())
+		{
+			presentMode = candidates[i];
+			break;
+		}
+	}
+
+	// one image on screen and one per frame in flight, mailbox also keeps one queued
+	uint32_t imageCount = requestedImageCount;
+
+	if (imageCount == 0)
+		imageCount = frameRing->GetFrameCount() + (presentMode == VK_PRESENT_MODE_MAILBOX_KHR ? 2 : 1);
+
+	imageCount = std::max(imageCount, capabilities.minImageCount);
+
+	if (capabilities.maxImageCount > 0)
+		imageCount = std::min(imageCount, capabilities.maxImageCount);
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+	if (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+		usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	VkCompositeAlphaFlagBitsKHR compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+
+	if (!(capabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR))
+		compositeAlpha = (VkCompositeAlphaFlagBitsKHR)(capabilities.supportedCompositeAlpha & ~(capabilities.supportedCompositeAlpha - 1));
+
+	VkSwapchainCreateInfoKHR createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.surface = surface;
+	createInfo.minImageCount = imageCount;
+	createInfo.imageFormat = format.format;
+	createInfo.imageColorSpace = format.colorSpace;
+	createInfo.imageExtent = newExtent;
+	createInfo.imageArrayLayers = 1;
+	createInfo.imageUsage = usage;
+	createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	createInfo.queueFamilyIndexCount = 0;
+	createInfo.pQueueFamilyIndices = nullptr;
+	createInfo.preTransform = capabilities.currentTransform;
+	createInfo.compositeAlpha = compositeAlpha;
+	createInfo.presentMode = presentMode;
+	createInfo.clipped = VK_TRUE;
+	createInfo.oldSwapchain = swapchain;
+
+	VkSwapchainKHR newSwapchain;
+	if (vkCreateSwapchainKHR(Vulkan.device, &createInfo, nullptr, &newSwapchain) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create swapchain");
+
+	// frames in flight may still draw to or present the old images, they go once the
+	// frame being recorded has completed, and every earlier one with it
+	if (swapchain != VK_NULL_HANDLE)
+	{
+		VkSwapchainKHR oldSwapchain = swapchain;
+		std::vector<VkImageView> oldViews = views;
+
+		framePacer->OnSwapchainRetired(oldSwapchain);
+
+		frameRing->Defer([oldSwapchain, oldViews]()
+		{
+			for (VkImageView view : oldViews)
+				vkDestroyImageView(Vulkan.device, view, nullptr);
+
+			vkDestroySwapchainKHR(Vulkan.device, oldSwapchain, nullptr);
+		});
+
+		stats.recreations++;
+	}
+
+	swapchain = newSwapchain;
+	extent = newExtent;
+
+	uint32_t count;
+	vkGetSwapchainImagesKHR(Vulkan.device, swapchain, &count, nullptr);
+
+	images.resize(count);
+	vkGetSwapchainImagesKHR(Vulkan.device, swapchain, &count, images.data());
+
+	views.assign(count, VK_NULL_HANDLE);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.pNext = nullptr;
+		viewInfo.flags = 0;
+		viewInfo.image = images[i];
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format.format;
+		viewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(Vulkan.device, &viewInfo, nullptr, &views[i]) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create swapchain image view");
+	}
+
+	imageIndex = 0;
+	stale = false;
+
+	return true;
+}
+
+bool Swapchain::Acquire(const FrameRing::FrameContext &context)
+{
+	if (window->ConsumeResize())
+		stale = true;
+
+	if ((stale || swapchain == VK_NULL_HANDLE) && !Recreate())
+	{
+		stats.skippedFrames++;
+		return false;
+	}
+
+	// a swapchain going out of date in between gets one more try
+	for (uint32_t attempt = 0; attempt < 2; attempt++)
+	{
+		VkResult result = vkAcquireNextImageKHR(Vulkan.device, swapchain, UINT64_MAX, context.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+
+		if (result == VK_SUCCESS)
+			return true;
+
+		// still presentable, the image is ours and the semaphore will be signalled
+		if (result == VK_SUBOPTIMAL_KHR)
+		{
+			stats.suboptimal++;
+			stale = true;
+			return true;
+		}
+
+		if (result != VK_ERROR_OUT_OF_DATE_KHR)
+			throw std::runtime_error("Failed to acquire swapchain image");
+
+		stats.outOfDate++;
+
+		if (!Recreate())
+			break;
+	}
+
+	stats.skippedFrames++;
+	return false;
+}
+
+RenderGraph::Resource Swapchain::Import(RenderGraph &graph)
+{
+	RenderGraph::ImageDesc desc;
+	desc.format = format.format;
+	desc.width = extent.width;
+	desc.height = extent.height;
+
+	return graph.ImportImage("backbuffer", images[imageIndex], views[imageIndex], desc, RenderGraph::UsageNone, RenderGraph::UsagePresent);
+}
+
+void Swapchain::Present(const FrameRing::FrameContext &context, uint64_t presentId)
+{
+	VkPresentIdKHR presentIdInfo = {};
+	presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+	presentIdInfo.pNext = nullptr;
+	presentIdInfo.swapchainCount = 1;
+	presentIdInfo.pPresentIds = &presentId;
+
+	VkPresentInfoKHR presentInfo = {};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.pNext = presentId != 0 ? &presentIdInfo : nullptr;
+	presentInfo.waitSemaphoreCount = 1;
+	presentInfo.pWaitSemaphores = &context.renderFinished;
+	presentInfo.swapchainCount = 1;
+	presentInfo.pSwapchains = &swapchain;
+	presentInfo.pImageIndices = &imageIndex;
+	presentInfo.pResults = nullptr;
+
+	VkResult result = vkQueuePresentKHR(Vulkan.graphicsQueue, &presentInfo);
+
+	// both recreate before the next acquire
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		stats.outOfDate++;
+		stale = true;
+	}
+	else if (result == VK_SUBOPTIMAL_KHR)
+	{
+		stats.suboptimal++;
+		stale = true;
+	}
+	else if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to present swapchain image");
+	}
+}
+
+void Swapchain::PrintStats(std::ostream &stream) const
+{
+	stream << "swapchain: " << PresentModeName(presentMode) << ", " << images.size() << " images, "
+		<< extent.width << "x" << extent.height
+		<< ", recreated " << stats.recreations << " times"
+		<< ", " << stats.outOfDate << " out of date, " << stats.suboptimal << " suboptimal"
+		<< ", " << stats.skippedFrames << " frames skipped" << std::endl;
+}
\ No newline at end of file
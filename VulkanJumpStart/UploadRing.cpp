@@ -0,0 +1,67 @@
+#include "UploadRing.h"
+
+#include <assert.h>
+
+UploadRing::UploadRing()
+{
+}
+
+UploadRing::~UploadRing()
+{
+	Destroy();
+}
+
+void UploadRing::Create(VkDeviceSize sizePerFrame, uint32_t frameCount, VkBufferUsageFlags usage)
+{
+	assert(sizePerFrame > 0 && frameCount > 0);
+
+	this->sizePerFrame = sizePerFrame;
+	this->frameCount = frameCount;
+
+	// coherent memory saves flushing every allocation before submit
+	buffer.Create(sizePerFrame * frameCount, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	BeginFrame(0);
+}
+
+void UploadRing::Destroy()
+{
+	buffer.Destroy();
+
+	sizePerFrame = 0;
+	frameCount = 0;
+	frameBegin = 0;
+	head.store(0, std::memory_order_relaxed);
+}
+
+void UploadRing::BeginFrame(uint32_t frameIndex)
+{
+	assert(frameIndex < frameCount);
+
+	frameBegin = sizePerFrame * frameIndex;
+	head.store(frameBegin, std::memory_order_relaxed);
+}
+
+UploadRing::Allocation UploadRing::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	VkDeviceSize frameEnd = frameBegin + sizePerFrame;
+	VkDeviceSize current = head.load(std::memory_order_relaxed);
+	VkDeviceSize offset;
+
+	do
+	{
+		offset = (current + alignment - 1) & ~(alignment - 1);
+
+		if (offset + size > frameEnd)
+			throw std::runtime_error("Upload ring frame region exhausted");
+	}
+	while (!head.compare_exchange_weak(current, offset + size, std::memory_order_relaxed));
+
+	Allocation allocation;
+	allocation.buffer = buffer.GetBuffer();
+	allocation.offset = offset;
+	allocation.data = (uint8_t*)buffer.GetMapped() + offset;
+	return allocation;
+}
\ No newline at end of file
@@ -1,6 +1,11 @@
 #include "VKFW.h"
 
 #include <assert.h>
+#include <string.h>
+#include <fstream>
+#include <string>
+
+#include "Hash.h"
 
 VulkanContext Vulkan;
 
@@ -25,7 +30,14 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vkfwDebugCallback(
 
 void vkfwInit()
 {
-	Vulkan.LibHandle = LoadLibrary(L"vulkan-1.dll");
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	Vulkan.LibHandle = OSLoadLibrary("vulkan-1.dll");
+#else
+	Vulkan.LibHandle = OSLoadLibrary("libvulkan.so.1");
+#endif // VK_USE_PLATFORM_WIN32_KHR
+
+	if (Vulkan.LibHandle == nullptr)
+		throw std::runtime_error("Failed to load the Vulkan loader");
 
 	_loadExportedEntryPoints();
 	_loadGlobalLevelEntryPoints();
@@ -53,6 +65,113 @@ const char** vkfwGetRequiredInstanceLayers(uint32_t* layerCount)
 	return (const char**)Vulkan.validationLayers.data();
 }
 
+const char** vkfwGetDeviceExtensions(uint32_t* extensionCount)
+{
+	assert(extensionCount != nullptr);
+	*extensionCount = (uint32_t)Vulkan.deviceExtensions.size();
+	return Vulkan.deviceExtensions.data();
+}
+
+bool vkfwIsDeviceExtensionEnabled(const char* extensionName)
+{
+	for (const char* name : Vulkan.deviceExtensions)
+	{
+		if (!strcmp(name, extensionName))
+			return true;
+	}
+
+	return false;
+}
+
+bool vkfwIsInstanceExtensionEnabled(const char* extensionName)
+{
+	for (const char* name : Vulkan.extensions)
+	{
+		if (!strcmp(name, extensionName))
+			return true;
+	}
+
+	return false;
+}
+
+uint32_t vkfwFindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(Vulkan.physicalDevice, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			return i;
+	}
+
+	throw std::runtime_error("Failed to find a suitable memory type");
+}
+
+uint32_t vkfwFindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(Vulkan.physicalDevice, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & (properties | preferred)) == (properties | preferred))
+			return i;
+	}
+
+	return vkfwFindMemoryType(typeBits, properties);
+}
+
+std::vector<uint32_t> vkfwReadShaderCode(const char* path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file.is_open())
+		throw std::runtime_error(std::string("Failed to open shader ") + path);
+
+	size_t size = (size_t)file.tellg();
+
+	// SPIR-V is a stream of words, anything else is not a shader
+	if (size == 0 || size % 4 != 0)
+		throw std::runtime_error(std::string("Invalid shader ") + path);
+
+	std::vector<uint32_t> code(size / 4);
+
+	file.seekg(0);
+	file.read((char*)code.data(), size);
+
+	return code;
+}
+
+VkShaderModule vkfwCreateShaderModule(const std::vector<uint32_t> &code, uint64_t* codeHash)
+{
+	return vkfwCreateShaderModule(code.data(), code.size() * sizeof(uint32_t), codeHash);
+}
+
+VkShaderModule vkfwCreateShaderModule(const uint32_t* code, size_t codeSize, uint64_t* codeHash)
+{
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.codeSize = codeSize;
+	createInfo.pCode = code;
+
+	VkShaderModule module;
+	if (vkCreateShaderModule(Vulkan.device, &createInfo, nullptr, &module) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create shader module");
+
+	if (codeHash)
+		*codeHash = HashBytes(code, codeSize);
+
+	return module;
+}
+
+VkShaderModule vkfwLoadShaderModule(const char* path, uint64_t* codeHash)
+{
+	return vkfwCreateShaderModule(vkfwReadShaderCode(path), codeHash);
+}
+
 void _loadExportedEntryPoints()
 {
 #define VK_EXPORTED_FUNCTION( FUNC )														\
@@ -128,11 +247,89 @@ void _loadRequiredInstanceLayers()
 
 void _loadRequiredInstanceExtensions()
 {
-	Vulkan.extensions.push_back("VK_KHR_surface");
+	if (!Vulkan.headless)
+		Vulkan.extensions.push_back("VK_KHR_surface");
 #ifdef VKFW_ENABLE_VALIDATION_LAYERS
 	Vulkan.extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
 #endif
 #ifdef WIN32
-	Vulkan.extensions.push_back("VK_KHR_win32_surface");
+	if (!Vulkan.headless)
+		Vulkan.extensions.push_back("VK_KHR_win32_surface");
 #endif
+
+	// optional extensions, enabled whenever the loader supports them
+	const char* optionalExtensions[] = {
+		VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
+	};
+
+	uint32_t extensionCount;
+	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> properties(extensionCount);
+	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, properties.data());
+
+	for (const char* extensionName : optionalExtensions)
+	{
+		for (const VkExtensionProperties &prop : properties)
+		{
+			if (!strcmp(prop.extensionName, extensionName))
+			{
+				Vulkan.extensions.push_back((char*)extensionName);
+				break;
+			}
+		}
+	}
+}
+
+void _loadDeviceExtensions()
+{
+	struct OptionalExtension
+	{
+		const char* name;
+		bool needsProperties2;
+	};
+
+	// optional extensions, enabled whenever the selected device supports them
+	const OptionalExtension optionalExtensions[] = {
+		{ VK_KHR_MAINTENANCE1_EXTENSION_NAME, false },
+		{ VK_KHR_MAINTENANCE3_EXTENSION_NAME, false },
+		{ VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, true },
+		{ VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME, false },
+		{ VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, true },
+		{ VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, false },
+		{ VK_AMD_DRAW_INDIRECT_COUNT_EXTENSION_NAME, false },
+		{ VK_KHR_SWAPCHAIN_EXTENSION_NAME, false },
+		{ VK_KHR_PRESENT_ID_EXTENSION_NAME, true },
+		{ VK_KHR_PRESENT_WAIT_EXTENSION_NAME, true },
+	};
+
+	bool hasProperties2 = vkfwIsInstanceExtensionEnabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(Vulkan.physicalDevice, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> properties(extensionCount);
+	vkEnumerateDeviceExtensionProperties(Vulkan.physicalDevice, nullptr, &extensionCount, properties.data());
+
+	Vulkan.deviceExtensions.clear();
+
+	for (const OptionalExtension &extension : optionalExtensions)
+	{
+		// these depend on VK_KHR_get_physical_device_properties2 being enabled on the instance
+		if (extension.needsProperties2 && !hasProperties2)
+			continue;
+
+		// descriptor indexing requires maintenance3 to be enabled alongside it
+		if (!strcmp(extension.name, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) && !vkfwIsDeviceExtensionEnabled(VK_KHR_MAINTENANCE3_EXTENSION_NAME))
+			continue;
+
+		for (const VkExtensionProperties &prop : properties)
+		{
+			if (!strcmp(prop.extensionName, extension.name))
+			{
+				Vulkan.deviceExtensions.push_back(extension.name);
+				break;
+			}
+		}
+	}
 }
\ No newline at end of file
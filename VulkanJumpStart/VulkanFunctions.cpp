@@ -1,4 +1,5 @@
 #include "vulkan.h"
+#include "VulkanExtensions.h"
 
 #define VK_EXPORTED_FUNCTION( FUNC ) PFN_##FUNC FUNC;
 #define VK_GLOBAL_LEVEL_FUNCTION( FUNC ) PFN_##FUNC FUNC;
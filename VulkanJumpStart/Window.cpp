@@ -12,6 +12,10 @@ HWND hWnd;
 HICON hIcon, hIconSm;
 HCURSOR hCursor;
 
+// kept up to date by WM_SIZE
+uint32_t clientWidth, clientHeight;
+bool resized;
+
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 
 Window::Window()
@@ -43,6 +47,13 @@ HRESULT Window::Create()
 	if (err)
 		return err;
 
+	RECT clientRect;
+	GetClientRect(hWnd, &clientRect);
+
+	clientWidth = (uint32_t)(clientRect.right - clientRect.left);
+	clientHeight = (uint32_t)(clientRect.bottom - clientRect.top);
+	resized = false;
+
 	ShowWindow(hWnd, SW_SHOW);
 	UpdateWindow(hWnd);
 
@@ -96,8 +107,68 @@ HRESULT Window::FuncCreateWindow()
 	return S_OK;
 }
 
+bool Window::ProcessMessages()
+{
+	MSG msg;
+
+	while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+	{
+		if (msg.message == WM_QUIT)
+			return false;
+
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+
+	return true;
+}
+
+HWND Window::GetHandle() const
+{
+	return hWnd;
+}
+
+HINSTANCE Window::GetInstance() const
+{
+	return hInstance;
+}
+
+uint32_t Window::GetWidth() const
+{
+	return clientWidth;
+}
+
+uint32_t Window::GetHeight() const
+{
+	return clientHeight;
+}
+
+bool Window::ConsumeResize()
+{
+	bool result = resized;
+	resized = false;
+	return result;
+}
+
 LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+	switch (msg)
+	{
+	case WM_DESTROY:
+		PostQuitMessage(0);
+		return 0;
+
+	case WM_SIZE:
+		// a minimized window reports 0 by 0
+		if (LOWORD(lParam) != clientWidth || HIWORD(lParam) != clientHeight)
+		{
+			clientWidth = LOWORD(lParam);
+			clientHeight = HIWORD(lParam);
+			resized = true;
+		}
+		return 0;
+	}
+
 	return DefWindowProc(hWnd, msg, wParam, lParam);
 }
 
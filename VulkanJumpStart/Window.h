@@ -1,6 +1,8 @@
 #ifndef WINDOW_HEADER
 #define WINDOW_HEADER
 
+#include <stdint.h>
+
 #ifndef HRESULT
 #include <Windows.h>
 #endif // !HRESULT
@@ -14,6 +16,19 @@ public:
 	HRESULT Create();
 	void Destroy();
 
+	// pumps pending window messages, returns false once the window was closed
+	bool ProcessMessages();
+
+	HWND GetHandle() const;
+	HINSTANCE GetInstance() const;
+
+	// client area size in pixels, 0 by 0 while minimized
+	uint32_t GetWidth() const;
+	uint32_t GetHeight() const;
+
+	// true once after each change of the client area size
+	bool ConsumeResize();
+
 private:
 	HRESULT FuncRegisterClass();
 	HRESULT FuncCreateWindow();